@@ -0,0 +1,86 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "base32.h"
+
+/*
+ * @returns The 5 bit value of the character or -1 if it is not a Base32 digit.
+ */
+static int8_t _value(char character)
+{
+    if (character >= 0x41 && character <= 0x5A)
+    {
+        return character - 0x41;
+    }
+    else if (character >= 0x61 && character <= 0x7A)
+    {
+        return character - 0x61;
+    }
+    else if (character >= 0x32 && character <= 0x37)
+    {
+        return character - 0x32 + 26;
+    }
+
+    return -1;
+}
+
+void base32_decoder_init(struct base32_decoder *decoder, uint8_t *output, uint8_t capacity)
+{
+    decoder->buffer = 0;
+    decoder->bits = 0;
+    decoder->output = output;
+    decoder->length = 0;
+    decoder->capacity = capacity;
+    decoder->error = false;
+}
+
+bool base32_decoder_put(struct base32_decoder *decoder, char character)
+{
+    if (character == '=' || character == ' ')
+    {
+        return true;
+    }
+
+    int8_t value = _value(character);
+    if (value < 0)
+    {
+        decoder->error = true;
+        return false;
+    }
+
+    decoder->buffer = decoder->buffer << 5 | value;
+    decoder->bits += 5;
+    if (decoder->bits >= 8)
+    {
+        if (decoder->length == decoder->capacity)
+        {
+            decoder->error = true;
+            return false;
+        }
+        decoder->bits -= 8;
+        decoder->output[decoder->length++] = decoder->buffer >> decoder->bits;
+    }
+    // Only the bits not yet output are kept.
+    decoder->buffer &= (1 << decoder->bits) - 1;
+
+    return true;
+}
+
+bool base32_is_digit(char character)
+{
+    return _value(character) >= 0;
+}
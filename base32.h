@@ -0,0 +1,57 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * A streaming RFC 4648 Base32 decoder.
+ *
+ * Characters are decoded one at a time as they arrive so a secret never needs
+ * to be held in its encoded form. Decoding is case insensitive, padding and
+ * the spaces some providers use to group the secret are skipped.
+ */
+
+#ifndef BASE32_H
+#define BASE32_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct base32_decoder
+{
+    uint16_t buffer; // Bits decoded but not yet output.
+    uint8_t bits;    // The number of bits in the buffer.
+    uint8_t *output;
+    uint8_t length;
+    uint8_t capacity;
+    bool error;      // An invalid character was seen or the output overflowed.
+};
+
+void base32_decoder_init(struct base32_decoder *decoder, uint8_t *output, uint8_t capacity);
+
+/*
+ * Decode a single character.
+ *
+ * @returns false if the character is not valid Base32 or the output is full,
+ *          the decoder error is also set.
+ */
+bool base32_decoder_put(struct base32_decoder *decoder, char character);
+
+/*
+ * @returns true if the character is one of the 32 Base32 digits.
+ */
+bool base32_is_digit(char character);
+
+#endif // BASE32_H
@@ -0,0 +1,67 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "pico/stdlib.h"
+
+#include "boot_profile.h"
+#include "otp_log.h"
+
+// Static lifetime so they can be passed to the deferred log.
+static const char *phase_names[BOOT_PHASE_COUNT] =
+{
+    "Board Init",
+    "USB Init",
+    "Components Init",
+    "Components Begin",
+    "Main Loop",
+    "USB Mounted",
+    "Flash Ready",
+    "Storage Mounted",
+    "Root Mounted",
+    "PIN Ready"
+};
+
+static uint32_t phase_times[BOOT_PHASE_COUNT];
+static uint32_t phases_reached;
+
+void boot_profile_mark(enum boot_phase phase)
+{
+    if (phase >= BOOT_PHASE_COUNT || phases_reached & 1u << phase)
+    {
+        return;
+    }
+
+    phase_times[phase] = time_us_32();
+    phases_reached |= 1u << phase;
+    OTP_LOG_INFO("Boot phase %s at %d us\n", phase_names[phase], phase_times[phase]);
+}
+
+bool boot_profile_get(enum boot_phase phase, uint32_t *time_us)
+{
+    if (phase >= BOOT_PHASE_COUNT || !(phases_reached & 1u << phase))
+    {
+        return false;
+    }
+
+    *time_us = phase_times[phase];
+    return true;
+}
+
+const char* boot_profile_name(enum boot_phase phase)
+{
+    return phase < BOOT_PHASE_COUNT ? phase_names[phase] : "Unknown";
+}
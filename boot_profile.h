@@ -0,0 +1,59 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Boot Profile records the time each phase of start up completes.
+ *
+ * Phases are marked once, the first time they are reached, and each is
+ * written to the log as it is marked. The times are microseconds since the
+ * timer started at reset.
+ */
+
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum boot_phase
+{
+    BOOT_PHASE_BOARD_INIT,
+    BOOT_PHASE_USB_INIT,
+    BOOT_PHASE_COMPONENTS_INIT,
+    BOOT_PHASE_COMPONENTS_BEGIN,
+    BOOT_PHASE_MAIN_LOOP,
+    BOOT_PHASE_USB_MOUNTED,
+    BOOT_PHASE_FLASH_READY,
+    BOOT_PHASE_STORAGE_MOUNTED,
+    BOOT_PHASE_ROOT_MOUNTED,
+    BOOT_PHASE_PIN_READY,
+    BOOT_PHASE_COUNT
+};
+
+/*
+ * Record the current time for the phase if it has not already been recorded.
+ */
+void boot_profile_mark(enum boot_phase phase);
+
+/*
+ * @returns true if the phase has been reached and time_us set.
+ */
+bool boot_profile_get(enum boot_phase phase, uint32_t *time_us);
+
+const char* boot_profile_name(enum boot_phase phase);
+
+#endif // BOOT_PROFILE_H
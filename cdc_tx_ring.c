@@ -0,0 +1,116 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "tusb.h"
+
+#include "cdc_tx_ring.h"
+#include "otp_hot_path.h"
+
+#define CDC_TX_RING_MASK (CDC_TX_RING_SIZE - 1)
+
+// A single producer and consumer, both in the main loop, so the free running
+// indexes need no locking.
+static char ring[CDC_TX_RING_SIZE];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+
+static struct cdc_tx_ring_stats ring_stats = { 0 };
+
+uint32_t cdc_tx_ring_free()
+{
+    return CDC_TX_RING_SIZE - (head - tail);
+}
+
+bool cdc_tx_ring_reserve(uint32_t length)
+{
+    if (cdc_tx_ring_free() < length)
+    {
+        ring_stats.full++;
+        return false;
+    }
+
+    return true;
+}
+
+// Called for every byte of every frame.
+void OTP_HOT_PATH(cdc_tx_ring_write_char)(char c)
+{
+    ring[head & CDC_TX_RING_MASK] = c;
+    head++;
+}
+
+void cdc_tx_ring_clear()
+{
+    tail = head;
+}
+
+bool cdc_tx_ring_empty()
+{
+    return head == tail;
+}
+
+void cdc_tx_ring_drain()
+{
+    bool written = false;
+    while (head != tail)
+    {
+        uint32_t available = tud_cdc_write_available();
+        if (available == 0)
+        {
+            // Called again once the TX complete callback reports space.
+            break;
+        }
+
+        // Write directly from the ring, at most twice if the data wraps.
+        uint32_t offset = tail & CDC_TX_RING_MASK;
+        uint32_t contiguous = CDC_TX_RING_SIZE - offset;
+        uint32_t pending = head - tail;
+        uint32_t length = pending < contiguous ? pending : contiguous;
+        length = length < available ? length : available;
+
+        uint32_t accepted = tud_cdc_write(&ring[offset], length);
+        if (accepted == 0)
+        {
+            break;
+        }
+        tail += accepted;
+        ring_stats.bytes += accepted;
+        written = true;
+    }
+
+    if (written)
+    {
+        tud_cdc_write_flush();
+    }
+}
+
+void cdc_tx_ring_get_stats(struct cdc_tx_ring_stats *stats)
+{
+    memcpy(stats, &ring_stats, sizeof(struct cdc_tx_ring_stats));
+}
+
+/*
+ * TinyUSB Callback
+ *
+ * Called from tud_task in the main loop as each transfer completes, no event is
+ * needed as otp_mgr_run drains the ring after tud_task returns.
+ */
+void tud_cdc_tx_complete_cb(uint8_t itf)
+{
+    ring_stats.transfers++;
+}
@@ -0,0 +1,74 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The CDC TX ring buffers terminal output until TinyUSB can accept it.
+ *
+ * Writers check for space before writing rather than blocking or dropping
+ * bytes, the ring is drained from the main loop straight into the TinyUSB
+ * CDC FIFO whenever it has room.
+ */
+
+#ifndef CDC_TX_RING_H
+#define CDC_TX_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Must be a power of 2.
+#define CDC_TX_RING_SIZE 4096
+
+struct cdc_tx_ring_stats
+{
+    uint64_t bytes;      // Total bytes passed to TinyUSB.
+    uint32_t transfers;  // Total completed USB transfers.
+    uint32_t full;       // Number of times a writer found insufficient space.
+};
+
+/*
+ * @returns The number of bytes which can currently be written.
+ */
+uint32_t cdc_tx_ring_free();
+
+/*
+ * Check there is space for length bytes, if not the caller should wait
+ * for the ring to drain.
+ */
+bool cdc_tx_ring_reserve(uint32_t length);
+
+/*
+ * Write a single byte, the caller must have already reserved space.
+ */
+void cdc_tx_ring_write_char(char c);
+
+/*
+ * Discard anything not yet passed to TinyUSB.
+ */
+void cdc_tx_ring_clear();
+
+/*
+ * @returns true if all data has been passed to TinyUSB.
+ */
+bool cdc_tx_ring_empty();
+
+/*
+ * Pass as much as possible to TinyUSB and flush, called from the main loop.
+ */
+void cdc_tx_ring_drain();
+
+void cdc_tx_ring_get_stats(struct cdc_tx_ring_stats *stats);
+
+#endif // CDC_TX_RING_H
@@ -0,0 +1,233 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <string.h>
+
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/stdlib.h"
+
+#include "clock_policy.h"
+#include "hardware_map.h"
+#include "otp_log.h"
+
+// The USB PLL always runs at 48 MHz for USB so costs nothing extra to use.
+#define CLOCK_POLICY_LOW_KHZ 48000
+
+#ifndef CLOCK_POLICY_HIGH_KHZ
+#define CLOCK_POLICY_HIGH_KHZ 133000
+#endif
+
+// Supply current is estimated as base + per MHz * clk_sys, the defaults are
+// rough figures for an RP2040 with the flash idle.
+#ifndef CLOCK_POLICY_BASE_UA
+#define CLOCK_POLICY_BASE_UA 1500
+#endif
+
+#ifndef CLOCK_POLICY_UA_PER_MHZ
+#define CLOCK_POLICY_UA_PER_MHZ 180
+#endif
+
+#ifndef CLOCK_POLICY_SUPPLY_MV
+#define CLOCK_POLICY_SUPPLY_MV 3300
+#endif
+
+// Static lifetime so they can be passed to the deferred log.
+static const char *operation_names[CLOCK_OP_COUNT] =
+{
+    "KDF",
+    "OTP Batch",
+    "Flash"
+};
+
+// A single clock so the policy state is global, only used from the main loop.
+static struct
+{
+    bool initialised;
+    bool high;
+    uint32_t level_since_us;
+    uint32_t vco_freq;
+    uint post_div1;
+    uint post_div2;
+    uint spi_baudrate; // Requested once so rounding at the low clock does not accumulate.
+    uint8_t held[CLOCK_OP_COUNT];
+    uint32_t start_us[CLOCK_OP_COUNT];
+    struct clock_policy_stats stats;
+} policy;
+
+static uint32_t _energy_uj(uint32_t khz, uint32_t us)
+{
+    // mV * uA is nW, nW * us is fJ.
+    uint64_t ua = CLOCK_POLICY_BASE_UA + (uint64_t) CLOCK_POLICY_UA_PER_MHZ * khz / 1000;
+    return (uint64_t) CLOCK_POLICY_SUPPLY_MV * ua * us / 1000000000;
+}
+
+static void _account_level(uint32_t now_us)
+{
+    uint32_t elapsed_us = now_us - policy.level_since_us;
+    if (policy.high)
+    {
+        policy.stats.high_us += elapsed_us;
+    }
+    else
+    {
+        policy.stats.low_us += elapsed_us;
+    }
+    policy.level_since_us = now_us;
+}
+
+static void _set_clock(bool high)
+{
+    uint32_t from_khz = policy.stats.khz;
+    uint32_t start_us = time_us_32();
+    // The switch itself is counted at the new frequency.
+    _account_level(start_us);
+
+    // Anything already queued for stdio goes out at the old divider.
+    uart_tx_wait_blocking(uart_default);
+    uint32_t interrupts = save_and_disable_interrupts();
+    if (high)
+    {
+        // Parks clk_sys on the USB PLL whilst the system PLL relocks then moves
+        // clk_peri along with clk_sys.
+        set_sys_clock_pll(policy.vco_freq, policy.post_div1, policy.post_div2);
+        policy.stats.khz = CLOCK_POLICY_HIGH_KHZ;
+    }
+    else
+    {
+        clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+            CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, CLOCK_POLICY_LOW_KHZ * KHZ, CLOCK_POLICY_LOW_KHZ * KHZ);
+        clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS,
+            CLOCK_POLICY_LOW_KHZ * KHZ, CLOCK_POLICY_LOW_KHZ * KHZ);
+        // Nothing else runs from the system PLL, it is restarted by the next boost.
+        pll_deinit(pll_sys);
+        policy.stats.khz = CLOCK_POLICY_LOW_KHZ;
+    }
+    spi_set_baudrate(FLASH_SPI_BANK, policy.spi_baudrate);
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+    restore_interrupts(interrupts);
+
+    policy.high = high;
+    uint32_t end_us = time_us_32();
+    uint32_t latency_us = end_us - start_us;
+    policy.stats.transitions++;
+    policy.stats.last_transition_us = latency_us;
+    if (latency_us > policy.stats.max_transition_us)
+    {
+        policy.stats.max_transition_us = latency_us;
+    }
+    OTP_LOG_INFO("Clock %d kHz to %d kHz in %d us\n", from_khz, policy.stats.khz, latency_us);
+}
+
+void clock_policy_init()
+{
+    // Boosts taken before now are already counted in held.
+    policy.stats.khz = clock_get_hz(clk_sys) / KHZ;
+    policy.high = true;
+    policy.level_since_us = time_us_32();
+
+    if (!check_sys_clock_khz(CLOCK_POLICY_HIGH_KHZ, &policy.vco_freq, &policy.post_div1, &policy.post_div2))
+    {
+        OTP_LOG_ERROR("No PLL settings for %d kHz, clock policy disabled.\n", CLOCK_POLICY_HIGH_KHZ);
+        return;
+    }
+
+    // The ADC and RTC are not used.
+    clock_stop(clk_adc);
+    clock_stop(clk_rtc);
+
+    policy.spi_baudrate = spi_get_baudrate(FLASH_SPI_BANK);
+    policy.initialised = true;
+
+    // Start up continues boosted, the first idle pass drops the clock.
+    _set_clock(true);
+}
+
+void clock_policy_boost(enum clock_policy_operation operation)
+{
+    if (operation >= CLOCK_OP_COUNT)
+    {
+        return;
+    }
+
+    if (policy.held[operation]++ == 0)
+    {
+        policy.start_us[operation] = time_us_32();
+    }
+
+    if (policy.initialised && !policy.high)
+    {
+        _set_clock(true);
+    }
+}
+
+void clock_policy_release(enum clock_policy_operation operation)
+{
+    if (operation >= CLOCK_OP_COUNT || policy.held[operation] == 0 || --policy.held[operation] > 0)
+    {
+        return;
+    }
+
+    uint32_t elapsed_us = time_us_32() - policy.start_us[operation];
+    uint32_t energy_uj = _energy_uj(policy.stats.khz, elapsed_us);
+    // The same cycles at the low clock, to see what the boost costs or saves.
+    uint32_t low_uj = _energy_uj(CLOCK_POLICY_LOW_KHZ,
+        (uint64_t) elapsed_us * policy.stats.khz / CLOCK_POLICY_LOW_KHZ);
+
+    struct clock_policy_operation_stats *stats = &policy.stats.operations[operation];
+    stats->count++;
+    stats->last_us = elapsed_us;
+    stats->last_uj = energy_uj;
+    stats->total_us += elapsed_us;
+    stats->total_uj += energy_uj;
+
+    OTP_LOG_INFO("Clock %s %d us at %d kHz, about %d uJ (%d uJ unboosted)\n", operation_names[operation],
+        elapsed_us, policy.stats.khz, energy_uj, low_uj);
+}
+
+void clock_policy_idle()
+{
+    if (!policy.initialised || !policy.high)
+    {
+        return;
+    }
+
+    for (int i = 0; i < CLOCK_OP_COUNT; i++)
+    {
+        if (policy.held[i] > 0)
+        {
+            return;
+        }
+    }
+
+    _set_clock(false);
+}
+
+void clock_policy_get_stats(struct clock_policy_stats *stats)
+{
+    _account_level(time_us_32());
+    memcpy(stats, &policy.stats, sizeof(struct clock_policy_stats));
+}
+
+const char* clock_policy_operation_name(enum clock_policy_operation operation)
+{
+    return operation < CLOCK_OP_COUNT ? operation_names[operation] : "Unknown";
+}
@@ -0,0 +1,93 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * Clock Policy runs clk_sys from the USB PLL at 48 MHz whenever the main loop
+ * is idle and boosts it from the system PLL for work which is compute or bus
+ * bound, deriving a PIN, calculating a batch of codes or streaming the flash.
+ *
+ * Operations hold a boost from begin to end and may overlap, the clock is
+ * raised on the first boost but only dropped once the main loop is about to
+ * wait with nothing held so back to back work does not relock the PLL.
+ *
+ * clk_peri follows clk_sys so the flash SPI and stdio UART dividers are
+ * recalculated on every change. Each change and each operation is logged with
+ * an energy estimate from a simple linear current model, the constants can be
+ * set for the board being measured.
+ */
+
+#ifndef CLOCK_POLICY_H
+#define CLOCK_POLICY_H
+
+#include <stdint.h>
+
+enum clock_policy_operation
+{
+    CLOCK_OP_KDF,
+    CLOCK_OP_OTP_BATCH,
+    CLOCK_OP_FLASH,
+    CLOCK_OP_COUNT
+};
+
+struct clock_policy_operation_stats
+{
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t last_uj;  // Estimated energy of the last operation.
+    uint64_t total_us;
+    uint64_t total_uj;
+};
+
+struct clock_policy_stats
+{
+    uint32_t khz; // The current clk_sys frequency.
+    uint32_t transitions;
+    uint32_t last_transition_us;
+    uint32_t max_transition_us;
+    uint64_t low_us;  // Time spent at each frequency.
+    uint64_t high_us;
+    struct clock_policy_operation_stats operations[CLOCK_OP_COUNT];
+};
+
+/*
+ * Stop the unused peripheral clocks, capture the flash SPI baud rate and move
+ * to the boost frequency, called once the components are initialised.
+ */
+void clock_policy_init();
+
+/*
+ * Raise the clock for the operation, calls may be nested.
+ */
+void clock_policy_boost(enum clock_policy_operation operation);
+
+/*
+ * Release a boost, the clock stays up until clock_policy_idle.
+ */
+void clock_policy_release(enum clock_policy_operation operation);
+
+/*
+ * Drop the clock if no operation is holding a boost, called by the main loop
+ * before it waits for the next event.
+ */
+void clock_policy_idle();
+
+void clock_policy_get_stats(struct clock_policy_stats *stats);
+
+const char* clock_policy_operation_name(enum clock_policy_operation operation);
+
+#endif // CLOCK_POLICY_H
@@ -0,0 +1,205 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "credential_index.h"
+#include "otp_log.h"
+
+#define CREDENTIAL_INDEX_CONTEXT_ID 0xB6
+
+struct index_entry
+{
+    const char *name;
+    uint64_t trigrams; // A bit per trigram hash, see _trigrams.
+    uint8_t credential;
+};
+
+struct credential_index
+{
+    char id;
+    uint16_t capacity;
+    uint16_t count;
+    struct index_entry *entries; // In name order.
+};
+
+static inline char _fold(char c)
+{
+    return c >= 0x41 && c <= 0x5A ? c + 0x20 : c;
+}
+
+static uint64_t _trigrams(const char *str)
+{
+    uint64_t trigrams = 0;
+    for (const char *pos = str; pos[0] != 0x00 && pos[1] != 0x00 && pos[2] != 0x00; pos++)
+    {
+        uint32_t hash = (_fold(pos[0]) << 16) ^ (_fold(pos[1]) << 8) ^ _fold(pos[2]);
+        // Fibonacci hashing, the top 6 bits select one of the 64.
+        trigrams |= 1ULL << ((hash * 0x9E3779B1) >> 26);
+    }
+
+    return trigrams;
+}
+
+/*
+ * Compare the name with the query, only up to the length of the query when prefix is true.
+ */
+static int _compare(const char *name, const char *query, bool prefix)
+{
+    for (;; name++, query++)
+    {
+        if (prefix && *query == 0x00)
+        {
+            return 0;
+        }
+
+        int difference = _fold(*name) - _fold(*query);
+        if (difference != 0 || *name == 0x00)
+        {
+            return difference;
+        }
+    }
+}
+
+static bool _contains(const char *name, const char *query, uint8_t query_length)
+{
+    uint32_t name_length = strlen(name);
+    for (uint32_t i = 0; i + query_length <= name_length; i++)
+    {
+        if (_compare(&name[i], query, true) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * @returns The position of the first entry not less than the query.
+ */
+static uint16_t _lower_bound(struct credential_index *credential_index, const char *query, bool prefix)
+{
+    uint16_t low = 0;
+    uint16_t high = credential_index->count;
+    while (low < high)
+    {
+        uint16_t middle = (low + high) / 2;
+        if (_compare(credential_index->entries[middle].name, query, prefix) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+credential_index_t* credential_index_init(uint16_t capacity)
+{
+    struct credential_index *credential_index = malloc(sizeof(struct credential_index));
+    credential_index->id = CREDENTIAL_INDEX_CONTEXT_ID;
+    credential_index->capacity = capacity;
+    credential_index->count = 0;
+    credential_index->entries = malloc(capacity * sizeof(struct index_entry));
+
+    return credential_index;
+}
+
+void credential_index_clear(credential_index_t *credential_index)
+{
+    credential_index->count = 0;
+}
+
+bool credential_index_add(credential_index_t *credential_index, uint8_t credential, const char *name)
+{
+    if (credential_index->id != CREDENTIAL_INDEX_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to credential_index_add 0x%02x\n", credential_index->id);
+        return false;
+    }
+
+    if (credential_index->count >= credential_index->capacity)
+    {
+        return false;
+    }
+
+    // Adding is rare compared to searching so keep the entries sorted here.
+    uint16_t position = _lower_bound(credential_index, name, false);
+    struct index_entry *entries = credential_index->entries;
+    memmove(&entries[position + 1], &entries[position],
+        (credential_index->count - position) * sizeof(struct index_entry));
+    entries[position].name = name;
+    entries[position].trigrams = _trigrams(name);
+    entries[position].credential = credential;
+    credential_index->count++;
+
+    return true;
+}
+
+uint16_t credential_index_search(credential_index_t *credential_index, const char *query,
+    uint8_t *results, uint16_t max_results)
+{
+    if (credential_index->id != CREDENTIAL_INDEX_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to credential_index_search 0x%02x\n", credential_index->id);
+        return 0;
+    }
+
+    struct index_entry *entries = credential_index->entries;
+    uint16_t found = 0;
+
+    // Prefix matches are a contiguous run of the sorted entries.
+    uint16_t first = _lower_bound(credential_index, query, true);
+    uint16_t last = first;
+    while (last < credential_index->count && _compare(entries[last].name, query, true) == 0)
+    {
+        if (found < max_results)
+        {
+            results[found++] = entries[last].credential;
+        }
+        last++;
+    }
+
+    // Then any other names containing the query, the signature of the query
+    // must be a subset of the signature of the name.
+    uint8_t query_length = strlen(query);
+    uint64_t trigrams = _trigrams(query);
+    for (uint16_t i = 0; i < credential_index->count && found < max_results; i++)
+    {
+        if (i == first)
+        {
+            // Already included.
+            i = last;
+            if (i >= credential_index->count)
+            {
+                break;
+            }
+        }
+
+        if ((entries[i].trigrams & trigrams) == trigrams && _contains(entries[i].name, query, query_length))
+        {
+            results[found++] = entries[i].credential;
+        }
+    }
+
+    return found;
+}
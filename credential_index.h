@@ -0,0 +1,64 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The credential index supports search as you type over credential names.
+ *
+ * Credentials are held in name order so prefix matches are found with a binary
+ * search, for substring matches each name has a 64 bit signature of its
+ * trigrams which rejects most names before any characters are compared.
+ * Matching is case insensitive.
+ */
+
+#ifndef CREDENTIAL_INDEX_H
+#define CREDENTIAL_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct credential_index credential_index_t;
+
+/*
+ * Allocate and initialise a new, empty, credential index.
+ */
+credential_index_t* credential_index_init(uint16_t capacity);
+
+void credential_index_clear(credential_index_t *credential_index);
+
+/*
+ * Add a credential to the index.
+ *
+ * @param credential The position of the credential in the credential table.
+ * @param name The name of the credential, this is referenced by the index so must
+ *             remain valid until the index is cleared.
+ * @returns false if the index is full.
+ */
+bool credential_index_add(credential_index_t *credential_index, uint8_t credential, const char *name);
+
+/*
+ * Find the credentials with names containing the query, names starting with
+ * the query are returned first, each group in name order.
+ *
+ * An empty query matches every credential.
+ *
+ * @param results Set to the matching credential positions.
+ * @returns The number of results, at most max_results.
+ */
+uint16_t credential_index_search(credential_index_t *credential_index, const char *query,
+    uint8_t *results, uint16_t max_results);
+
+#endif // CREDENTIAL_INDEX_H
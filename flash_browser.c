@@ -0,0 +1,350 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock_policy.h"
+#include "flash_device.h"
+#include "flash_browser.h"
+#include "otp_log.h"
+
+#define FLASH_BROWSER_CONTEXT_ID 0xB5
+
+// The current page, the pages either side and one spare for a jump.
+#define FLASH_BROWSER_CACHE_PAGES 4
+#define FLASH_BROWSER_SEARCH_CHUNK 1024
+
+struct cached_page
+{
+    uint32_t address;
+    bool valid;
+    uint8_t data[FLASH_BROWSER_PAGE_SIZE];
+};
+
+struct flash_browser
+{
+    char id;
+    otp_core_t *otp_core;
+    uint32_t flash_size;
+    uint32_t position; // The address of the page last requested.
+    struct cached_page pages[FLASH_BROWSER_CACHE_PAGES];
+    // Search
+    uint8_t search_state; // enum flash_browser_search
+    uint8_t pattern[FLASH_BROWSER_MAX_PATTERN];
+    uint8_t pattern_length;
+    uint32_t search_address; // The next address to read.
+    uint32_t match_address;
+    uint8_t carry_length; // Bytes at the start of the buffer carried over from the previous chunk.
+    uint8_t search_buffer[FLASH_BROWSER_MAX_PATTERN - 1 + FLASH_BROWSER_SEARCH_CHUNK];
+};
+
+// Two characters for each byte value, indexed by byte * 2.
+#define _HEX_PAIRS(h) h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" \
+    h "8" h "9" h "A" h "B" h "C" h "D" h "E" h "F"
+static const char hex_pairs[] =
+    _HEX_PAIRS("0") _HEX_PAIRS("1") _HEX_PAIRS("2") _HEX_PAIRS("3")
+    _HEX_PAIRS("4") _HEX_PAIRS("5") _HEX_PAIRS("6") _HEX_PAIRS("7")
+    _HEX_PAIRS("8") _HEX_PAIRS("9") _HEX_PAIRS("A") _HEX_PAIRS("B")
+    _HEX_PAIRS("C") _HEX_PAIRS("D") _HEX_PAIRS("E") _HEX_PAIRS("F");
+
+flash_browser_t* flash_browser_init(otp_core_t *otp_core)
+{
+    struct flash_browser *flash_browser = malloc(sizeof(struct flash_browser));
+    flash_browser->id = FLASH_BROWSER_CONTEXT_ID;
+    flash_browser->otp_core = otp_core;
+    // The flash may not be available yet, the size is read by flash_browser_reset.
+    flash_browser->flash_size = FLASH_DEVICE_DEFAULT_SIZE;
+    flash_browser->position = 0;
+    for (int i = 0; i < FLASH_BROWSER_CACHE_PAGES; i++)
+    {
+        flash_browser->pages[i].valid = false;
+    }
+    flash_browser->search_state = FLASH_BROWSER_SEARCH_IDLE;
+
+    return flash_browser;
+}
+
+void flash_browser_reset(flash_browser_t *flash_browser)
+{
+    if (flash_browser->id != FLASH_BROWSER_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to flash_browser_reset 0x%02x\n", flash_browser->id);
+        return;
+    }
+
+    for (int i = 0; i < FLASH_BROWSER_CACHE_PAGES; i++)
+    {
+        flash_browser->pages[i].valid = false;
+    }
+    flash_browser_search_cancel(flash_browser);
+
+    flash_browser->flash_size = pico_otp_flash_size(flash_browser->otp_core);
+}
+
+uint32_t flash_browser_flash_size(flash_browser_t *flash_browser)
+{
+    return flash_browser->flash_size;
+}
+
+uint32_t flash_browser_clamp(flash_browser_t *flash_browser, int64_t address)
+{
+    int64_t last = flash_browser->flash_size - FLASH_BROWSER_PAGE_SIZE;
+    return address < 0 ? 0 : address > last ? last : address;
+}
+
+static struct cached_page* _find_page(struct flash_browser *flash_browser, uint32_t address)
+{
+    for (int i = 0; i < FLASH_BROWSER_CACHE_PAGES; i++)
+    {
+        if (flash_browser->pages[i].valid && flash_browser->pages[i].address == address)
+        {
+            return &flash_browser->pages[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool _wanted(struct flash_browser *flash_browser, uint32_t address)
+{
+    uint32_t position = flash_browser->position;
+    return address == position || address == position + FLASH_BROWSER_PAGE_SIZE ||
+        address + FLASH_BROWSER_PAGE_SIZE == position;
+}
+
+static struct cached_page* _read_page(struct flash_browser *flash_browser, uint32_t address)
+{
+    // With three pages wanted at most there is always one to replace.
+    struct cached_page *page = &flash_browser->pages[0];
+    for (int i = 0; i < FLASH_BROWSER_CACHE_PAGES; i++)
+    {
+        page = &flash_browser->pages[i];
+        if (!page->valid || !_wanted(flash_browser, page->address))
+        {
+            break;
+        }
+    }
+
+    pico_otp_flash_read_data(flash_browser->otp_core, address, page->data, FLASH_BROWSER_PAGE_SIZE);
+    page->address = address;
+    page->valid = true;
+
+    return page;
+}
+
+const uint8_t* flash_browser_page(flash_browser_t *flash_browser, uint32_t address)
+{
+    if (flash_browser->id != FLASH_BROWSER_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to flash_browser_page 0x%02x\n", flash_browser->id);
+        return NULL;
+    }
+
+    flash_browser->position = address;
+    struct cached_page *page = _find_page(flash_browser, address);
+    if (page == NULL)
+    {
+        page = _read_page(flash_browser, address);
+    }
+
+    return page->data;
+}
+
+bool flash_browser_search_start(flash_browser_t *flash_browser, const uint8_t *pattern,
+    uint8_t pattern_length, uint32_t address)
+{
+    if (pattern_length == 0 || pattern_length > FLASH_BROWSER_MAX_PATTERN)
+    {
+        return false;
+    }
+
+    flash_browser_search_cancel(flash_browser);
+    memcpy(flash_browser->pattern, pattern, pattern_length);
+    flash_browser->pattern_length = pattern_length;
+    flash_browser->search_address = address;
+    flash_browser->carry_length = 0;
+    flash_browser->search_state = address < flash_browser->flash_size ?
+        FLASH_BROWSER_SEARCH_RUNNING : FLASH_BROWSER_SEARCH_NOT_FOUND;
+    if (flash_browser->search_state == FLASH_BROWSER_SEARCH_RUNNING)
+    {
+        clock_policy_boost(CLOCK_OP_FLASH);
+    }
+
+    return true;
+}
+
+/*
+ * Leave the running state, releasing the boost held whilst searching.
+ */
+static void _search_finished(struct flash_browser *flash_browser, enum flash_browser_search state)
+{
+    if (flash_browser->search_state == FLASH_BROWSER_SEARCH_RUNNING)
+    {
+        clock_policy_release(CLOCK_OP_FLASH);
+    }
+    flash_browser->search_state = state;
+}
+
+void flash_browser_search_cancel(flash_browser_t *flash_browser)
+{
+    _search_finished(flash_browser, FLASH_BROWSER_SEARCH_IDLE);
+}
+
+enum flash_browser_search flash_browser_search_status(flash_browser_t *flash_browser, uint32_t *address)
+{
+    *address = flash_browser->search_state == FLASH_BROWSER_SEARCH_FOUND ?
+        flash_browser->match_address : flash_browser->search_address;
+
+    return flash_browser->search_state;
+}
+
+static void _search_chunk(struct flash_browser *flash_browser)
+{
+    uint32_t remaining = flash_browser->flash_size - flash_browser->search_address;
+    uint32_t length = remaining < FLASH_BROWSER_SEARCH_CHUNK ? remaining : FLASH_BROWSER_SEARCH_CHUNK;
+    uint8_t *buffer = flash_browser->search_buffer;
+    uint8_t carry_length = flash_browser->carry_length;
+
+    pico_otp_flash_read_data(flash_browser->otp_core, flash_browser->search_address,
+        &buffer[carry_length], length);
+
+    // The buffer holds the tail of the previous chunk followed by this chunk so
+    // matches spanning the two are found.
+    uint32_t total = carry_length + length;
+    uint8_t *pattern = flash_browser->pattern;
+    uint8_t pattern_length = flash_browser->pattern_length;
+    if (total >= pattern_length)
+    {
+        uint8_t *candidate = buffer;
+        uint8_t *last = &buffer[total - pattern_length];
+        while (candidate <= last &&
+            (candidate = memchr(candidate, pattern[0], last - candidate + 1)) != NULL)
+        {
+            if (memcmp(candidate, pattern, pattern_length) == 0)
+            {
+                flash_browser->match_address = flash_browser->search_address - carry_length + (candidate - buffer);
+                _search_finished(flash_browser, FLASH_BROWSER_SEARCH_FOUND);
+                return;
+            }
+            candidate++;
+        }
+    }
+
+    uint8_t keep = pattern_length - 1;
+    if (keep > total)
+    {
+        keep = total;
+    }
+    memmove(buffer, &buffer[total - keep], keep);
+    flash_browser->carry_length = keep;
+
+    flash_browser->search_address += length;
+    if (flash_browser->search_address >= flash_browser->flash_size)
+    {
+        _search_finished(flash_browser, FLASH_BROWSER_SEARCH_NOT_FOUND);
+    }
+}
+
+bool flash_browser_run(flash_browser_t *flash_browser)
+{
+    if (flash_browser->id != FLASH_BROWSER_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to flash_browser_run 0x%02x\n", flash_browser->id);
+        return false;
+    }
+
+    // Read ahead takes priority, the next page is the most likely request.
+    uint32_t position = flash_browser->position;
+    uint32_t neighbours[2] = { position + FLASH_BROWSER_PAGE_SIZE, position - FLASH_BROWSER_PAGE_SIZE };
+    bool available[2] = { position + FLASH_BROWSER_PAGE_SIZE <= flash_browser->flash_size - FLASH_BROWSER_PAGE_SIZE,
+                          position >= FLASH_BROWSER_PAGE_SIZE };
+    bool read = false;
+    for (int i = 0; i < 2; i++)
+    {
+        if (available[i] && _find_page(flash_browser, neighbours[i]) == NULL)
+        {
+            if (read)
+            {
+                // One page per step, come back for the next.
+                return true;
+            }
+            _read_page(flash_browser, neighbours[i]);
+            read = true;
+        }
+    }
+
+    if (!read && flash_browser->search_state == FLASH_BROWSER_SEARCH_RUNNING)
+    {
+        _search_chunk(flash_browser);
+    }
+
+    return flash_browser->search_state == FLASH_BROWSER_SEARCH_RUNNING;
+}
+
+static inline char* _format_byte(char *line, uint8_t byte)
+{
+    memcpy(line, &hex_pairs[byte * 2], 2);
+    return line + 2;
+}
+
+void flash_browser_format_row(const uint8_t *data, uint32_t address, char *line)
+{
+    char *pos = line;
+    uint8_t address_bytes = flash_device_geometry()->address_bytes;
+    if (data != NULL)
+    {
+        for (int shift = (address_bytes - 1) * 8; shift >= 0; shift -= 8)
+        {
+            pos = _format_byte(pos, address >> shift);
+        }
+    }
+    else
+    {
+        memset(pos, '-', address_bytes * 2);
+        pos += address_bytes * 2;
+    }
+    *pos++ = ' ';
+    *pos++ = ' ';
+
+    for (int column = 0; column < FLASH_BROWSER_ROW_SIZE; column++)
+    {
+        if (data != NULL)
+        {
+            pos = _format_byte(pos, data[column]);
+        }
+        else
+        {
+            *pos++ = '-';
+            *pos++ = '-';
+        }
+        *pos++ = ' ';
+        if (column == 7)
+        {
+            *pos++ = ' ';
+        }
+    }
+
+    *pos++ = ' ';
+    *pos++ = '|';
+    for (int column = 0; column < FLASH_BROWSER_ROW_SIZE; column++)
+    {
+        uint8_t byte = data != NULL ? data[column] : 0x00;
+        *pos++ = byte >= 0x20 && byte <= 0x7E ? byte : '.';
+    }
+    *pos++ = '|';
+    *pos = 0x00;
+}
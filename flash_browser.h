@@ -0,0 +1,115 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The flash browser provides paged access to the flash for display.
+ *
+ * Pages are held in a small cache, when the main loop is otherwise idle the
+ * pages either side of the current position are read ahead so paging only
+ * waits for the terminal. The same idle time is used to search the whole chip
+ * for a pattern a chunk at a time.
+ */
+
+#ifndef FLASH_BROWSER_H
+#define FLASH_BROWSER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico_otp.h"
+
+#define FLASH_BROWSER_PAGE_SIZE 256
+#define FLASH_BROWSER_ROW_SIZE 16
+#define FLASH_BROWSER_MAX_PATTERN 16
+
+// Address, hex bytes and ASCII e.g. "000100  00 01 ... 0F  |................|", the
+// address is 6 digits or 8 for flash above 16 MiB.
+#define FLASH_BROWSER_ROW_LENGTH 78
+
+enum flash_browser_search
+{
+    FLASH_BROWSER_SEARCH_IDLE,
+    FLASH_BROWSER_SEARCH_RUNNING,
+    FLASH_BROWSER_SEARCH_FOUND,
+    FLASH_BROWSER_SEARCH_NOT_FOUND
+};
+
+typedef struct flash_browser flash_browser_t;
+
+/*
+ * Allocate and initialise a new flash browser.
+ */
+flash_browser_t* flash_browser_init(otp_core_t *otp_core);
+
+/*
+ * Prepare to browse, any cached pages or search are discarded as the flash may
+ * have been written to and the size of the flash is taken from the detected geometry.
+ */
+void flash_browser_reset(flash_browser_t *flash_browser);
+
+uint32_t flash_browser_flash_size(flash_browser_t *flash_browser);
+
+/*
+ * Clamp an address so a full page can be read from it.
+ */
+uint32_t flash_browser_clamp(flash_browser_t *flash_browser, int64_t address);
+
+/*
+ * Get the page starting at address, the page is read immediately if it has not
+ * been read ahead.
+ *
+ * The address becomes the current position, read ahead is relative to it.
+ *
+ * @returns FLASH_BROWSER_PAGE_SIZE bytes, valid until the next call.
+ */
+const uint8_t* flash_browser_page(flash_browser_t *flash_browser, uint32_t address);
+
+/*
+ * Begin searching for the pattern from the address to the end of the flash.
+ *
+ * @returns false if the pattern is empty or too long.
+ */
+bool flash_browser_search_start(flash_browser_t *flash_browser, const uint8_t *pattern,
+    uint8_t pattern_length, uint32_t address);
+
+/*
+ * Stop any search and return to FLASH_BROWSER_SEARCH_IDLE.
+ */
+void flash_browser_search_cancel(flash_browser_t *flash_browser);
+
+/*
+ * @param address Set to the match once found, otherwise the next address to be searched.
+ * @returns The current state of the search.
+ */
+enum flash_browser_search flash_browser_search_status(flash_browser_t *flash_browser, uint32_t *address);
+
+/*
+ * Perform a single step of background work, either reading ahead one page or
+ * searching one chunk.
+ *
+ * @returns true if background work remains.
+ */
+bool flash_browser_run(flash_browser_t *flash_browser);
+
+/*
+ * Format a row of the hex dump into line, which must hold FLASH_BROWSER_ROW_LENGTH + 1
+ * characters.
+ *
+ * If data is NULL a placeholder row is formatted.
+ */
+void flash_browser_format_row(const uint8_t *data, uint32_t address, char *line);
+
+#endif // FLASH_BROWSER_H
@@ -0,0 +1,347 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <string.h>
+
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+
+#include "flash_device.h"
+#include "otp_log.h"
+
+#define FLASH_READ_JEDEC_ID 0x9F
+#define FLASH_READ_SFDP 0x5A
+
+#define FLASH_WRITE_ENABLE 0x06
+#define FLASH_READ_STATUS_REGISTER_1 0x05
+
+#define FLASH_PAGE_PROGRAM 0x02
+#define FLASH_READ_DATA 0x03
+#define FLASH_FAST_READ 0x0B
+#define FLASH_SECTOR_ERASE 0x20
+#define FLASH_BLOCK_ERASE 0xD8
+#define FLASH_PAGE_PROGRAM_4B 0x12
+#define FLASH_READ_DATA_4B 0x13
+#define FLASH_FAST_READ_4B 0x0C
+#define FLASH_SECTOR_ERASE_4B 0x21
+#define FLASH_BLOCK_ERASE_4B 0xDC
+
+#define SFDP_SIGNATURE 0x50444653 // "SFDP"
+// Parameter IDs, MSB then LSB.
+#define SFDP_BFPT_ID 0xFF00
+#define SFDP_4BAIT_ID 0xFF84
+#define SFDP_MAX_HEADERS 8
+// DWORDs 1 to 9 are all that are used, later revisions only add to the end.
+#define SFDP_BFPT_DWORDS 9
+#define SFDP_ERASE_TYPES 4
+
+#define SIZE_16_MIB 0x1000000
+#define MAX_ERASE_BLOCK 0x10000
+#define PAGE_SIZE 256
+
+static const struct flash_geometry default_geometry =
+{
+    .size = FLASH_DEVICE_DEFAULT_SIZE,
+    .address_bytes = 3,
+    .sector_size = 4096,
+    .sector_erase_opcode = FLASH_SECTOR_ERASE,
+    .block_size = MAX_ERASE_BLOCK,
+    .block_erase_opcode = FLASH_BLOCK_ERASE,
+    .page_size = PAGE_SIZE,
+    .program_opcode = FLASH_PAGE_PROGRAM,
+    .read_opcode = FLASH_READ_DATA,
+    .fast_read_opcode = FLASH_FAST_READ,
+    .fast_read_dummy_bytes = 1,
+};
+
+static struct flash_geometry detected_geometry;
+static bool detected = false;
+
+static void _transfer(flash_context_t *flash_context, const uint8_t *command, uint8_t command_length,
+    void *data, uint32_t length)
+{
+    gpio_put(flash_context->cs_pin, false);
+    spi_write_blocking(flash_context->spi, command, command_length);
+    spi_read_blocking(flash_context->spi, 0x00, data, length);
+    gpio_put(flash_context->cs_pin, true);
+}
+
+static void _read_sfdp(flash_context_t *flash_context, uint32_t address, void *data, uint32_t length)
+{
+    // Always a 3 byte address followed by 8 dummy clocks.
+    uint8_t command[5] = { FLASH_READ_SFDP, address >> 16, address >> 8, address, 0x00 };
+    _transfer(flash_context, command, sizeof(command), data, length);
+}
+
+static inline uint32_t _pointer(const uint8_t *parameter_header)
+{
+    return parameter_header[4] | parameter_header[5] << 8 | parameter_header[6] << 16;
+}
+
+/*
+ * Choose the smallest erase as the sector and the largest up to 64 KiB as the
+ * block from the erase types of DWORDs 8 and 9.
+ *
+ * @returns the erase type index of the sector and block in the low and high nibble.
+ */
+static uint8_t _choose_erase(const uint32_t *bfpt, struct flash_geometry *geometry)
+{
+    int8_t sector_type = -1;
+    int8_t block_type = -1;
+    for (int type = 0; type < SFDP_ERASE_TYPES; type++)
+    {
+        uint16_t erase = bfpt[7 + type / 2] >> (type % 2 * 16);
+        uint8_t exponent = erase & 0xFF;
+        if (exponent == 0 || exponent > 16)
+        {
+            continue; // Not present or larger than a block.
+        }
+        uint32_t size = 1u << exponent;
+        if (sector_type < 0 || size < geometry->sector_size)
+        {
+            geometry->sector_size = size;
+            geometry->sector_erase_opcode = erase >> 8;
+            sector_type = type;
+        }
+        if (block_type < 0 || size > geometry->block_size)
+        {
+            geometry->block_size = size;
+            geometry->block_erase_opcode = erase >> 8;
+            block_type = type;
+        }
+    }
+
+    return (sector_type & 0x0F) | (block_type & 0x0F) << 4;
+}
+
+/*
+ * Switch to the 4 byte address opcodes, taken from the 4-byte Address Instruction
+ * Table if there is one, otherwise the opcodes common to Winbond, Macronix and Micron.
+ */
+static void _use_4_byte_opcodes(flash_context_t *flash_context, uint32_t table, uint8_t table_length,
+    uint8_t erase_types, struct flash_geometry *geometry)
+{
+    geometry->address_bytes = 4;
+    geometry->read_opcode = FLASH_READ_DATA_4B;
+    geometry->fast_read_opcode = FLASH_FAST_READ_4B;
+    geometry->sector_erase_opcode = FLASH_SECTOR_ERASE_4B;
+    geometry->block_erase_opcode = FLASH_BLOCK_ERASE_4B;
+    geometry->program_opcode = FLASH_PAGE_PROGRAM_4B;
+
+    if (table == 0 || table_length < 2 || erase_types == 0xFF)
+    {
+        return;
+    }
+
+    uint32_t ait[2];
+    _read_sfdp(flash_context, table, ait, sizeof(ait));
+    uint8_t sector_type = erase_types & 0x0F;
+    uint8_t block_type = erase_types >> 4;
+    // DWORD 1 flags support for each erase type from bit 9, DWORD 2 holds their opcodes.
+    if (ait[0] & 1u << (9 + sector_type))
+    {
+        geometry->sector_erase_opcode = ait[1] >> (sector_type * 8);
+    }
+    if (ait[0] & 1u << (9 + block_type))
+    {
+        geometry->block_erase_opcode = ait[1] >> (block_type * 8);
+    }
+}
+
+static bool _parse_sfdp(flash_context_t *flash_context, struct flash_geometry *geometry)
+{
+    uint8_t header[8];
+    _read_sfdp(flash_context, 0, header, sizeof(header));
+    uint32_t signature;
+    memcpy(&signature, header, sizeof(signature));
+    if (signature != SFDP_SIGNATURE)
+    {
+        return false;
+    }
+    geometry->sfdp_minor = header[4];
+    geometry->sfdp_major = header[5];
+
+    // The first header is always the mandatory BFPT, newer revisions of it
+    // may follow so the longest is used.
+    uint32_t bfpt_pointer = 0;
+    uint8_t bfpt_length = 0;
+    uint32_t ait_pointer = 0;
+    uint8_t ait_length = 0;
+    uint8_t headers = header[6] + 1 < SFDP_MAX_HEADERS ? header[6] + 1 : SFDP_MAX_HEADERS;
+    for (int i = 0; i < headers; i++)
+    {
+        uint8_t parameter_header[8];
+        _read_sfdp(flash_context, 8 + i * 8, parameter_header, sizeof(parameter_header));
+        uint16_t id = parameter_header[7] << 8 | parameter_header[0];
+        if (id == SFDP_BFPT_ID && parameter_header[3] > bfpt_length)
+        {
+            bfpt_pointer = _pointer(parameter_header);
+            bfpt_length = parameter_header[3];
+        }
+        else if (id == SFDP_4BAIT_ID)
+        {
+            ait_pointer = _pointer(parameter_header);
+            ait_length = parameter_header[3];
+        }
+    }
+    if (bfpt_length < 2)
+    {
+        return false;
+    }
+
+    uint32_t bfpt[SFDP_BFPT_DWORDS];
+    memset(bfpt, 0x00, sizeof(bfpt));
+    uint8_t dwords = bfpt_length < SFDP_BFPT_DWORDS ? bfpt_length : SFDP_BFPT_DWORDS;
+    _read_sfdp(flash_context, bfpt_pointer, bfpt, dwords * sizeof(uint32_t));
+
+    // DWORD 2, the density in bits, either N + 1 or 2^N with bit 31 set.
+    uint32_t density = bfpt[1] & 0x7FFFFFFF;
+    uint64_t bits = bfpt[1] & 0x80000000 ? (density < 64 ? 1ull << density : UINT64_MAX) : (uint64_t) density + 1;
+    geometry->size = bits / 8 > UINT32_MAX ? UINT32_MAX : bits / 8;
+
+    // DWORD 1, 4 KiB erase and the multi bit reads supported.
+    uint32_t dword1 = bfpt[0];
+    if ((dword1 & 0x03) == 0x01)
+    {
+        geometry->sector_size = 4096;
+        geometry->sector_erase_opcode = dword1 >> 8;
+    }
+    // DWORD 4 bits 15:8 and DWORD 3 bits 31:24.
+    geometry->dual_read_opcode = dword1 & 1u << 16 && dwords >= 4 ? bfpt[3] >> 8 : 0x00;
+    geometry->quad_read_opcode = dword1 & 1u << 22 && dwords >= 3 ? bfpt[2] >> 24 : 0x00;
+
+    uint8_t erase_types = 0xFF;
+    if (dwords >= 9)
+    {
+        erase_types = _choose_erase(bfpt, geometry);
+    }
+
+    // Bits 18:17, 3 byte only, 3 or 4 byte or 4 byte only.
+    uint8_t address_mode = (dword1 >> 17) & 0x03;
+    if (geometry->size > SIZE_16_MIB || address_mode == 0x02)
+    {
+        _use_4_byte_opcodes(flash_context, ait_pointer, ait_length, erase_types, geometry);
+    }
+
+    return true;
+}
+
+bool flash_device_detect(flash_context_t *flash_context)
+{
+    memcpy(&detected_geometry, &default_geometry, sizeof(struct flash_geometry));
+
+    uint8_t command = FLASH_READ_JEDEC_ID;
+    _transfer(flash_context, &command, 1, detected_geometry.jedec_id, sizeof(detected_geometry.jedec_id));
+
+    detected_geometry.sfdp = _parse_sfdp(flash_context, &detected_geometry);
+    if (!detected_geometry.sfdp)
+    {
+        // The capacity byte is log2 of the size for most parts.
+        uint8_t capacity = detected_geometry.jedec_id[2];
+        if (capacity >= 16 && capacity <= 31)
+        {
+            detected_geometry.size = 1u << capacity;
+        }
+        if (detected_geometry.size > SIZE_16_MIB)
+        {
+            _use_4_byte_opcodes(flash_context, 0, 0, 0xFF, &detected_geometry);
+        }
+    }
+    detected = true;
+
+    OTP_LOG_INFO("Flash %d KiB, %d byte addresses, SFDP=%d\n", detected_geometry.size / 1024, detected_geometry.address_bytes,
+        detected_geometry.sfdp);
+    OTP_LOG_INFO("Flash erase %d bytes 0x%02x, %d bytes 0x%02x\n", detected_geometry.sector_size,
+        detected_geometry.sector_erase_opcode, detected_geometry.block_size, detected_geometry.block_erase_opcode);
+
+    return detected_geometry.sfdp;
+}
+
+const struct flash_geometry* flash_device_geometry()
+{
+    return detected ? &detected_geometry : &default_geometry;
+}
+
+uint8_t flash_device_command(uint8_t *command, uint8_t opcode, uint32_t address)
+{
+    uint8_t length = 0;
+    command[length++] = opcode;
+    if (flash_device_geometry()->address_bytes == 4)
+    {
+        command[length++] = address >> 24;
+    }
+    command[length++] = address >> 16;
+    command[length++] = address >> 8;
+    command[length++] = address;
+
+    return length;
+}
+
+uint8_t flash_device_read_command(uint8_t *command, uint32_t address)
+{
+    const struct flash_geometry *current = flash_device_geometry();
+    uint8_t length = flash_device_command(command, current->fast_read_opcode, address);
+    for (int i = 0; i < current->fast_read_dummy_bytes; i++)
+    {
+        command[length++] = 0x00;
+    }
+
+    return length;
+}
+
+void flash_device_read(flash_context_t *flash_context, uint32_t address, void *data, uint32_t length)
+{
+    uint8_t command[FLASH_DEVICE_MAX_COMMAND];
+    uint8_t command_length = flash_device_read_command(command, address);
+    _transfer(flash_context, command, command_length, data, length);
+}
+
+void flash_device_program(flash_context_t *flash_context, uint32_t address, const void *data, uint32_t length)
+{
+    const struct flash_geometry *current = flash_device_geometry();
+    const uint8_t *source = data;
+    while (length > 0)
+    {
+        // Anything past the end of the page would wrap to its start.
+        uint32_t chunk = current->page_size - address % current->page_size;
+        chunk = chunk < length ? chunk : length;
+
+        uint8_t write_enable = FLASH_WRITE_ENABLE;
+        gpio_put(flash_context->cs_pin, false);
+        spi_write_blocking(flash_context->spi, &write_enable, 1);
+        gpio_put(flash_context->cs_pin, true);
+
+        uint8_t command[FLASH_DEVICE_MAX_COMMAND];
+        uint8_t command_length = flash_device_command(command, current->program_opcode, address);
+        gpio_put(flash_context->cs_pin, false);
+        spi_write_blocking(flash_context->spi, command, command_length);
+        spi_write_blocking(flash_context->spi, source, chunk);
+        gpio_put(flash_context->cs_pin, true);
+
+        uint8_t status;
+        uint8_t read_status = FLASH_READ_STATUS_REGISTER_1;
+        do
+        {
+            _transfer(flash_context, &read_status, 1, &status, 1);
+        } while (status & WB_STATUS_REGISTER_1_BUSY_MASK);
+
+        address += chunk;
+        source += chunk;
+        length -= chunk;
+    }
+}
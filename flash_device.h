@@ -0,0 +1,105 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * Flash Device describes the SPI NOR flash attached, detected at mount from
+ * the JEDEC ID and the SFDP (JESD216) Basic Flash Parameter Table.
+ *
+ * From the tables the capacity, the erase sizes and opcodes and the fast read
+ * opcodes are derived. Parts above 16 MiB are addressed with the dedicated
+ * 4 byte address opcodes, from the 4-byte Address Instruction Table where
+ * present, so the chip itself stays in 3 byte address mode and the security
+ * register and identification commands are unaffected.
+ *
+ * If the chip has no SFDP the geometry is derived from the JEDEC capacity
+ * byte with the common 4 KiB and 64 KiB erase opcodes. Until detection the
+ * geometry is that of the W25Q64.
+ */
+
+#ifndef FLASH_DEVICE_H
+#define FLASH_DEVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash/flash.h"
+
+#define FLASH_DEVICE_DEFAULT_SIZE 0x800000 // W25Q64, 8 MiB.
+// The largest command, opcode, 4 byte address and a dummy byte.
+#define FLASH_DEVICE_MAX_COMMAND 6
+
+struct flash_geometry
+{
+    uint8_t jedec_id[3];
+    bool sfdp; // Derived from SFDP rather than the JEDEC ID.
+    uint8_t sfdp_major;
+    uint8_t sfdp_minor;
+    uint32_t size;
+    uint8_t address_bytes; // 3 or 4.
+    // The smallest erase and the largest erase up to 64 KiB.
+    uint32_t sector_size;
+    uint8_t sector_erase_opcode;
+    uint32_t block_size;
+    uint8_t block_erase_opcode;
+    uint32_t page_size; // The largest program, which must not cross a page boundary.
+    uint8_t program_opcode;
+    // Single bit SPI, the only mode available on the SPI peripheral.
+    uint8_t read_opcode;
+    uint8_t fast_read_opcode;
+    uint8_t fast_read_dummy_bytes;
+    // Advertised multi-bit reads, 0x00 if not supported.
+    uint8_t dual_read_opcode;  // 1-1-2
+    uint8_t quad_read_opcode;  // 1-1-4
+};
+
+/*
+ * Read the JEDEC ID and SFDP tables, called once the flash has passed its post
+ * reset test.
+ *
+ * @returns true if SFDP was found.
+ */
+bool flash_device_detect(flash_context_t *flash_context);
+
+const struct flash_geometry* flash_device_geometry();
+
+/*
+ * Write the opcode followed by the address in the width the device needs.
+ *
+ * @returns the length of the command.
+ */
+uint8_t flash_device_command(uint8_t *command, uint8_t opcode, uint32_t address);
+
+/*
+ * Write the fast read command for the address, including the dummy bytes.
+ *
+ * @returns the length of the command.
+ */
+uint8_t flash_device_read_command(uint8_t *command, uint32_t address);
+
+/*
+ * Read from anywhere in the device, including above 16 MiB.
+ */
+void flash_device_read(flash_context_t *flash_context, uint32_t address, void *data, uint32_t length);
+
+/*
+ * Program the previously erased range a page at a time, blocking until each page
+ * is complete, typically under a millisecond per page.
+ */
+void flash_device_program(flash_context_t *flash_context, uint32_t address, const void *data, uint32_t length);
+
+#endif // FLASH_DEVICE_H
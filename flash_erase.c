@@ -0,0 +1,291 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <string.h>
+
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+
+#include "flash_device.h"
+#include "flash_erase.h"
+#include "flash_power.h"
+#include "otp_event.h"
+#include "otp_log.h"
+
+#define FLASH_WRITE_ENABLE 0x06
+#define FLASH_READ_STATUS_REGISTER_1 0x05
+#define FLASH_READ_STATUS_REGISTER_2 0x35
+#define FLASH_ERASE_SUSPEND 0x75
+#define FLASH_ERASE_RESUME 0x7A
+
+// How often completion is checked, a sector takes at least 45 ms and a block 150 ms.
+#define FLASH_ERASE_POLL_US 5000
+
+// The erase runs for at least this long after each resume before it can be
+// suspended again, the W25Q64JV needs some time between the two to make progress.
+#ifndef FLASH_ERASE_MIN_RUN_US
+#define FLASH_ERASE_MIN_RUN_US 500
+#endif
+
+static struct
+{
+    flash_context_t *flash_context;
+    uint32_t next_address; // The next sector or block to erase.
+    uint32_t command_length; // The size of the erase in progress.
+    bool erasing; // An erase command has been issued and not yet seen to complete.
+    bool suspended;
+    uint32_t running_since_us; // When the erase in progress was last issued or resumed.
+    uint64_t start_us;
+    struct flash_erase_status status;
+} erase;
+
+// Set when the alarm is added, cleared when it fires so only one is ever pending.
+static volatile bool alarm_pending = false;
+
+static int64_t _poll_alarm(alarm_id_t id, void *user_data)
+{
+    alarm_pending = false;
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return 0; // Do not reschedule.
+}
+
+static void _command(const uint8_t *command, uint8_t length)
+{
+    gpio_put(erase.flash_context->cs_pin, false);
+    spi_write_blocking(erase.flash_context->spi, command, length);
+    gpio_put(erase.flash_context->cs_pin, true);
+}
+
+static uint8_t _read_status(uint8_t command)
+{
+    uint8_t status;
+    gpio_put(erase.flash_context->cs_pin, false);
+    spi_write_blocking(erase.flash_context->spi, &command, 1);
+    spi_read_blocking(erase.flash_context->spi, 0x00, &status, 1);
+    gpio_put(erase.flash_context->cs_pin, true);
+
+    return status;
+}
+
+static inline bool _busy()
+{
+    return _read_status(FLASH_READ_STATUS_REGISTER_1) & WB_STATUS_REGISTER_1_BUSY_MASK;
+}
+
+static void _poll_later()
+{
+    if (!alarm_pending)
+    {
+        alarm_pending = true;
+        add_alarm_in_us(FLASH_ERASE_POLL_US, _poll_alarm, NULL, true);
+    }
+}
+
+static void _resume()
+{
+    uint8_t command = FLASH_ERASE_RESUME;
+    _command(&command, 1);
+    erase.suspended = false;
+    erase.running_since_us = time_us_32();
+}
+
+static void _erase_complete()
+{
+    erase.erasing = false;
+    erase.status.erased += erase.command_length;
+}
+
+static void _issue_next()
+{
+    uint32_t address = erase.next_address;
+    uint32_t remaining = erase.status.address + erase.status.length - address;
+    const struct flash_geometry *geometry = flash_device_geometry();
+    bool block = address % geometry->block_size == 0 && remaining >= geometry->block_size;
+    uint8_t command[FLASH_DEVICE_MAX_COMMAND];
+    uint8_t length = flash_device_command(command,
+        block ? geometry->block_erase_opcode : geometry->sector_erase_opcode, address);
+    uint8_t write_enable = FLASH_WRITE_ENABLE;
+
+    _command(&write_enable, 1);
+    _command(command, length);
+
+    erase.command_length = block ? geometry->block_size : geometry->sector_size;
+    erase.next_address += erase.command_length;
+    erase.erasing = true;
+    erase.running_since_us = time_us_32();
+}
+
+void flash_erase_init(flash_context_t *flash_context)
+{
+    memset(&erase, 0x00, sizeof(erase));
+    erase.flash_context = flash_context;
+    erase.status.state = FLASH_ERASE_IDLE;
+}
+
+bool flash_erase_start(uint32_t address, uint32_t length)
+{
+    uint32_t sector_size = flash_device_geometry()->sector_size;
+    if (address % sector_size != 0 || length % sector_size != 0)
+    {
+        return false;
+    }
+
+    flash_erase_quiesce();
+
+    memset(&erase.status, 0x00, sizeof(struct flash_erase_status));
+    erase.status.address = address;
+    erase.status.length = length;
+    erase.status.state = length > 0 ? FLASH_ERASE_RUNNING : FLASH_ERASE_COMPLETE;
+    erase.next_address = address;
+    erase.start_us = time_us_64();
+
+    // The first command is issued on the next pass of the main loop.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return true;
+}
+
+bool flash_erase_active()
+{
+    return erase.status.state == FLASH_ERASE_RUNNING;
+}
+
+void flash_erase_suspend()
+{
+    if (!erase.erasing || erase.suspended)
+    {
+        return;
+    }
+
+    flash_power_wake();
+    uint32_t start_us = time_us_32();
+    uint32_t running_us = start_us - erase.running_since_us;
+    if (running_us < FLASH_ERASE_MIN_RUN_US)
+    {
+        busy_wait_us_32(FLASH_ERASE_MIN_RUN_US - running_us);
+    }
+
+    if (!_busy())
+    {
+        // Already finished, the next command waits for flash_erase_run.
+        _erase_complete();
+        otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+        return;
+    }
+
+    uint8_t command = FLASH_ERASE_SUSPEND;
+    _command(&command, 1);
+    // BUSY clears within tSUS, 20 us.
+    while (_busy())
+    {
+        tight_loop_contents();
+    }
+
+    // If the erase completed as the suspend arrived SUS is not set.
+    if (_read_status(FLASH_READ_STATUS_REGISTER_2) & WB_STATUS_REGISTER_2_SUS_MASK)
+    {
+        erase.suspended = true;
+    }
+    else
+    {
+        _erase_complete();
+    }
+
+    uint32_t suspend_us = time_us_32() - start_us;
+    erase.status.suspends++;
+    erase.status.last_suspend_us = suspend_us;
+    if (suspend_us > erase.status.max_suspend_us)
+    {
+        erase.status.max_suspend_us = suspend_us;
+    }
+
+    // Resume on the next pass of the main loop, after the read.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+}
+
+void flash_erase_quiesce()
+{
+    if (!erase.erasing)
+    {
+        return;
+    }
+
+    flash_power_wake();
+    if (erase.suspended)
+    {
+        _resume();
+    }
+    // At most the remainder of a single block.
+    while (_busy())
+    {
+        tight_loop_contents();
+    }
+    _erase_complete();
+
+    // Nothing else will wake the main loop to issue the next command.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+}
+
+void flash_erase_run()
+{
+    if (erase.status.state != FLASH_ERASE_RUNNING)
+    {
+        return;
+    }
+
+    flash_power_wake();
+    if (erase.suspended)
+    {
+        _resume();
+        _poll_later();
+        return;
+    }
+
+    if (erase.erasing)
+    {
+        if (_busy())
+        {
+            _poll_later();
+            return;
+        }
+        _erase_complete();
+    }
+
+    if (erase.next_address < erase.status.address + erase.status.length)
+    {
+        _issue_next();
+        _poll_later();
+        return;
+    }
+
+    erase.status.state = FLASH_ERASE_COMPLETE;
+    erase.status.elapsed_us = time_us_64() - erase.start_us;
+    OTP_LOG_INFO("Flash erase of %d bytes complete in %d us, %d suspends, slowest %d us\n",
+        erase.status.length, erase.status.elapsed_us, erase.status.suspends, erase.status.max_suspend_us);
+}
+
+void flash_erase_get_status(struct flash_erase_status *status)
+{
+    memcpy(status, &erase.status, sizeof(struct flash_erase_status));
+    if (erase.status.state == FLASH_ERASE_RUNNING)
+    {
+        status->elapsed_us = time_us_64() - erase.start_us;
+    }
+}
@@ -0,0 +1,101 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * Flash Erase clears a range of the flash in the background, a block or
+ * sector at a time using the sizes and opcodes of the detected geometry,
+ * polling for completion from the main loop.
+ *
+ * A block erase takes hundreds of milliseconds so a read which the user is
+ * waiting for calls flash_erase_suspend first, an erase in progress is
+ * suspended with Erase Suspend (0x75) for the read and resumed with Erase
+ * Resume (0x7A) on the next pass of the main loop. Each resume is given a
+ * minimum time to run before the next suspend so a stream of reads can not
+ * starve the erase.
+ *
+ * Only reads are allowed whilst suspended, anything which writes to the
+ * flash including the status and security registers calls flash_erase_quiesce
+ * instead which waits for the block in progress to complete. Any erase
+ * remaining continues on the next pass of the main loop.
+ *
+ * As with the scan this is a single flash so the state is global.
+ */
+
+#ifndef FLASH_ERASE_H
+#define FLASH_ERASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash/flash.h"
+
+enum flash_erase_state
+{
+    FLASH_ERASE_IDLE,
+    FLASH_ERASE_RUNNING,
+    FLASH_ERASE_COMPLETE
+};
+
+struct flash_erase_status
+{
+    uint8_t state; // enum flash_erase_state
+    uint32_t address;
+    uint32_t length;
+    uint32_t erased; // Bytes erased so far.
+    uint32_t suspends;
+    uint32_t last_suspend_us; // The delay added to the last read by suspending.
+    uint32_t max_suspend_us;
+    uint32_t elapsed_us;
+};
+
+void flash_erase_init(flash_context_t *flash_context);
+
+/*
+ * Begin erasing the range in the background, replacing any erase not yet complete.
+ *
+ * @returns false if the range is not sector aligned.
+ */
+bool flash_erase_start(uint32_t address, uint32_t length);
+
+/*
+ * @returns true whilst an erase is running, reads must go through
+ * flash_erase_suspend and bulk transfers should wait.
+ */
+bool flash_erase_active();
+
+/*
+ * Suspend any erase in progress so the flash can be read, blocking for at most
+ * FLASH_ERASE_MIN_RUN_US plus tSUS.
+ */
+void flash_erase_suspend();
+
+/*
+ * Wait for any erase command in progress to complete, no further command is
+ * issued until the next call to flash_erase_run.
+ */
+void flash_erase_quiesce();
+
+/*
+ * Resume a suspended erase, check for completion and issue the next erase
+ * command, called on each pass of the main loop.
+ */
+void flash_erase_run();
+
+void flash_erase_get_status(struct flash_erase_status *status);
+
+#endif // FLASH_ERASE_H
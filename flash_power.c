@@ -0,0 +1,146 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include <string.h>
+
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+
+#include "flash_power.h"
+#include "otp_event.h"
+#include "otp_log.h"
+
+#define FLASH_POWER_DOWN 0xB9
+#define FLASH_RELEASE_POWER_DOWN 0xAB
+
+// W25Q64 tDP and tRES1, the time to enter and to leave deep power-down.
+#define FLASH_POWER_TDP_US 3
+#define FLASH_POWER_TRES1_US 3
+
+// Must be well above the time to transfer a sector as a scan only records an
+// access as each sector starts and completes.
+#ifndef FLASH_POWER_IDLE_MS
+#define FLASH_POWER_IDLE_MS 2000
+#endif
+
+// A single flash so the power state is global, it is only accessed from the
+// main loop other than the alarm which only posts an event.
+static struct
+{
+    flash_context_t *flash_context;
+    uint32_t last_access_us;
+    uint32_t asleep_since_us;
+    struct flash_power_stats stats;
+} power;
+
+// Set when the alarm is added, cleared when it fires so only one is ever pending.
+static volatile bool alarm_pending = false;
+
+static int64_t _idle_alarm(alarm_id_t id, void *user_data)
+{
+    alarm_pending = false;
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return 0; // Do not reschedule.
+}
+
+static void _command(uint8_t command)
+{
+    gpio_put(power.flash_context->cs_pin, false);
+    spi_write_blocking(power.flash_context->spi, &command, 1);
+    gpio_put(power.flash_context->cs_pin, true);
+}
+
+void flash_power_init(flash_context_t *flash_context)
+{
+    memset(&power, 0x00, sizeof(power));
+    power.flash_context = flash_context;
+    power.stats.asleep = true;
+    power.asleep_since_us = time_us_32();
+}
+
+void flash_power_wake()
+{
+    uint32_t now_us = time_us_32();
+    power.stats.accesses++;
+    power.last_access_us = now_us;
+    if (!power.stats.asleep)
+    {
+        return;
+    }
+
+    // Release Power-Down can not be sent until tDP after entering.
+    uint32_t asleep_us = now_us - power.asleep_since_us;
+    if (asleep_us < FLASH_POWER_TDP_US)
+    {
+        busy_wait_us_32(FLASH_POWER_TDP_US - asleep_us);
+    }
+
+    _command(FLASH_RELEASE_POWER_DOWN);
+    busy_wait_us_32(FLASH_POWER_TRES1_US);
+
+    uint32_t end_us = time_us_32();
+    uint32_t wake_us = end_us - now_us;
+    power.stats.asleep = false;
+    power.stats.asleep_us += now_us - power.asleep_since_us;
+    power.stats.wakes++;
+    power.stats.last_wake_us = wake_us;
+    power.stats.total_wake_us += wake_us;
+    if (wake_us > power.stats.max_wake_us)
+    {
+        power.stats.max_wake_us = wake_us;
+    }
+    power.last_access_us = end_us;
+}
+
+void flash_power_cached()
+{
+    power.stats.cached++;
+}
+
+void flash_power_run()
+{
+    if (power.stats.asleep || alarm_pending)
+    {
+        return;
+    }
+
+    uint32_t idle_us = time_us_32() - power.last_access_us;
+    if (idle_us < FLASH_POWER_IDLE_MS * 1000)
+    {
+        alarm_pending = true;
+        add_alarm_in_us(FLASH_POWER_IDLE_MS * 1000 - idle_us, _idle_alarm, NULL, true);
+        return;
+    }
+
+    _command(FLASH_POWER_DOWN);
+    power.stats.asleep = true;
+    power.stats.sleeps++;
+    power.asleep_since_us = time_us_32();
+    OTP_LOG_DEBUG("Flash in deep power-down after %d us idle\n", idle_us);
+}
+
+void flash_power_get_stats(struct flash_power_stats *stats)
+{
+    memcpy(stats, &power.stats, sizeof(struct flash_power_stats));
+    if (power.stats.asleep)
+    {
+        stats->asleep_us += time_us_32() - power.asleep_since_us;
+    }
+}
@@ -0,0 +1,75 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+ * Flash Power puts the external flash into deep power-down once it has not
+ * been accessed for FLASH_POWER_IDLE_MS and releases it again on the next
+ * access.
+ *
+ * Every access to the flash must call flash_power_wake first, it records the
+ * access and if the chip is asleep sends Release Power-Down and waits tRES1
+ * before returning. The idle check runs from the storage component, an alarm
+ * wakes the main loop when the idle period is due to expire.
+ *
+ * The chip is assumed to be asleep at start up as it may have been left in
+ * deep power-down before the RP2040 was reset, in that state it would ignore
+ * the reset sequence.
+ */
+
+#ifndef FLASH_POWER_H
+#define FLASH_POWER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash/flash.h"
+
+struct flash_power_stats
+{
+    bool asleep;
+    uint32_t sleeps;
+    uint32_t wakes;
+    uint32_t accesses; // Every call to flash_power_wake, awake or not.
+    uint32_t cached;   // Accesses served from RAM without touching the flash.
+    uint32_t last_wake_us;
+    uint32_t max_wake_us;
+    uint64_t total_wake_us;
+    uint64_t asleep_us;
+};
+
+void flash_power_init(flash_context_t *flash_context);
+
+/*
+ * Record an access, waking the flash first if it is in deep power-down.
+ */
+void flash_power_wake();
+
+/*
+ * Record an access which was served from a RAM copy instead of the flash.
+ */
+void flash_power_cached();
+
+/*
+ * Put the flash into deep power-down if the idle period has passed, otherwise
+ * ensure an alarm is pending for when it will, called on each pass of the main loop.
+ */
+void flash_power_run();
+
+void flash_power_get_stats(struct flash_power_stats *stats);
+
+#endif // FLASH_POWER_H
@@ -0,0 +1,342 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+
+#include "clock_policy.h"
+#include "flash_device.h"
+#include "flash_erase.h"
+#include "flash_power.h"
+#include "flash_scan.h"
+#include "otp_event.h"
+#include "otp_log.h"
+
+// Bytes before the sector data in each buffer to hold the end of the previous sector.
+#define CARRY_SPACE (FLASH_SCAN_MAX_PATTERN - 1)
+
+struct scan_buffer
+{
+    uint8_t data[CARRY_SPACE + FLASH_SCAN_SECTOR_SIZE];
+};
+
+// A single flash so the scan state is global, it is only accessed from the main
+// loop other than the DMA interrupt handler which only posts an event.
+static struct
+{
+    int tx_channel;
+    int rx_channel;
+    flash_context_t *flash_context;
+    struct flash_scan_status status;
+    uint8_t pattern[FLASH_SCAN_MAX_PATTERN];
+    uint8_t carry[CARRY_SPACE];
+    uint8_t carry_length;
+    bool transferring; // A sector transfer is in progress, the SPI bus is in use.
+    uint32_t next_sector; // The next sector to transfer.
+    int32_t search_sector; // A transferred sector waiting to be searched or -1.
+    uint32_t erased_crc;
+    uint64_t start_us;
+    uint32_t *crcs;
+    uint32_t crc_capacity; // Sectors the crcs allocation can hold.
+    struct scan_buffer buffers[2];
+} scan;
+
+// Clocked out to the flash whilst receiving.
+static const uint8_t dummy_byte = 0x00;
+
+static uint32_t _crc32(uint8_t byte, uint32_t length)
+{
+    // Only used once to calculate the CRC of an erased sector, no table needed.
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= byte;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static void _dma_irq_handler()
+{
+    if (dma_channel_get_irq1_status(scan.rx_channel))
+    {
+        dma_channel_acknowledge_irq1(scan.rx_channel);
+        otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+    }
+}
+
+void flash_scan_init()
+{
+    memset(&scan.status, 0x00, sizeof(struct flash_scan_status));
+    scan.status.state = FLASH_SCAN_IDLE;
+    scan.transferring = false;
+    scan.crcs = NULL;
+    scan.crc_capacity = 0;
+
+    scan.tx_channel = dma_claim_unused_channel(true);
+    scan.rx_channel = dma_claim_unused_channel(true);
+    scan.erased_crc = _crc32(0xFF, FLASH_SCAN_SECTOR_SIZE);
+
+    dma_channel_set_irq1_enabled(scan.rx_channel, true);
+    irq_add_shared_handler(DMA_IRQ_1, _dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+bool flash_scan_start(flash_context_t *flash_context, uint32_t flash_size,
+    const uint8_t *pattern, uint8_t pattern_length)
+{
+    if (pattern_length > FLASH_SCAN_MAX_PATTERN || (pattern_length > 0 && pattern == NULL))
+    {
+        return false;
+    }
+
+    flash_scan_cancel();
+
+    uint32_t sectors = flash_size / FLASH_SCAN_SECTOR_SIZE;
+    sectors = sectors < FLASH_SCAN_MAX_SECTORS ? sectors : FLASH_SCAN_MAX_SECTORS;
+    if (scan.crcs == NULL || sectors > scan.crc_capacity)
+    {
+        // Only allocated once a scan is requested and sized to the detected flash.
+        free(scan.crcs);
+        scan.crcs = malloc(sectors * sizeof(uint32_t));
+        scan.crc_capacity = scan.crcs != NULL ? sectors : 0;
+    }
+    if (scan.crcs == NULL)
+    {
+        return false;
+    }
+
+    memset(&scan.status, 0x00, sizeof(struct flash_scan_status));
+    scan.status.sectors = sectors;
+    scan.status.pattern_length = pattern_length;
+    scan.status.state = FLASH_SCAN_RUNNING;
+    memcpy(scan.pattern, pattern, pattern_length);
+    scan.carry_length = 0;
+    scan.flash_context = flash_context;
+    scan.next_sector = 0;
+    scan.search_sector = -1;
+    scan.start_us = time_us_64();
+    // The SPI divider is only changed with the clock so the bus must not be
+    // in use, holding the boost for the whole scan ensures that.
+    clock_policy_boost(CLOCK_OP_FLASH);
+
+    // Start the first transfer on the next pass of the main loop.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return true;
+}
+
+void flash_scan_cancel()
+{
+    flash_scan_quiesce();
+    if (scan.status.state == FLASH_SCAN_RUNNING)
+    {
+        scan.status.state = FLASH_SCAN_CANCELLED;
+        scan.status.elapsed_us = time_us_64() - scan.start_us;
+        clock_policy_release(CLOCK_OP_FLASH);
+    }
+}
+
+static void _start_sector(uint32_t sector)
+{
+    flash_context_t *flash_context = scan.flash_context;
+    spi_inst_t *spi = flash_context->spi;
+    uint32_t address = sector * FLASH_SCAN_SECTOR_SIZE;
+    uint8_t command[FLASH_DEVICE_MAX_COMMAND];
+    uint8_t length = flash_device_read_command(command, address);
+
+    flash_power_wake();
+    gpio_put(flash_context->cs_pin, false);
+    // Discards anything received whilst the command is sent.
+    spi_write_blocking(spi, command, length);
+
+    dma_channel_config rx_config = dma_channel_get_default_config(scan.rx_channel);
+    channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_config, false);
+    channel_config_set_write_increment(&rx_config, true);
+    channel_config_set_dreq(&rx_config, spi_get_dreq(spi, false));
+    channel_config_set_sniff_enable(&rx_config, true);
+    dma_channel_configure(scan.rx_channel, &rx_config, &scan.buffers[sector & 1].data[CARRY_SPACE],
+        &spi_get_hw(spi)->dr, FLASH_SCAN_SECTOR_SIZE, false);
+
+    dma_channel_config tx_config = dma_channel_get_default_config(scan.tx_channel);
+    channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&tx_config, false);
+    channel_config_set_write_increment(&tx_config, false);
+    channel_config_set_dreq(&tx_config, spi_get_dreq(spi, true));
+    dma_channel_configure(scan.tx_channel, &tx_config, &spi_get_hw(spi)->dr, &dummy_byte,
+        FLASH_SCAN_SECTOR_SIZE, false);
+
+    // CRC32R with a seed of all ones and an inverted result matches the usual CRC-32.
+    dma_sniffer_enable(scan.rx_channel, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+    dma_sniffer_set_output_invert_enabled(true);
+    dma_sniffer_set_data_accumulator(0xFFFFFFFF);
+
+    scan.transferring = true;
+    dma_start_channel_mask(1u << scan.rx_channel | 1u << scan.tx_channel);
+}
+
+static void _complete_sector()
+{
+    uint32_t sector = scan.next_sector;
+    gpio_put(scan.flash_context->cs_pin, true);
+    scan.transferring = false;
+    // Counts as an access so the idle period starts from the end of the transfer.
+    flash_power_wake();
+
+    uint32_t crc = dma_sniffer_get_data_accumulator();
+    scan.crcs[sector] = crc;
+    if (crc == scan.erased_crc)
+    {
+        scan.status.erased_sectors++;
+    }
+    scan.status.sectors_scanned++;
+    scan.search_sector = sector;
+    scan.next_sector++;
+}
+
+static void _search_sector(uint32_t sector)
+{
+    uint8_t pattern_length = scan.status.pattern_length;
+    uint8_t *data = scan.buffers[sector & 1].data;
+    // Place the end of the previous sector just before this one so matches
+    // spanning the two are found.
+    uint8_t *buffer = &data[CARRY_SPACE - scan.carry_length];
+    memcpy(buffer, scan.carry, scan.carry_length);
+    uint32_t total = scan.carry_length + FLASH_SCAN_SECTOR_SIZE;
+    uint32_t base = sector * FLASH_SCAN_SECTOR_SIZE - scan.carry_length;
+
+    uint8_t *candidate = buffer;
+    uint8_t *last = &buffer[total - pattern_length];
+    while (candidate <= last &&
+        (candidate = memchr(candidate, scan.pattern[0], last - candidate + 1)) != NULL)
+    {
+        if (memcmp(candidate, scan.pattern, pattern_length) == 0)
+        {
+            if (scan.status.matches < FLASH_SCAN_MAX_MATCHES)
+            {
+                scan.status.match_addresses[scan.status.matches] = base + (candidate - buffer);
+            }
+            scan.status.matches++;
+        }
+        candidate++;
+    }
+
+    scan.carry_length = pattern_length - 1;
+    memcpy(scan.carry, &buffer[total - scan.carry_length], scan.carry_length);
+}
+
+void flash_scan_run()
+{
+    if (scan.status.state != FLASH_SCAN_RUNNING)
+    {
+        return;
+    }
+
+    if (scan.transferring)
+    {
+        if (dma_channel_is_busy(scan.rx_channel))
+        {
+            // The DMA interrupt will wake us.
+            return;
+        }
+        _complete_sector();
+    }
+
+    // Keep the bus busy, the next sector transfers whilst this one is searched.
+    // A background erase takes priority, the erase wakes the main loop when complete.
+    if (scan.next_sector < scan.status.sectors && !flash_erase_active())
+    {
+        _start_sector(scan.next_sector);
+    }
+
+    if (scan.search_sector >= 0)
+    {
+        if (scan.status.pattern_length > 0)
+        {
+            _search_sector(scan.search_sector);
+        }
+        scan.search_sector = -1;
+    }
+
+    if (!scan.transferring && scan.next_sector >= scan.status.sectors)
+    {
+        scan.status.state = FLASH_SCAN_COMPLETE;
+        scan.status.elapsed_us = time_us_64() - scan.start_us;
+        clock_policy_release(CLOCK_OP_FLASH);
+        OTP_LOG_INFO("Flash scan of %d sectors complete in %d us, %d erased, %d matches\n",
+            scan.status.sectors, scan.status.elapsed_us, scan.status.erased_sectors, scan.status.matches);
+    }
+}
+
+void flash_scan_quiesce()
+{
+    if (!scan.transferring)
+    {
+        return;
+    }
+
+    // At most the remainder of a single sector.
+    while (dma_channel_is_busy(scan.rx_channel))
+    {
+        tight_loop_contents();
+    }
+    _complete_sector();
+    if (scan.search_sector >= 0 && scan.status.pattern_length > 0)
+    {
+        _search_sector(scan.search_sector);
+    }
+    scan.search_sector = -1;
+
+    // Nothing else will wake the main loop to start the next sector.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+}
+
+void flash_scan_get_status(struct flash_scan_status *status)
+{
+    memcpy(status, &scan.status, sizeof(struct flash_scan_status));
+    if (scan.status.state == FLASH_SCAN_RUNNING)
+    {
+        status->elapsed_us = time_us_64() - scan.start_us;
+    }
+}
+
+bool flash_scan_sector_crc(uint32_t sector, uint32_t *crc)
+{
+    if (scan.crcs == NULL || sector >= scan.status.sectors_scanned)
+    {
+        return false;
+    }
+
+    *crc = scan.crcs[sector];
+    return true;
+}
+
+bool flash_scan_sector_erased(uint32_t sector)
+{
+    uint32_t crc;
+    return flash_scan_sector_crc(sector, &crc) && crc == scan.erased_crc;
+}
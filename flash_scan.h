@@ -0,0 +1,102 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * Flash Scan streams the whole of the external flash a sector at a time using DMA.
+ *
+ * The CRC32 of each sector is calculated by the DMA sniffer as the data is
+ * received, whilst the next sector is transferring the previous one can
+ * optionally be searched for a pattern.
+ *
+ * The scan runs in the background from the storage component, a DMA interrupt
+ * wakes the main loop as each sector completes. Any other use of the flash must
+ * call flash_scan_quiesce first so it has exclusive use of the SPI bus.
+ */
+
+#ifndef FLASH_SCAN_H
+#define FLASH_SCAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash/flash.h"
+
+#define FLASH_SCAN_SECTOR_SIZE 4096
+#define FLASH_SCAN_MAX_SECTORS 8192 // 32 MiB, the CRCs are allocated for the detected size.
+#define FLASH_SCAN_MAX_PATTERN 16
+#define FLASH_SCAN_MAX_MATCHES 8
+
+enum flash_scan_state
+{
+    FLASH_SCAN_IDLE,
+    FLASH_SCAN_RUNNING,
+    FLASH_SCAN_COMPLETE,
+    FLASH_SCAN_CANCELLED
+};
+
+struct flash_scan_status
+{
+    uint8_t state; // enum flash_scan_state
+    uint32_t sectors;
+    uint32_t sectors_scanned;
+    uint32_t erased_sectors; // Sectors which only contain 0xFF.
+    uint8_t pattern_length;  // 0 if no pattern is being searched for.
+    uint32_t matches;
+    uint32_t match_addresses[FLASH_SCAN_MAX_MATCHES]; // The first matches found.
+    uint32_t elapsed_us;
+};
+
+/*
+ * Claim the DMA channels used for scanning.
+ */
+void flash_scan_init();
+
+/*
+ * Begin a scan of the flash, any scan already in progress is cancelled.
+ *
+ * @param flash_size The size of the flash in bytes.
+ * @param pattern The pattern to search for or NULL.
+ * @returns false if the pattern is too long or the CRCs could not be allocated.
+ */
+bool flash_scan_start(flash_context_t *flash_context, uint32_t flash_size,
+    const uint8_t *pattern, uint8_t pattern_length);
+
+void flash_scan_cancel();
+
+/*
+ * Advance the scan, called on each pass of the main loop.
+ */
+void flash_scan_run();
+
+/*
+ * Wait for any sector transfer in progress to complete and release the SPI bus,
+ * the scan continues from the next sector on the next call to flash_scan_run.
+ */
+void flash_scan_quiesce();
+
+void flash_scan_get_status(struct flash_scan_status *status);
+
+/*
+ * @returns true if the sector has been scanned and the crc set.
+ */
+bool flash_scan_sector_crc(uint32_t sector, uint32_t *crc);
+
+/*
+ * @returns true if the sector has been scanned and contained only 0xFF.
+ */
+bool flash_scan_sector_erased(uint32_t sector);
+
+#endif // FLASH_SCAN_H
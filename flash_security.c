@@ -0,0 +1,274 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+
+#include "flash_security.h"
+#include "otp_event.h"
+#include "otp_log.h"
+
+#define FLASH_WRITE_ENABLE 0x06
+#define FLASH_READ_STATUS_REGISTER_1 0x05
+#define FLASH_READ_STATUS_REGISTER_2 0x35
+#define FLASH_WRITE_STATUS_REGISTER_2 0x31
+#define FLASH_ERASE_SECURITY_REGISTER 0x44
+#define FLASH_PROGRAM_SECURITY_REGISTER 0x42
+#define FLASH_READ_SECURITY_REGISTER 0x48
+
+// LB1 to LB3 are consecutive bits of status register 2.
+#define LOCK_BIT(security_register) (WB_STATUS_REGISTER_2_LB1_MASK << ((security_register) - 1))
+
+// How often completion is checked, tSE for a security register is 45 ms typical.
+#define FLASH_SECURITY_POLL_US 5000
+
+enum write_state
+{
+    WRITE_IDLE,
+    WRITE_ERASING,
+    WRITE_PROGRAMMING
+};
+
+static struct
+{
+    flash_context_t *flash_context;
+    uint8_t state; // enum write_state
+    uint8_t security_register;
+    uint16_t length;
+    uint8_t data[FLASH_SECURITY_REGISTER_SIZE];
+    flash_security_callback callback;
+    void *handback;
+    uint32_t start_us;
+} write;
+
+// Set when the alarm is added, cleared when it fires so only one is ever pending.
+static volatile bool alarm_pending = false;
+
+static int64_t _poll_alarm(alarm_id_t id, void *user_data)
+{
+    alarm_pending = false;
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return 0; // Do not reschedule.
+}
+
+static void _poll_later()
+{
+    if (!alarm_pending)
+    {
+        alarm_pending = true;
+        add_alarm_in_us(FLASH_SECURITY_POLL_US, _poll_alarm, NULL, true);
+    }
+}
+
+static inline bool _valid(uint8_t security_register)
+{
+    return security_register >= 1 && security_register <= FLASH_SECURITY_REGISTERS;
+}
+
+static void _command(flash_context_t *flash_context, const uint8_t *command, uint8_t length)
+{
+    gpio_put(flash_context->cs_pin, false);
+    spi_write_blocking(flash_context->spi, command, length);
+    gpio_put(flash_context->cs_pin, true);
+}
+
+static uint8_t _read_status(flash_context_t *flash_context, uint8_t command)
+{
+    uint8_t status;
+    gpio_put(flash_context->cs_pin, false);
+    spi_write_blocking(flash_context->spi, &command, 1);
+    spi_read_blocking(flash_context->spi, 0x00, &status, 1);
+    gpio_put(flash_context->cs_pin, true);
+
+    return status;
+}
+
+static void _write_enable(flash_context_t *flash_context)
+{
+    uint8_t command = FLASH_WRITE_ENABLE;
+    _command(flash_context, &command, 1);
+}
+
+static void _wait_ready(flash_context_t *flash_context)
+{
+    while (_read_status(flash_context, FLASH_READ_STATUS_REGISTER_1) & WB_STATUS_REGISTER_1_BUSY_MASK)
+    {
+        tight_loop_contents();
+    }
+}
+
+bool flash_security_read(flash_context_t *flash_context, uint8_t security_register, uint8_t offset,
+    void *data, uint16_t length)
+{
+    if (!_valid(security_register) || offset + length > FLASH_SECURITY_REGISTER_SIZE)
+    {
+        return false;
+    }
+
+    // The register number is in address bits 12 and 13, a dummy byte follows the address.
+    uint8_t command[5] = { FLASH_READ_SECURITY_REGISTER, 0x00, security_register << 4, offset, 0x00 };
+    gpio_put(flash_context->cs_pin, false);
+    spi_write_blocking(flash_context->spi, command, sizeof(command));
+    spi_read_blocking(flash_context->spi, 0x00, data, length);
+    gpio_put(flash_context->cs_pin, true);
+
+    return true;
+}
+
+static bool _busy()
+{
+    return _read_status(write.flash_context, FLASH_READ_STATUS_REGISTER_1) & WB_STATUS_REGISTER_1_BUSY_MASK;
+}
+
+static void _program()
+{
+    // The whole register is a single page so one program command is enough.
+    uint8_t command[4] = { FLASH_PROGRAM_SECURITY_REGISTER, 0x00, write.security_register << 4, 0x00 };
+    _write_enable(write.flash_context);
+    gpio_put(write.flash_context->cs_pin, false);
+    spi_write_blocking(write.flash_context->spi, command, sizeof(command));
+    spi_write_blocking(write.flash_context->spi, write.data, write.length);
+    gpio_put(write.flash_context->cs_pin, true);
+    write.state = WRITE_PROGRAMMING;
+}
+
+static void _complete()
+{
+    flash_security_callback callback = write.callback;
+    void *handback = write.handback;
+
+    OTP_LOG_INFO("Security register %d written in %d us\n", write.security_register, time_us_32() - write.start_us);
+    memset(write.data, 0x00, sizeof(write.data));
+    write.state = WRITE_IDLE;
+    write.callback = NULL;
+    write.handback = NULL;
+
+    if (callback != NULL)
+    {
+        callback(true, handback);
+    }
+}
+
+bool flash_security_write_start(flash_context_t *flash_context, uint8_t security_register, const void *data,
+    uint16_t length, flash_security_callback callback, void *handback)
+{
+    flash_security_quiesce();
+
+    if (!_valid(security_register) || length > FLASH_SECURITY_REGISTER_SIZE ||
+        flash_security_locked(flash_context, security_register))
+    {
+        return false;
+    }
+
+    write.flash_context = flash_context;
+    write.security_register = security_register;
+    write.length = length;
+    memcpy(write.data, data, length);
+    write.callback = callback;
+    write.handback = handback;
+    write.start_us = time_us_32();
+
+    uint8_t command[4] = { FLASH_ERASE_SECURITY_REGISTER, 0x00, security_register << 4, 0x00 };
+    _write_enable(flash_context);
+    _command(flash_context, command, sizeof(command));
+    write.state = WRITE_ERASING;
+    _poll_later();
+
+    return true;
+}
+
+bool flash_security_busy()
+{
+    return write.state != WRITE_IDLE;
+}
+
+void flash_security_run()
+{
+    if (write.state == WRITE_IDLE)
+    {
+        return;
+    }
+
+    if (_busy())
+    {
+        _poll_later();
+        return;
+    }
+
+    if (write.state == WRITE_ERASING)
+    {
+        // tPP is under 3 ms, poll again rather than wait here.
+        _program();
+        _poll_later();
+        return;
+    }
+
+    _complete();
+}
+
+void flash_security_quiesce()
+{
+    if (write.state == WRITE_IDLE)
+    {
+        return;
+    }
+
+    while (_busy())
+    {
+        tight_loop_contents();
+    }
+    if (write.state == WRITE_ERASING)
+    {
+        _program();
+        while (_busy())
+        {
+            tight_loop_contents();
+        }
+    }
+
+    _complete();
+}
+
+bool flash_security_locked(flash_context_t *flash_context, uint8_t security_register)
+{
+    return _valid(security_register) &&
+        (_read_status(flash_context, FLASH_READ_STATUS_REGISTER_2) & LOCK_BIT(security_register)) != 0;
+}
+
+bool flash_security_lock(flash_context_t *flash_context, uint8_t security_register)
+{
+    if (!_valid(security_register))
+    {
+        return false;
+    }
+
+    // The other bits, including QE, must be written back unchanged.
+    uint8_t status = _read_status(flash_context, FLASH_READ_STATUS_REGISTER_2);
+    uint8_t command[2] = { FLASH_WRITE_STATUS_REGISTER_2, status | LOCK_BIT(security_register) };
+    _write_enable(flash_context);
+    _command(flash_context, command, sizeof(command));
+    _wait_ready(flash_context);
+
+    bool locked = flash_security_locked(flash_context, security_register);
+    OTP_LOG_INFO("Security register %d locked=%d\n", security_register, locked);
+
+    return locked;
+}
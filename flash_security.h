@@ -0,0 +1,92 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Access to the three 256 byte security registers of the W25Q64JV.
+ *
+ * The registers are outside of the main array so are untouched by a chip erase
+ * and each can be permanently locked with its lock bit LB1 to LB3 in status
+ * register 2. A register is read with a single command so small, frequently
+ * needed data can be loaded without searching the main array.
+ *
+ * As with the other direct users of the SPI bus flash_scan_quiesce must be
+ * called first. As there is a single flash the write in progress is global.
+ */
+
+#ifndef FLASH_SECURITY_H
+#define FLASH_SECURITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash/flash.h"
+
+#define FLASH_SECURITY_REGISTERS 3
+#define FLASH_SECURITY_REGISTER_SIZE 256
+
+/*
+ * Read from a security register.
+ *
+ * @param security_register 1 to FLASH_SECURITY_REGISTERS.
+ * @returns false if the register or range is invalid.
+ */
+bool flash_security_read(flash_context_t *flash_context, uint8_t security_register, uint8_t offset,
+    void *data, uint16_t length);
+
+typedef void (*flash_security_callback)(bool written, void *handback);
+
+/*
+ * Erase the register and program data from the start of it in the background,
+ * the erase takes up to 100 ms so completion is polled from the main loop by
+ * flash_security_run. The data is copied so need not outlive the call.
+ *
+ * Only one write is held at a time, a write still in progress is completed
+ * first. The callback is called from the main loop once the write completes.
+ *
+ * @returns false if the register is invalid, locked or the data too long.
+ */
+bool flash_security_write_start(flash_context_t *flash_context, uint8_t security_register, const void *data,
+    uint16_t length, flash_security_callback callback, void *handback);
+
+/*
+ * @returns true whilst a write is in progress, the flash accepts no other
+ * commands until it completes.
+ */
+bool flash_security_busy();
+
+/*
+ * Advance a write in progress, called on each pass of the main loop.
+ */
+void flash_security_run();
+
+/*
+ * Wait for any write in progress to complete, called by everything else which
+ * uses the SPI bus.
+ */
+void flash_security_quiesce();
+
+bool flash_security_locked(flash_context_t *flash_context, uint8_t security_register);
+
+/*
+ * Set the lock bit for the register, this is permanent and the register can
+ * never be erased or programmed again.
+ *
+ * @returns true if the register is now locked.
+ */
+bool flash_security_lock(flash_context_t *flash_context, uint8_t security_register);
+
+#endif // FLASH_SECURITY_H
@@ -18,6 +18,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "otp_event.h"
+#include "otp_log.h"
 #include "otp_main.h"
 #include "otp_mgr.h"
 #include "pico_ward.h"
@@ -27,8 +29,9 @@ struct _otp_admin_context
 {
     struct common_context common_context;
     void *otp_mgr_context;
-    bool handle_event_required;
-
+    uint32_t pending_notifications;
+    bool usb_activity;
+    uint32_t reported_dropped_count;
 };
 
 otp_admin_context_t* otp_admin_init()
@@ -37,7 +40,11 @@ otp_admin_context_t* otp_admin_init()
     context->common_context.id = OTP_ADMIN_CONTEXT_ID;
 
     context->otp_mgr_context = otp_mgr_init();
-    context->handle_event_required = false;
+    context->pending_notifications = 0;
+    context->usb_activity = false;
+    context->reported_dropped_count = 0;
+
+    otp_event_init();
 
     return (otp_admin_context_t*) context;
 }
@@ -48,7 +55,7 @@ bool otp_admin_begin(pico_ward_context_t *pico_ward_context)
     struct _otp_admin_context *context = (struct _otp_admin_context*) admin_context;
     if (context->common_context.id != OTP_ADMIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_admin_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_admin_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
@@ -63,12 +70,34 @@ void otp_admin_run(otp_admin_context_t *admin_context)
 {
     if (admin_context->id != OTP_ADMIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_admin_run 0x%02x\n", admin_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_admin_run 0x%02x\n", admin_context->id);
         return;
     }
 
     struct _otp_admin_context *context = (struct _otp_admin_context*)admin_context;
 
+    if (otp_event_take_usb_irq())
+    {
+        context->usb_activity = true;
+    }
+    // Background wake-ups need nothing more, the work happens in each pass.
+    context->pending_notifications += otp_event_take_notifications();
+
+    // Everything still queued is USB related and handled by a single pass of
+    // the terminal handler.
+    otp_event_t event;
+    while (otp_event_poll(&event))
+    {
+        context->usb_activity = true;
+    }
+
+    uint32_t dropped_count = otp_event_dropped_count();
+    if (dropped_count != context->reported_dropped_count)
+    {
+        OTP_LOG_WARN("Dropped %d events\n", dropped_count - context->reported_dropped_count);
+        context->reported_dropped_count = dropped_count;
+    }
+
     otp_mgr_run(context->otp_mgr_context);
 }
 
@@ -76,31 +105,48 @@ void otp_admin_notify(otp_admin_context_t *admin_context)
 {
     if (admin_context->id != OTP_ADMIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_admin_notify 0x%02x\n", admin_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_admin_notify 0x%02x\n", admin_context->id);
         return;
     }
 
+    // May be called from outside of the main loop so always go via otp_event,
+    // notifications are counted there rather than queued so are never dropped.
+    otp_event_post(OTP_EVENT_NOTIFY, 0x00);
+}
+
+bool otp_admin_handle_notification(otp_admin_context_t *admin_context)
+{
+    if (admin_context->id != OTP_ADMIN_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_admin_notify 0x%02x\n", admin_context->id);
+        return false;
+    }
+
     struct _otp_admin_context *context = (struct _otp_admin_context*)admin_context;
 
+    if (context->pending_notifications == 0)
+    {
+        return false;
+    }
+
+    // Notifications are consumed one at a time so a burst is not merged.
+    context->pending_notifications--;
 
-    // Set the flag to indicate that an event needs to be handled.
-    context->handle_event_required = true;
+    return true;
 }
 
-bool otp_admin_handle_notification(otp_admin_context_t *admin_context)
+bool otp_admin_handle_usb_activity(otp_admin_context_t *admin_context)
 {
     if (admin_context->id != OTP_ADMIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_admin_notify 0x%02x\n", admin_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_admin_handle_usb_activity 0x%02x\n", admin_context->id);
         return false;
     }
 
     struct _otp_admin_context *context = (struct _otp_admin_context*)admin_context;
 
-    bool notified = context->handle_event_required;
-
-    // Set the flag to indicate that an event needs to be handled.
-    context->handle_event_required = false;
+    bool usb_activity = context->usb_activity;
+    context->usb_activity = false;
 
-    return notified;
+    return usb_activity;
 }
\ No newline at end of file
@@ -59,9 +59,20 @@ void otp_admin_notify(otp_admin_context_t *admin_context);
  * This function will be called by the underlying OTP manager to handle any
  * previously received notification.
  *
- * Returns true if notify has been called, false otherwise. Calling this function
- * clears the notification state.
+ * Returns true if notify has been called, false otherwise. Each call consumes a
+ * single notification so callers should loop until false is returned.
  */
 bool otp_admin_handle_notification(otp_admin_context_t *admin_context);
 
+/**
+ * Handle any USB activity.
+ *
+ * This function will be called by the underlying OTP manager to decide if the
+ * terminal handler needs to run.
+ *
+ * Returns true if USB activity has been reported since the last call, false otherwise.
+ * Calling this function clears the activity state.
+ */
+bool otp_admin_handle_usb_activity(otp_admin_context_t *admin_context);
+
 #endif // OTP_ADMIN_H
\ No newline at end of file
@@ -0,0 +1,355 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "otp_crypt.h"
+#include "otp_hot_path.h"
+
+#define CHACHA20_BLOCK_SIZE 64
+#define POLY1305_BLOCK_SIZE 16
+// Repeat the benchmark to smooth out the 1 us timer resolution.
+#define BENCHMARK_ITERATIONS 16
+
+static inline uint32_t _rotl(uint32_t value, uint8_t bits)
+{
+    return value << bits | value >> (32 - bits);
+}
+
+static inline uint32_t _load32(const uint8_t *bytes)
+{
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+static inline void _store32(uint8_t *bytes, uint32_t value)
+{
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+    bytes[2] = value >> 16;
+    bytes[3] = value >> 24;
+}
+
+/*
+ * ChaCha20
+ */
+
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d = _rotl(d ^ a, 16);  \
+    c += d; b = _rotl(b ^ c, 12);  \
+    a += b; d = _rotl(d ^ a, 8);   \
+    c += d; b = _rotl(b ^ c, 7);
+
+static void OTP_HOT_PATH(_chacha20_block)(const uint32_t *input, uint8_t *output)
+{
+    uint32_t x[16];
+    memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; i++)
+    {
+        QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+        QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+        QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+        QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+        QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+        QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+        QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+        QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        _store32(&output[i * 4], x[i] + input[i]);
+    }
+}
+
+static void _chacha20_init(uint32_t *state, const uint8_t *key, const uint8_t *nonce, uint32_t counter)
+{
+    // "expand 32-byte k"
+    state[0] = 0x61707865;
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++)
+    {
+        state[4 + i] = _load32(&key[i * 4]);
+    }
+    state[12] = counter;
+    for (int i = 0; i < 3; i++)
+    {
+        state[13 + i] = _load32(&nonce[i * 4]);
+    }
+}
+
+static void OTP_HOT_PATH(_chacha20_xor)(const uint8_t *key, const uint8_t *nonce, uint32_t counter,
+    const uint8_t *input, uint32_t length, uint8_t *output)
+{
+    uint32_t state[16];
+    uint8_t block[CHACHA20_BLOCK_SIZE];
+    _chacha20_init(state, key, nonce, counter);
+
+    while (length > 0)
+    {
+        _chacha20_block(state, block);
+        state[12]++;
+        uint32_t chunk = length < CHACHA20_BLOCK_SIZE ? length : CHACHA20_BLOCK_SIZE;
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            output[i] = input[i] ^ block[i];
+        }
+        input += chunk;
+        output += chunk;
+        length -= chunk;
+    }
+
+    memset(state, 0x00, sizeof(state));
+    memset(block, 0x00, sizeof(block));
+}
+
+/*
+ * Poly1305, the accumulator and key are held as five 26 bit limbs so the
+ * products fit in 64 bits.
+ */
+
+struct poly1305
+{
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+    uint8_t block[POLY1305_BLOCK_SIZE];
+    uint8_t block_length;
+};
+
+static void _poly1305_init(struct poly1305 *poly, const uint8_t *key)
+{
+    // r is clamped as required by the specification.
+    poly->r[0] = (_load32(&key[0])) & 0x3ffffff;
+    poly->r[1] = (_load32(&key[3]) >> 2) & 0x3ffff03;
+    poly->r[2] = (_load32(&key[6]) >> 4) & 0x3ffc0ff;
+    poly->r[3] = (_load32(&key[9]) >> 6) & 0x3f03fff;
+    poly->r[4] = (_load32(&key[12]) >> 8) & 0x00fffff;
+    for (int i = 0; i < 5; i++)
+    {
+        poly->h[i] = 0;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        poly->pad[i] = _load32(&key[16 + i * 4]);
+    }
+    poly->block_length = 0;
+}
+
+static void OTP_HOT_PATH(_poly1305_blocks)(struct poly1305 *poly, const uint8_t *data, uint32_t length, uint32_t hibit)
+{
+    const uint32_t r0 = poly->r[0], r1 = poly->r[1], r2 = poly->r[2], r3 = poly->r[3], r4 = poly->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = poly->h[0], h1 = poly->h[1], h2 = poly->h[2], h3 = poly->h[3], h4 = poly->h[4];
+
+    while (length >= POLY1305_BLOCK_SIZE)
+    {
+        h0 += (_load32(&data[0])) & 0x3ffffff;
+        h1 += (_load32(&data[3]) >> 2) & 0x3ffffff;
+        h2 += (_load32(&data[6]) >> 4) & 0x3ffffff;
+        h3 += (_load32(&data[9]) >> 6) & 0x3ffffff;
+        h4 += (_load32(&data[12]) >> 8) | hibit;
+
+        uint64_t d0 = (uint64_t) h0 * r0 + (uint64_t) h1 * s4 + (uint64_t) h2 * s3 + (uint64_t) h3 * s2 + (uint64_t) h4 * s1;
+        uint64_t d1 = (uint64_t) h0 * r1 + (uint64_t) h1 * r0 + (uint64_t) h2 * s4 + (uint64_t) h3 * s3 + (uint64_t) h4 * s2;
+        uint64_t d2 = (uint64_t) h0 * r2 + (uint64_t) h1 * r1 + (uint64_t) h2 * r0 + (uint64_t) h3 * s4 + (uint64_t) h4 * s3;
+        uint64_t d3 = (uint64_t) h0 * r3 + (uint64_t) h1 * r2 + (uint64_t) h2 * r1 + (uint64_t) h3 * r0 + (uint64_t) h4 * s4;
+        uint64_t d4 = (uint64_t) h0 * r4 + (uint64_t) h1 * r3 + (uint64_t) h2 * r2 + (uint64_t) h3 * r1 + (uint64_t) h4 * r0;
+
+        uint32_t c;
+        c = d0 >> 26; h0 = d0 & 0x3ffffff;
+        d1 += c; c = d1 >> 26; h1 = d1 & 0x3ffffff;
+        d2 += c; c = d2 >> 26; h2 = d2 & 0x3ffffff;
+        d3 += c; c = d3 >> 26; h3 = d3 & 0x3ffffff;
+        d4 += c; c = d4 >> 26; h4 = d4 & 0x3ffffff;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+        h1 += c;
+
+        data += POLY1305_BLOCK_SIZE;
+        length -= POLY1305_BLOCK_SIZE;
+    }
+
+    poly->h[0] = h0;
+    poly->h[1] = h1;
+    poly->h[2] = h2;
+    poly->h[3] = h3;
+    poly->h[4] = h4;
+}
+
+static void _poly1305_update(struct poly1305 *poly, const uint8_t *data, uint32_t length)
+{
+    if (poly->block_length > 0)
+    {
+        uint32_t take = POLY1305_BLOCK_SIZE - poly->block_length;
+        take = take < length ? take : length;
+        memcpy(&poly->block[poly->block_length], data, take);
+        poly->block_length += take;
+        data += take;
+        length -= take;
+        if (poly->block_length < POLY1305_BLOCK_SIZE)
+        {
+            return;
+        }
+        _poly1305_blocks(poly, poly->block, POLY1305_BLOCK_SIZE, 1 << 24);
+        poly->block_length = 0;
+    }
+
+    uint32_t whole = length & ~(POLY1305_BLOCK_SIZE - 1);
+    _poly1305_blocks(poly, data, whole, 1 << 24);
+    memcpy(poly->block, &data[whole], length - whole);
+    poly->block_length = length - whole;
+}
+
+/*
+ * The AEAD construction pads the additional data and ciphertext to whole blocks.
+ */
+static void _poly1305_pad(struct poly1305 *poly)
+{
+    if (poly->block_length > 0)
+    {
+        memset(&poly->block[poly->block_length], 0x00, POLY1305_BLOCK_SIZE - poly->block_length);
+        _poly1305_blocks(poly, poly->block, POLY1305_BLOCK_SIZE, 1 << 24);
+        poly->block_length = 0;
+    }
+}
+
+static void _poly1305_finish(struct poly1305 *poly, uint8_t *tag)
+{
+    uint32_t h0 = poly->h[0], h1 = poly->h[1], h2 = poly->h[2], h3 = poly->h[3], h4 = poly->h[4];
+    uint32_t c;
+
+    // Fully carry h.
+    c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+
+    // Compute h - p and select it without branching if h >= p.
+    uint32_t g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    uint32_t g4 = h4 + c - (1 << 26);
+
+    uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // h = (h + pad) mod 2^128
+    uint64_t f;
+    f = (uint64_t) (h0 | h1 << 26) + poly->pad[0];
+    _store32(&tag[0], f);
+    f = (uint64_t) (h1 >> 6 | h2 << 20) + poly->pad[1] + (f >> 32);
+    _store32(&tag[4], f);
+    f = (uint64_t) (h2 >> 12 | h3 << 14) + poly->pad[2] + (f >> 32);
+    _store32(&tag[8], f);
+    f = (uint64_t) (h3 >> 18 | h4 << 8) + poly->pad[3] + (f >> 32);
+    _store32(&tag[12], f);
+
+    memset(poly, 0x00, sizeof(struct poly1305));
+}
+
+/*
+ * AEAD
+ */
+
+static void _calculate_tag(const uint8_t *key, const uint8_t *nonce, const uint8_t *ad, uint32_t ad_length,
+    const uint8_t *ciphertext, uint32_t length, uint8_t *tag)
+{
+    // The one time Poly1305 key is the first 32 bytes of block 0.
+    uint8_t poly_key[CHACHA20_BLOCK_SIZE];
+    uint32_t state[16];
+    _chacha20_init(state, key, nonce, 0);
+    _chacha20_block(state, poly_key);
+
+    struct poly1305 poly;
+    _poly1305_init(&poly, poly_key);
+    _poly1305_update(&poly, ad, ad_length);
+    _poly1305_pad(&poly);
+    _poly1305_update(&poly, ciphertext, length);
+    _poly1305_pad(&poly);
+
+    uint8_t lengths[16] = { 0 };
+    _store32(&lengths[0], ad_length);
+    _store32(&lengths[8], length);
+    _poly1305_update(&poly, lengths, sizeof(lengths));
+    _poly1305_finish(&poly, tag);
+
+    memset(poly_key, 0x00, sizeof(poly_key));
+    memset(state, 0x00, sizeof(state));
+}
+
+void otp_crypt_seal(const uint8_t *key, const uint8_t *nonce, const uint8_t *ad, uint32_t ad_length,
+    const uint8_t *plaintext, uint32_t length, uint8_t *ciphertext, uint8_t *tag)
+{
+    _chacha20_xor(key, nonce, 1, plaintext, length, ciphertext);
+    _calculate_tag(key, nonce, ad, ad_length, ciphertext, length, tag);
+}
+
+bool otp_crypt_open(const uint8_t *key, const uint8_t *nonce, const uint8_t *ad, uint32_t ad_length,
+    const uint8_t *ciphertext, uint32_t length, const uint8_t *tag, uint8_t *plaintext)
+{
+    uint8_t expected[OTP_CRYPT_TAG_LENGTH];
+    _calculate_tag(key, nonce, ad, ad_length, ciphertext, length, expected);
+
+    // Every byte is compared so the time taken does not reveal how much matched.
+    volatile uint8_t difference = 0;
+    for (int i = 0; i < OTP_CRYPT_TAG_LENGTH; i++)
+    {
+        difference |= expected[i] ^ tag[i];
+    }
+    if (difference != 0)
+    {
+        return false;
+    }
+
+    _chacha20_xor(key, nonce, 1, ciphertext, length, plaintext);
+    return true;
+}
+
+void otp_crypt_benchmark(struct otp_crypt_benchmark *benchmark)
+{
+    // The values make no difference to the timing.
+    static const uint8_t key[OTP_CRYPT_KEY_LENGTH] = { 0x00 };
+    static const uint8_t nonce[OTP_CRYPT_NONCE_LENGTH] = { 0x00 };
+    static uint8_t page[OTP_CRYPT_BENCHMARK_LENGTH];
+    static uint8_t sealed[OTP_CRYPT_BENCHMARK_LENGTH];
+    uint8_t ad[8] = { 0x00 };
+    uint8_t tag[OTP_CRYPT_TAG_LENGTH];
+
+    uint32_t start = time_us_32();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        otp_crypt_seal(key, nonce, ad, sizeof(ad), page, sizeof(page), sealed, tag);
+    }
+    benchmark->seal_us = (time_us_32() - start) / BENCHMARK_ITERATIONS;
+
+    start = time_us_32();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        otp_crypt_open(key, nonce, ad, sizeof(ad), sealed, sizeof(sealed), tag, page);
+    }
+    benchmark->open_us = (time_us_32() - start) / BENCHMARK_ITERATIONS;
+}
@@ -0,0 +1,68 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * ChaCha20-Poly1305 (RFC 8439) authenticated encryption for data at rest.
+ *
+ * The RP2040 has no AES hardware, ChaCha20 only needs 32 bit additions,
+ * rotations and XOR so it is the faster choice on the Cortex-M0+ as well as
+ * being free of table lookups indexed by secret data.
+ */
+
+#ifndef OTP_CRYPT_H
+#define OTP_CRYPT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OTP_CRYPT_KEY_LENGTH 32
+#define OTP_CRYPT_NONCE_LENGTH 12
+#define OTP_CRYPT_TAG_LENGTH 16
+
+// The size of a flash page, used for the throughput benchmark.
+#define OTP_CRYPT_BENCHMARK_LENGTH 256
+
+struct otp_crypt_benchmark
+{
+    uint32_t seal_us; // To encrypt and authenticate one page.
+    uint32_t open_us; // To verify and decrypt one page.
+};
+
+/*
+ * Encrypt length bytes of plaintext into ciphertext, which may be the same
+ * buffer, and calculate the tag over the additional data and ciphertext.
+ *
+ * A nonce must never be used twice with the same key.
+ */
+void otp_crypt_seal(const uint8_t *key, const uint8_t *nonce, const uint8_t *ad, uint32_t ad_length,
+    const uint8_t *plaintext, uint32_t length, uint8_t *ciphertext, uint8_t *tag);
+
+/*
+ * Verify the tag and only if it matches decrypt the ciphertext into plaintext,
+ * which may be the same buffer.
+ *
+ * @returns false if the tag does not match, plaintext is untouched.
+ */
+bool otp_crypt_open(const uint8_t *key, const uint8_t *nonce, const uint8_t *ad, uint32_t ad_length,
+    const uint8_t *ciphertext, uint32_t length, const uint8_t *tag, uint8_t *plaintext);
+
+/*
+ * Time sealing and opening a single flash page.
+ */
+void otp_crypt_benchmark(struct otp_crypt_benchmark *benchmark);
+
+#endif // OTP_CRYPT_H
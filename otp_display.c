@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "otp_log.h"
 #include "pico_ward.h"
 
 #define OTP_DISPLAY_CONTEXT_ID 0xAD
@@ -41,7 +42,7 @@ bool otp_display_begin(pico_ward_context_t *pico_ward_context)
     struct _otp_display_context *context = (struct _otp_display_context*) access_otp_display_context(pico_ward_context);
     if (context->common_context.id != OTP_DISPLAY_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_display_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_display_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
@@ -52,7 +53,7 @@ void otp_display_run(otp_display_context_t *display_context)
 {
     if (display_context->id != OTP_DISPLAY_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_display_run 0x%02x\n", display_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_display_run 0x%02x\n", display_context->id);
         return;
     }
 
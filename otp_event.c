@@ -0,0 +1,154 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pico/util/queue.h"
+#include "tusb.h"
+
+#include "boot_profile.h"
+#include "otp_event.h"
+
+// The queue is global as the TinyUSB callbacks have no context to pass.
+static queue_t event_queue;
+static volatile uint32_t dropped_count = 0;
+// A flag rather than a queue entry, TinyUSB queues the detail internally and
+// it is all handled by the next tud_task. As a flag it can never be dropped
+// by a full queue, which would leave tud_task never being called again.
+static volatile bool usb_irq_pending = false;
+// Likewise a notification must never be dropped and background wake-ups are
+// only ever needed once per pass of the main loop.
+static volatile uint32_t pending_notifications = 0;
+static volatile bool background_pending = false;
+
+static void _otp_event_usb_irq()
+{
+    usb_irq_pending = true;
+    __sev();
+}
+
+void otp_event_init()
+{
+    queue_init(&event_queue, sizeof(otp_event_t), OTP_EVENT_QUEUE_LENGTH);
+    // Lowest order priority so TinyUSB's own handler has already run and
+    // queued its work before we wake the main loop.
+    irq_add_shared_handler(USBCTRL_IRQ, _otp_event_usb_irq, PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY);
+    // Always start with a pass through TinyUSB.
+    _otp_event_usb_irq();
+}
+
+bool otp_event_post(enum otp_event_type event_type, uint8_t data)
+{
+    if (event_type == OTP_EVENT_NOTIFY || event_type == OTP_EVENT_BACKGROUND)
+    {
+        // The increment is a read-modify-write so must not be interrupted by another post.
+        uint32_t status = save_and_disable_interrupts();
+        if (event_type == OTP_EVENT_NOTIFY)
+        {
+            pending_notifications++;
+        }
+        else
+        {
+            background_pending = true;
+        }
+        restore_interrupts(status);
+        __sev();
+
+        return true;
+    }
+
+    otp_event_t event = { .event_type = event_type, .data = data };
+    bool queued = queue_try_add(&event_queue, &event);
+    if (!queued)
+    {
+        dropped_count++;
+    }
+    // Wake the main loop even if dropped, it will still drain the queue.
+    __sev();
+
+    return queued;
+}
+
+bool otp_event_poll(otp_event_t *event)
+{
+    return queue_try_remove(&event_queue, event);
+}
+
+bool otp_event_take_usb_irq()
+{
+    if (!usb_irq_pending)
+    {
+        return false;
+    }
+
+    // Cleared before tud_task runs so an interrupt during it is not lost.
+    usb_irq_pending = false;
+
+    return true;
+}
+
+uint32_t otp_event_take_notifications()
+{
+    uint32_t status = save_and_disable_interrupts();
+    uint32_t notifications = pending_notifications;
+    pending_notifications = 0;
+    background_pending = false;
+    restore_interrupts(status);
+
+    return notifications;
+}
+
+void otp_event_wait()
+{
+    // If an event is posted between the check and the __wfe the __sev in
+    // otp_event_post leaves the event register set so __wfe returns immediately.
+    if (queue_is_empty(&event_queue) && !usb_irq_pending && pending_notifications == 0 && !background_pending)
+    {
+        __wfe();
+    }
+}
+
+uint32_t otp_event_dropped_count()
+{
+    return dropped_count;
+}
+
+/*
+ * TinyUSB Callbacks
+ *
+ * These are all called from tud_task within the main loop, data received or
+ * transfers completed need no event as otp_mgr_run checks for both after
+ * tud_task returns.
+ */
+
+void tud_mount_cb(void)
+{
+    boot_profile_mark(BOOT_PHASE_USB_MOUNTED);
+    otp_event_post(OTP_EVENT_USB_MOUNT, 0x00);
+}
+
+void tud_umount_cb(void)
+{
+    otp_event_post(OTP_EVENT_USB_UNMOUNT, 0x00);
+}
+
+void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
+{
+    otp_event_post(OTP_EVENT_CDC_LINE_STATE, (dtr ? 0x01 : 0x00) | (rts ? 0x02 : 0x00));
+}
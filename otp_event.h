@@ -0,0 +1,102 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+// OTP Event is a small multi-producer event queue used to wake the main loop.
+//
+// Producers may be interrupt handlers, TinyUSB callbacks or components running
+// in the main loop, the single consumer is the main loop itself.
+
+#ifndef OTP_EVENT_H
+#define OTP_EVENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OTP_EVENT_QUEUE_LENGTH 16
+
+enum otp_event_type
+{
+    OTP_EVENT_NONE = 0x00,
+    OTP_EVENT_USB_MOUNT = 0x02,      // The device was mounted by the host.
+    OTP_EVENT_USB_UNMOUNT = 0x03,    // The device was unmounted by the host.
+    OTP_EVENT_CDC_RX = 0x04,         // Data remains in the CDC RX FIFO after a pass.
+    OTP_EVENT_CDC_LINE_STATE = 0x05, // The CDC line state (DTR / RTS) changed.
+    OTP_EVENT_NOTIFY = 0x06,         // An asynchronous task has completed for OTP admin.
+    OTP_EVENT_BACKGROUND = 0x08,     // Background work remains, wake for another pass of the main loop.
+};
+
+struct otp_event
+{
+    uint8_t event_type; // enum otp_event_type
+    uint8_t data;       // Event specific data e.g. the line state.
+};
+
+typedef struct otp_event otp_event_t;
+
+/*
+ * Initialise the event queue and register for USB interrupts.
+ *
+ * Must be called after TinyUSB has been initialised.
+ */
+void otp_event_init();
+
+/*
+ * Post an event to the queue and wake the main loop.
+ *
+ * OTP_EVENT_NOTIFY and OTP_EVENT_BACKGROUND are never queued, they are counted
+ * and flagged instead so a burst of wake-ups can not fill the queue and cause
+ * a notification to be lost. Use otp_event_take_notifications for them.
+ *
+ * This function is safe to call from interrupt handlers.
+ *
+ * @returns true if the event was queued, false if the queue was full and the
+ *          event was dropped.
+ */
+bool otp_event_post(enum otp_event_type event_type, uint8_t data);
+
+/*
+ * Remove the next event from the queue.
+ *
+ * @returns true if an event was removed, false if the queue was empty.
+ */
+bool otp_event_poll(otp_event_t *event);
+
+/*
+ * USB interrupts are tracked by a flag rather than the queue.
+ *
+ * @returns true if the USB controller raised an interrupt since the last call,
+ *          TinyUSB has work for tud_task.
+ */
+bool otp_event_take_usb_irq();
+
+/*
+ * @returns The number of OTP_EVENT_NOTIFY posted since the last call, any
+ *          pending OTP_EVENT_BACKGROUND is cleared as the main loop is running.
+ */
+uint32_t otp_event_take_notifications();
+
+/*
+ * Sleep until an event is posted or a USB interrupt is raised, returns immediately if any events
+ * are already queued.
+ */
+void otp_event_wait();
+
+/*
+ * @returns The number of events dropped as the queue was full.
+ */
+uint32_t otp_event_dropped_count();
+
+#endif // OTP_EVENT_H
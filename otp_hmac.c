@@ -0,0 +1,400 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "otp_hmac.h"
+#include "otp_hot_path.h"
+
+#define SHA1_BLOCK_SIZE 64
+
+struct sha1
+{
+    uint32_t state[5];
+    uint8_t block[SHA1_BLOCK_SIZE];
+    uint8_t block_length;
+    uint64_t total_length;
+};
+
+static inline uint32_t _rotl(uint32_t value, uint8_t bits)
+{
+    return value << bits | value >> (32 - bits);
+}
+
+static void OTP_HOT_PATH(_sha1_compress)(struct sha1 *sha1)
+{
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *p = &sha1->block[i * 4];
+        w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+
+    uint32_t a = sha1->state[0], b = sha1->state[1], c = sha1->state[2], d = sha1->state[3], e = sha1->state[4];
+    for (int i = 0; i < 80; i++)
+    {
+        if (i >= 16)
+        {
+            // The message schedule is kept as a rolling window of 16 words.
+            w[i & 15] = _rotl(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+        }
+
+        uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t temp = _rotl(a, 5) + f + e + k + w[i & 15];
+        e = d;
+        d = c;
+        c = _rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    sha1->state[0] += a;
+    sha1->state[1] += b;
+    sha1->state[2] += c;
+    sha1->state[3] += d;
+    sha1->state[4] += e;
+}
+
+static void _sha1_init(struct sha1 *sha1)
+{
+    sha1->state[0] = 0x67452301;
+    sha1->state[1] = 0xEFCDAB89;
+    sha1->state[2] = 0x98BADCFE;
+    sha1->state[3] = 0x10325476;
+    sha1->state[4] = 0xC3D2E1F0;
+    sha1->block_length = 0;
+    sha1->total_length = 0;
+}
+
+static void OTP_HOT_PATH(_sha1_update)(struct sha1 *sha1, const uint8_t *data, uint32_t length)
+{
+    sha1->total_length += length;
+    while (length > 0)
+    {
+        uint32_t space = SHA1_BLOCK_SIZE - sha1->block_length;
+        uint32_t count = length < space ? length : space;
+        memcpy(&sha1->block[sha1->block_length], data, count);
+        sha1->block_length += count;
+        data += count;
+        length -= count;
+
+        if (sha1->block_length == SHA1_BLOCK_SIZE)
+        {
+            _sha1_compress(sha1);
+            sha1->block_length = 0;
+        }
+    }
+}
+
+static void OTP_HOT_PATH(_sha1_final)(struct sha1 *sha1, uint8_t *digest)
+{
+    uint64_t bits = sha1->total_length * 8;
+    uint8_t padding = 0x80;
+    _sha1_update(sha1, &padding, 1);
+    padding = 0x00;
+    while (sha1->block_length != SHA1_BLOCK_SIZE - 8)
+    {
+        _sha1_update(sha1, &padding, 1);
+    }
+
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++)
+    {
+        length[i] = bits >> (56 - i * 8);
+    }
+    _sha1_update(sha1, length, 8);
+
+    for (int i = 0; i < 5; i++)
+    {
+        digest[i * 4] = sha1->state[i] >> 24;
+        digest[i * 4 + 1] = sha1->state[i] >> 16;
+        digest[i * 4 + 2] = sha1->state[i] >> 8;
+        digest[i * 4 + 3] = sha1->state[i];
+    }
+}
+
+void OTP_HOT_PATH(otp_hmac_sha1)(const uint8_t *key, uint8_t key_length, const uint8_t *message, uint32_t message_length,
+    uint8_t *mac)
+{
+    uint8_t pad[SHA1_BLOCK_SIZE];
+    struct sha1 sha1;
+
+    // Inner hash, H((K ^ ipad) || message)
+    memset(pad, 0x36, SHA1_BLOCK_SIZE);
+    for (int i = 0; i < key_length && i < SHA1_BLOCK_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    _sha1_init(&sha1);
+    _sha1_update(&sha1, pad, SHA1_BLOCK_SIZE);
+    _sha1_update(&sha1, message, message_length);
+    _sha1_final(&sha1, mac);
+
+    // Outer hash, H((K ^ opad) || inner)
+    memset(pad, 0x5C, SHA1_BLOCK_SIZE);
+    for (int i = 0; i < key_length && i < SHA1_BLOCK_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    _sha1_init(&sha1);
+    _sha1_update(&sha1, pad, SHA1_BLOCK_SIZE);
+    _sha1_update(&sha1, mac, OTP_HMAC_SHA1_LENGTH);
+    _sha1_final(&sha1, mac);
+
+    otp_wipe(pad, SHA1_BLOCK_SIZE);
+    otp_wipe(&sha1, sizeof(sha1));
+}
+
+/*
+ * SHA-256
+ */
+
+static const uint32_t sha256_k[64] OTP_HOT_DATA =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static inline uint32_t _rotr(uint32_t value, uint8_t bits)
+{
+    return value >> bits | value << (32 - bits);
+}
+
+static void OTP_HOT_PATH(_sha256_compress)(struct otp_sha256 *sha256)
+{
+    uint32_t w[16];
+    for (int i = 0; i < 16; i++)
+    {
+        const uint8_t *p = &sha256->block[i * 4];
+        w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+
+    uint32_t a = sha256->state[0], b = sha256->state[1], c = sha256->state[2], d = sha256->state[3];
+    uint32_t e = sha256->state[4], f = sha256->state[5], g = sha256->state[6], h = sha256->state[7];
+    for (int i = 0; i < 64; i++)
+    {
+        if (i >= 16)
+        {
+            uint32_t w15 = w[(i + 1) & 15];
+            uint32_t w2 = w[(i + 14) & 15];
+            uint32_t s0 = _rotr(w15, 7) ^ _rotr(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = _rotr(w2, 17) ^ _rotr(w2, 19) ^ (w2 >> 10);
+            w[i & 15] += s0 + w[(i + 9) & 15] + s1;
+        }
+
+        uint32_t t1 = h + (_rotr(e, 6) ^ _rotr(e, 11) ^ _rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i & 15];
+        uint32_t t2 = (_rotr(a, 2) ^ _rotr(a, 13) ^ _rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    sha256->state[0] += a;
+    sha256->state[1] += b;
+    sha256->state[2] += c;
+    sha256->state[3] += d;
+    sha256->state[4] += e;
+    sha256->state[5] += f;
+    sha256->state[6] += g;
+    sha256->state[7] += h;
+}
+
+static void _sha256_init(struct otp_sha256 *sha256)
+{
+    static const uint32_t initial[8] =
+    {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+    memcpy(sha256->state, initial, sizeof(initial));
+    sha256->block_length = 0;
+    sha256->total_length = 0;
+}
+
+static void OTP_HOT_PATH(_sha256_update)(struct otp_sha256 *sha256, const uint8_t *data, uint32_t length)
+{
+    sha256->total_length += length;
+    while (length > 0)
+    {
+        uint32_t space = OTP_HMAC_BLOCK_SIZE - sha256->block_length;
+        uint32_t count = length < space ? length : space;
+        memcpy(&sha256->block[sha256->block_length], data, count);
+        sha256->block_length += count;
+        data += count;
+        length -= count;
+
+        if (sha256->block_length == OTP_HMAC_BLOCK_SIZE)
+        {
+            _sha256_compress(sha256);
+            sha256->block_length = 0;
+        }
+    }
+}
+
+static void OTP_HOT_PATH(_sha256_final)(struct otp_sha256 *sha256, uint8_t *digest)
+{
+    uint64_t bits = sha256->total_length * 8;
+
+    // Pad in place rather than a byte at a time, this is the hot path of PBKDF2.
+    uint8_t *block = sha256->block;
+    block[sha256->block_length++] = 0x80;
+    if (sha256->block_length > OTP_HMAC_BLOCK_SIZE - 8)
+    {
+        memset(&block[sha256->block_length], 0x00, OTP_HMAC_BLOCK_SIZE - sha256->block_length);
+        _sha256_compress(sha256);
+        sha256->block_length = 0;
+    }
+    memset(&block[sha256->block_length], 0x00, OTP_HMAC_BLOCK_SIZE - 8 - sha256->block_length);
+    for (int i = 0; i < 8; i++)
+    {
+        block[OTP_HMAC_BLOCK_SIZE - 8 + i] = bits >> (56 - i * 8);
+    }
+    _sha256_compress(sha256);
+
+    for (int i = 0; i < 8; i++)
+    {
+        digest[i * 4] = sha256->state[i] >> 24;
+        digest[i * 4 + 1] = sha256->state[i] >> 16;
+        digest[i * 4 + 2] = sha256->state[i] >> 8;
+        digest[i * 4 + 3] = sha256->state[i];
+    }
+}
+
+void otp_hmac_sha256_init(struct otp_hmac_sha256 *hmac, const uint8_t *key, uint8_t key_length)
+{
+    uint8_t pad[OTP_HMAC_BLOCK_SIZE];
+
+    memset(pad, 0x36, OTP_HMAC_BLOCK_SIZE);
+    for (int i = 0; i < key_length && i < OTP_HMAC_BLOCK_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    _sha256_init(&hmac->inner);
+    _sha256_update(&hmac->inner, pad, OTP_HMAC_BLOCK_SIZE);
+
+    memset(pad, 0x5C, OTP_HMAC_BLOCK_SIZE);
+    for (int i = 0; i < key_length && i < OTP_HMAC_BLOCK_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    _sha256_init(&hmac->outer);
+    _sha256_update(&hmac->outer, pad, OTP_HMAC_BLOCK_SIZE);
+
+    otp_wipe(pad, OTP_HMAC_BLOCK_SIZE);
+}
+
+void OTP_HOT_PATH(otp_hmac_sha256)(const struct otp_hmac_sha256 *hmac, const uint8_t *message, uint32_t message_length,
+    uint8_t *mac)
+{
+    struct otp_sha256 sha256;
+
+    memcpy(&sha256, &hmac->inner, sizeof(struct otp_sha256));
+    _sha256_update(&sha256, message, message_length);
+    _sha256_final(&sha256, mac);
+
+    memcpy(&sha256, &hmac->outer, sizeof(struct otp_sha256));
+    _sha256_update(&sha256, mac, OTP_HMAC_SHA256_LENGTH);
+    _sha256_final(&sha256, mac);
+}
+
+/*
+ * PBKDF2
+ */
+
+void otp_pbkdf2_begin(struct otp_pbkdf2 *pbkdf2, const uint8_t *password, uint8_t password_length,
+    const uint8_t *salt, uint8_t salt_length, uint32_t iterations)
+{
+    otp_hmac_sha256_init(&pbkdf2->hmac, password, password_length);
+
+    // U1 = HMAC(P, S || INT(1))
+    struct otp_sha256 sha256;
+    static const uint8_t block_index[4] = { 0x00, 0x00, 0x00, 0x01 };
+    memcpy(&sha256, &pbkdf2->hmac.inner, sizeof(struct otp_sha256));
+    _sha256_update(&sha256, salt, salt_length);
+    _sha256_update(&sha256, block_index, sizeof(block_index));
+    _sha256_final(&sha256, pbkdf2->u);
+    memcpy(&sha256, &pbkdf2->hmac.outer, sizeof(struct otp_sha256));
+    _sha256_update(&sha256, pbkdf2->u, OTP_HMAC_SHA256_LENGTH);
+    _sha256_final(&sha256, pbkdf2->u);
+
+    memcpy(pbkdf2->result, pbkdf2->u, OTP_HMAC_SHA256_LENGTH);
+    pbkdf2->completed = 1;
+    pbkdf2->iterations = iterations;
+}
+
+bool OTP_HOT_PATH(otp_pbkdf2_step)(struct otp_pbkdf2 *pbkdf2, uint32_t max_iterations)
+{
+    for (uint32_t i = 0; i < max_iterations && pbkdf2->completed < pbkdf2->iterations; i++)
+    {
+        otp_hmac_sha256(&pbkdf2->hmac, pbkdf2->u, OTP_HMAC_SHA256_LENGTH, pbkdf2->u);
+        for (int j = 0; j < OTP_HMAC_SHA256_LENGTH; j++)
+        {
+            pbkdf2->result[j] ^= pbkdf2->u[j];
+        }
+        pbkdf2->completed++;
+    }
+
+    return pbkdf2->completed >= pbkdf2->iterations;
+}
+
+void otp_pbkdf2_clear(struct otp_pbkdf2 *pbkdf2)
+{
+    otp_wipe(&pbkdf2->hmac, sizeof(struct otp_hmac_sha256));
+    otp_wipe(pbkdf2->u, OTP_HMAC_SHA256_LENGTH);
+    // The derived key itself, the callers have taken what they need from it.
+    otp_wipe(pbkdf2->result, OTP_HMAC_SHA256_LENGTH);
+}
+
+void OTP_HOT_PATH(otp_wipe)(void *data, uint32_t length)
+{
+    volatile uint8_t *bytes = data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        bytes[i] = 0x00;
+    }
+}
@@ -0,0 +1,104 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * HMAC for the OTP credentials and PIN.
+ *
+ * The assembly HOTP kernel in security/ returns the final 6 digits only, the
+ * credentials need the full MAC to truncate to their own digit count so the
+ * hash and HMAC are implemented here. SHA-256 is used for the PIN verifier.
+ */
+
+#ifndef OTP_HMAC_H
+#define OTP_HMAC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OTP_HMAC_SHA1_LENGTH 20
+#define OTP_HMAC_SHA256_LENGTH 32
+#define OTP_HMAC_BLOCK_SIZE 64
+
+struct otp_sha256
+{
+    uint32_t state[8];
+    uint8_t block[OTP_HMAC_BLOCK_SIZE];
+    uint8_t block_length;
+    uint64_t total_length;
+};
+
+/*
+ * HMAC-SHA256 with the padded key already absorbed, the key is processed once
+ * and the MAC of any number of messages then costs two compressions each for
+ * short messages.
+ */
+struct otp_hmac_sha256
+{
+    struct otp_sha256 inner;
+    struct otp_sha256 outer;
+};
+
+/*
+ * A PBKDF2-HMAC-SHA256 derivation of a single 32 byte block which can be run a
+ * slice at a time.
+ */
+struct otp_pbkdf2
+{
+    struct otp_hmac_sha256 hmac;
+    uint8_t u[OTP_HMAC_SHA256_LENGTH];      // The previous iteration.
+    uint8_t result[OTP_HMAC_SHA256_LENGTH]; // The XOR of every iteration so far.
+    uint32_t completed;
+    uint32_t iterations;
+};
+
+/*
+ * Calculate the HMAC-SHA1 of the message, keys longer than the 64 byte block
+ * are not supported as OTP secrets are at most 20 bytes.
+ */
+void otp_hmac_sha1(const uint8_t *key, uint8_t key_length, const uint8_t *message, uint32_t message_length,
+    uint8_t *mac);
+
+void otp_hmac_sha256_init(struct otp_hmac_sha256 *hmac, const uint8_t *key, uint8_t key_length);
+
+void otp_hmac_sha256(const struct otp_hmac_sha256 *hmac, const uint8_t *message, uint32_t message_length,
+    uint8_t *mac);
+
+/*
+ * Begin a derivation, the password is only used within this call.
+ */
+void otp_pbkdf2_begin(struct otp_pbkdf2 *pbkdf2, const uint8_t *password, uint8_t password_length,
+    const uint8_t *salt, uint8_t salt_length, uint32_t iterations);
+
+/*
+ * Run up to max_iterations further iterations.
+ *
+ * @returns true once all iterations are complete and result is valid.
+ */
+bool otp_pbkdf2_step(struct otp_pbkdf2 *pbkdf2, uint32_t max_iterations);
+
+/*
+ * Clear any key material from the derivation, including the result.
+ */
+void otp_pbkdf2_clear(struct otp_pbkdf2 *pbkdf2);
+
+/*
+ * Zero memory holding key material, written through a volatile pointer so
+ * the compiler can not drop it as a dead store before a buffer goes out of scope.
+ */
+void otp_wipe(void *data, uint32_t length);
+
+#endif // OTP_HMAC_H
@@ -0,0 +1,43 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Placement of hot paths in SRAM.
+ *
+ * Functions marked OTP_HOT_PATH are placed in the SDK's .time_critical section,
+ * which the linker script copies to SRAM at start up, so they never wait on an
+ * XIP cache miss. Tables they read on every call are marked OTP_HOT_DATA so the
+ * loads avoid the cache as well.
+ *
+ * Build with OTP_HOT_PATHS_IN_FLASH defined to leave them executing in place,
+ * the Performance screen then shows the cost of the misses.
+ */
+
+#ifndef OTP_HOT_PATH_H
+#define OTP_HOT_PATH_H
+
+#include "pico/platform.h"
+
+#ifdef OTP_HOT_PATHS_IN_FLASH
+#define OTP_HOT_PATH(name) name
+#define OTP_HOT_DATA
+#else
+#define OTP_HOT_PATH(name) __not_in_flash_func(name)
+#define OTP_HOT_DATA __not_in_flash("otp_hot")
+#endif
+
+#endif // OTP_HOT_PATH_H
@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "otp_log.h"
 #include "pico_ward.h"
 
 #define OTP_DISPLAY_CONTEXT_ID 0xAE
@@ -41,7 +42,7 @@ bool otp_input_begin(pico_ward_context_t *pico_ward_context_t)
     struct _otp_input_context *context = (struct _otp_input_context*) access_otp_input_context(pico_ward_context_t);
     if (context->common_context.id != OTP_DISPLAY_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_input_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_input_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
@@ -52,7 +53,7 @@ void otp_input_run(otp_input_context_t *input_context)
 {
     if (input_context->id != OTP_DISPLAY_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_input_run 0x%02x\n", input_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_input_run 0x%02x\n", input_context->id);
         return;
     }
 
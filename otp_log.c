@@ -0,0 +1,153 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "pico/stdio.h"
+#include "pico/stdlib.h"
+
+#include "otp_log.h"
+
+#define OTP_LOG_RING_MASK (OTP_LOG_RING_LENGTH - 1)
+
+// SysTick is a 24 bit down counter.
+#define SYSTICK_MASK 0x00FFFFFF
+#define SYSTICK_CSR_ENABLE 0x01
+#define SYSTICK_CSR_CLKSOURCE 0x04
+
+struct otp_log_record
+{
+    const char *format;     // The address of the format string, doubles as its ID.
+    uint32_t timestamp_us;
+    uint8_t level;
+    uint8_t argc;
+    uint32_t args[OTP_LOG_MAX_ARGS];
+};
+
+// Records may be written from interrupt handlers, the ring is only read by the main loop.
+static struct otp_log_record ring[OTP_LOG_RING_LENGTH];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+static struct otp_log_stats log_stats = { 0 };
+
+void otp_log_init()
+{
+    head = 0;
+    tail = 0;
+    memset(&log_stats, 0x00, sizeof(struct otp_log_stats));
+
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_CSR_ENABLE | SYSTICK_CSR_CLKSOURCE;
+}
+
+void otp_log_write(uint8_t level, const char *format, uint8_t argc, ...)
+{
+    uint32_t start = systick_hw->cvr;
+    uint32_t interrupts = save_and_disable_interrupts();
+
+    if (head - tail >= OTP_LOG_RING_LENGTH)
+    {
+        log_stats.dropped++;
+        restore_interrupts(interrupts);
+        return;
+    }
+
+    struct otp_log_record *record = &ring[head & OTP_LOG_RING_MASK];
+    record->format = format;
+    record->timestamp_us = time_us_32();
+    record->level = level;
+    record->argc = argc;
+
+    va_list args;
+    va_start(args, argc);
+    for (int i = 0; i < argc; i++)
+    {
+        record->args[i] = va_arg(args, uint32_t);
+    }
+    va_end(args);
+
+    head++;
+    log_stats.records++;
+
+    uint32_t cycles = (start - systick_hw->cvr) & SYSTICK_MASK;
+    log_stats.total_cycles += cycles;
+    if (cycles > log_stats.max_cycles)
+    {
+        log_stats.max_cycles = cycles;
+    }
+
+    restore_interrupts(interrupts);
+}
+
+#ifdef OTP_LOG_BINARY
+static void _put_uint32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        putchar_raw(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+static void _output_record(struct otp_log_record *record)
+{
+    putchar_raw(OTP_LOG_FRAME_MARKER_0);
+    putchar_raw(OTP_LOG_FRAME_MARKER_1);
+    putchar_raw((record->level << 4) | record->argc);
+    _put_uint32(record->timestamp_us);
+    _put_uint32((uint32_t)(uintptr_t)record->format);
+    for (int i = 0; i < record->argc; i++)
+    {
+        _put_uint32(record->args[i]);
+    }
+}
+#else
+static const char level_names[] = { '-', 'E', 'W', 'I', 'D' };
+
+static void _output_record(struct otp_log_record *record)
+{
+    uint32_t *args = record->args;
+    printf("[%10u] %c ", record->timestamp_us,
+        record->level < sizeof(level_names) ? level_names[record->level] : '?');
+    // Unused arguments are ignored by printf.
+    printf(record->format, args[0], args[1], args[2], args[3], args[4], args[5]);
+}
+#endif
+
+bool otp_log_drain(uint32_t max_records)
+{
+    // Only the main loop advances tail so the record can be output in place.
+    for (uint32_t i = 0; i < max_records && tail != head; i++)
+    {
+        _output_record(&ring[tail & OTP_LOG_RING_MASK]);
+        tail++;
+    }
+
+    return tail != head;
+}
+
+void otp_log_get_stats(struct otp_log_stats *stats)
+{
+    uint32_t interrupts = save_and_disable_interrupts();
+    memcpy(stats, &log_stats, sizeof(struct otp_log_stats));
+    restore_interrupts(interrupts);
+}
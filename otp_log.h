@@ -0,0 +1,121 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+// OTP Log is a deferred logging facility for use in hot paths.
+//
+// Rather than formatting and writing to the UART at the point of the call a
+// log statement stores a small fixed size record in a RAM ring, the record
+// holds the address of the format string, a timestamp and up to
+// OTP_LOG_MAX_ARGS 32 bit arguments. The ring is drained by the main loop
+// when it is otherwise idle.
+//
+// Levels above OTP_LOG_LEVEL are removed at compile time, arguments to a
+// removed statement are still type checked but are never evaluated.
+//
+// As formatting is deferred the following restrictions apply:
+//  - Arguments must be 32 bits or smaller. A 64 bit argument is passed in an
+//    aligned register pair which shifts every later argument, so 64 bit values
+//    are not allowed and must be cast to uint32_t at the call site.
+//  - Any %s argument must have a static lifetime, e.g. a string literal.
+//
+// With OTP_LOG_BINARY defined the drained records are written as binary frames
+// instead of text, tools/otp_log_decode.py converts the frames back to text
+// using the format strings from the firmware image.
+
+#ifndef OTP_LOG_H
+#define OTP_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OTP_LOG_LEVEL_NONE 0
+#define OTP_LOG_LEVEL_ERROR 1
+#define OTP_LOG_LEVEL_WARN 2
+#define OTP_LOG_LEVEL_INFO 3
+#define OTP_LOG_LEVEL_DEBUG 4
+
+#ifndef OTP_LOG_LEVEL
+#define OTP_LOG_LEVEL OTP_LOG_LEVEL_INFO
+#endif
+
+#define OTP_LOG_RING_LENGTH 64 // Must be a power of 2.
+#define OTP_LOG_MAX_ARGS 6
+#define OTP_LOG_DRAIN_BATCH 4
+
+// Binary frames start with this two byte marker.
+#define OTP_LOG_FRAME_MARKER_0 0xA5
+#define OTP_LOG_FRAME_MARKER_1 0x5A
+
+struct otp_log_stats
+{
+    uint32_t records;     // Records written to the ring.
+    uint32_t dropped;     // Records dropped as the ring was full.
+    uint32_t max_cycles;  // The most cycles spent writing a single record.
+    uint32_t total_cycles; // Total cycles spent writing records.
+};
+
+/*
+ * Initialise the log ring and start SysTick as a free running cycle counter
+ * used to measure the cost of each log statement.
+ */
+void otp_log_init();
+
+/*
+ * Write a record to the log ring, this should not be called directly instead
+ * use one of the OTP_LOG_* macros.
+ *
+ * This function is safe to call from interrupt handlers.
+ */
+void otp_log_write(uint8_t level, const char *format, uint8_t argc, ...);
+
+/*
+ * Drain up to max_records records from the log ring to stdio.
+ *
+ * @returns true if records remain in the ring.
+ */
+bool otp_log_drain(uint32_t max_records);
+
+void otp_log_get_stats(struct otp_log_stats *stats);
+
+#define _OTP_LOG_ARGC(...) _OTP_LOG_ARGC_N(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define _OTP_LOG_ARGC_N(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define _OTP_LOG(level, format, ...) otp_log_write(level, format, _OTP_LOG_ARGC(__VA_ARGS__), ##__VA_ARGS__)
+
+#if OTP_LOG_LEVEL >= OTP_LOG_LEVEL_ERROR
+#define OTP_LOG_ERROR(format, ...) _OTP_LOG(OTP_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define OTP_LOG_ERROR(format, ...) do { if (0) _OTP_LOG(OTP_LOG_LEVEL_ERROR, format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if OTP_LOG_LEVEL >= OTP_LOG_LEVEL_WARN
+#define OTP_LOG_WARN(format, ...) _OTP_LOG(OTP_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define OTP_LOG_WARN(format, ...) do { if (0) _OTP_LOG(OTP_LOG_LEVEL_WARN, format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if OTP_LOG_LEVEL >= OTP_LOG_LEVEL_INFO
+#define OTP_LOG_INFO(format, ...) _OTP_LOG(OTP_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define OTP_LOG_INFO(format, ...) do { if (0) _OTP_LOG(OTP_LOG_LEVEL_INFO, format, ##__VA_ARGS__); } while (0)
+#endif
+
+#if OTP_LOG_LEVEL >= OTP_LOG_LEVEL_DEBUG
+#define OTP_LOG_DEBUG(format, ...) _OTP_LOG(OTP_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define OTP_LOG_DEBUG(format, ...) do { if (0) _OTP_LOG(OTP_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__); } while (0)
+#endif
+
+#endif // OTP_LOG_H
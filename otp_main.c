@@ -19,6 +19,13 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "pico/rand.h"
+#include "pico/stdlib.h"
+
+#include "boot_profile.h"
+#include "clock_policy.h"
+#include "otp_hmac.h"
+#include "otp_log.h"
 #include "otp_main.h"
 #include "otp_storage.h"
 #include "pico_otp.h" // TODO Will this component replase pico_otp? 20250628 Yes I think so.
@@ -30,10 +37,27 @@
 #define TASK_CHECK_PIN = 0x01
 
 
+// The PIN derivation is run in slices of about this long so the main loop stays responsive.
+#define OTP_MAIN_SLICE_US 1000
+// Iterations between checks of the time within a slice.
+#define OTP_MAIN_SLICE_ITERATIONS 8
+
+// The target time to derive a PIN, the iterations are calibrated to this on first boot.
+#ifndef OTP_MAIN_PIN_TARGET_MS
+#define OTP_MAIN_PIN_TARGET_MS 250
+#endif
+
+#ifndef OTP_MAIN_PIN_MIN_ITERATIONS
+#define OTP_MAIN_PIN_MIN_ITERATIONS 1000
+#endif
+
+#define OTP_MAIN_DEFAULT_PIN "123456"
+
 enum task_id
 {
     none = 0x00,
-    validate_pin = 0x01
+    validate_pin = 0x01,
+    set_pin = 0x02
 };
 struct base_task
 {
@@ -42,17 +66,22 @@ struct base_task
     void *handback; // The handback to pass to the callback.
 };
 
-struct validate_pin_task
+/*
+ * Both validating and setting a PIN derive a hash from it, the derivation is
+ * started as the task is registered so the PIN itself is not retained.
+ */
+struct pin_task
 {
     struct base_task base_task; // The base task structure.
-    char *pin; // The pin to validate, 8 characters plus null terminator.
+    struct otp_pbkdf2 pbkdf2;
+    struct pin_verifier pin_verifier; // The salt and iterations in use.
+    bool calibrate; // Measure the first slice to choose the iterations.
 };
 
 union main_task
 {
     struct base_task base_task;
-    struct validate_pin_task validate_pin_task; // The validate pin task.
-
+    struct pin_task pin_task; // The validate or set pin task.
 };
 
 struct _otp_main_context
@@ -60,8 +89,135 @@ struct _otp_main_context
     struct common_context common_context;
     otp_core_t otp_core;
     union main_task main_task;
+    otp_storage_context_t *storage_context;
+    bool root_mounted; // The root record has been loaded or the default PIN started.
+    bool root_damaged; // The root record could not be used so nothing can be unlocked.
 };
 
+static void _new_salt(uint8_t *salt)
+{
+    rng_128_t random;
+    get_rand_128(&random);
+    memcpy(salt, &random, PICO_OTP_PIN_SALT_LENGTH);
+}
+
+static void _begin_pin_task(struct _otp_main_context *context, enum task_id task_id, const char *pin,
+    uint32_t iterations, otp_main_callback callback, void *handback)
+{
+    struct pin_task *pin_task = &context->main_task.pin_task;
+    pin_task->base_task.task_id = task_id;
+    pin_task->base_task.callback = callback;
+    pin_task->base_task.handback = handback;
+    pin_task->calibrate = false;
+
+    if (task_id == validate_pin)
+    {
+        memcpy(&pin_task->pin_verifier, pico_otp_get_pin_verifier(&context->otp_core), sizeof(struct pin_verifier));
+    }
+    else
+    {
+        // A new PIN always gets a new salt.
+        _new_salt(pin_task->pin_verifier.salt);
+        // Until calibrated run without limit, the iterations are set after the first slice.
+        pin_task->pin_verifier.iterations = iterations > 0 ? iterations : UINT32_MAX;
+    }
+
+    otp_pbkdf2_begin(&pin_task->pbkdf2, (const uint8_t*) pin, strlen(pin), pin_task->pin_verifier.salt,
+        PICO_OTP_PIN_SALT_LENGTH, pin_task->pin_verifier.iterations);
+    // Held for every slice, calibration also runs boosted so the target time holds.
+    clock_policy_boost(CLOCK_OP_KDF);
+}
+
+/*
+ * Run iterations of the PIN derivation for up to OTP_MAIN_SLICE_US.
+ *
+ * @returns true if the derivation is complete.
+ */
+static bool _run_pin_slice(struct pin_task *pin_task)
+{
+    struct otp_pbkdf2 *pbkdf2 = &pin_task->pbkdf2;
+    uint32_t start_us = time_us_32();
+    uint32_t start_iterations = pbkdf2->completed;
+    uint32_t elapsed_us;
+    bool complete;
+    do
+    {
+        complete = otp_pbkdf2_step(pbkdf2, OTP_MAIN_SLICE_ITERATIONS);
+        elapsed_us = time_us_32() - start_us;
+    } while (!complete && elapsed_us < OTP_MAIN_SLICE_US);
+
+    if (pin_task->calibrate)
+    {
+        uint64_t iterations = (uint64_t)(pbkdf2->completed - start_iterations) * OTP_MAIN_PIN_TARGET_MS * 1000 /
+            (elapsed_us > 0 ? elapsed_us : 1);
+        if (iterations < OTP_MAIN_PIN_MIN_ITERATIONS)
+        {
+            iterations = OTP_MAIN_PIN_MIN_ITERATIONS;
+        }
+        pin_task->pin_verifier.iterations = iterations;
+        pbkdf2->iterations = iterations;
+        pin_task->calibrate = false;
+        OTP_LOG_INFO("PIN iterations calibrated to %d for %d ms\n", (uint32_t) iterations, OTP_MAIN_PIN_TARGET_MS);
+        complete = pbkdf2->completed >= iterations;
+    }
+
+    return complete;
+}
+
+static void _complete_pin_task(struct _otp_main_context *context)
+{
+    struct pin_task *pin_task = &context->main_task.pin_task;
+    otp_core_t *otp_core = &context->otp_core;
+
+    // Separate keys for the verifier and for wrapping the data key so the
+    // stored verifier reveals nothing about the wrapping key.
+    struct otp_hmac_sha256 hmac;
+    uint8_t hash[OTP_HMAC_SHA256_LENGTH];
+    uint8_t wrapping_key[OTP_HMAC_SHA256_LENGTH];
+    otp_hmac_sha256_init(&hmac, pin_task->pbkdf2.result, OTP_HMAC_SHA256_LENGTH);
+    otp_hmac_sha256(&hmac, (const uint8_t*) "verify", 6, hash);
+    otp_hmac_sha256(&hmac, (const uint8_t*) "wrap", 4, wrapping_key);
+
+    int result = 0;
+    if (pin_task->base_task.task_id == validate_pin)
+    {
+        // The session key is only unwrapped for a matching PIN.
+        result = pico_otp_pin_matches(otp_core, hash) && pico_otp_begin_session(otp_core, wrapping_key) ? 0 : -1;
+    }
+    else if (pico_otp_wrap_data_key(otp_core, wrapping_key))
+    {
+        memcpy(pin_task->pin_verifier.hash, hash, OTP_HMAC_SHA256_LENGTH);
+        pico_otp_set_pin_verifier(otp_core, &pin_task->pin_verifier);
+        boot_profile_mark(BOOT_PHASE_PIN_READY);
+        if (!pico_otp_store_root(otp_core))
+        {
+            // otp_main_set_pin refuses a locked record so storage failed to mount.
+            OTP_LOG_ERROR("No storage for the root record, PIN held in RAM only.\n");
+        }
+    }
+    else
+    {
+        OTP_LOG_ERROR("No session to re-wrap the data key, PIN unchanged.\n");
+        result = -1;
+    }
+
+    otp_wipe(&hmac, sizeof(hmac));
+    otp_wipe(hash, sizeof(hash));
+    otp_wipe(wrapping_key, sizeof(wrapping_key));
+    clock_policy_release(CLOCK_OP_KDF);
+
+    otp_main_callback callback = pin_task->base_task.callback;
+    void *handback = pin_task->base_task.handback;
+    otp_pbkdf2_clear(&pin_task->pbkdf2);
+    memset(&pin_task->pin_verifier, 0x00, sizeof(struct pin_verifier));
+    // Clear the task ID before the callback so it can register another task.
+    context->main_task.base_task.task_id = none;
+    if (callback != NULL)
+    {
+        callback(result, handback);
+    }
+}
+
 otp_main_context_t* otp_main_init()
 {
     struct _otp_main_context *context = malloc(sizeof(struct _otp_main_context));
@@ -69,21 +225,28 @@ otp_main_context_t* otp_main_init()
     context->otp_core.id = OTP_CORE_CONTEXT_ID;
     context->main_task.base_task.task_id = none; // Initialise the task ID to none.
 
-    uint32_t i;
-
     // This struct contains data such as the management pin and the HOTP secret / counter,
     // for now these are initialised as the program starts but later this data will be retrieved
     // from storage possibly on demand.
     otp_core_t *otp_core = &context->otp_core;
 
-    // Clear the pin - TODO - This is a temporary measure to ensure the pin is cleared.
-    for (i = 0; i < 9; i++)
-    {
-        otp_core->pin[i] = 0x00;
-    }
+    // The verifier for the default PIN is derived by otp_main_begin.
+    memset(&otp_core->pin_verifier, 0x00, sizeof(struct pin_verifier));
+    otp_core->pin_set = false;
+    otp_core->data_key_wrapped = false;
+    otp_core->root_stored = false;
+    otp_core->flash_ready = false;
+    otp_core->root_internal = false;
+    otp_core->root_lock_cached = false;
+    context->root_mounted = false;
+    context->root_damaged = false;
+    pico_otp_end_session(otp_core);
     otp_core->hotp_secret_length = 0;
-
-    strncpy(otp_core->pin, "123456", 6);
+    otp_core->hotp_next_valid = false;
+    otp_core->credential_count = 0;
+    otp_core->credential_index = credential_index_init(PICO_OTP_MAX_CREDENTIALS);
+    otp_core->time_set = false;
+    otp_core->time_offset_us = 0;
 
     return (otp_main_context_t*) context;
 }
@@ -93,7 +256,7 @@ bool otp_main_begin(pico_ward_context_t *pico_ward_context)
     struct _otp_main_context *context = (struct _otp_main_context*) access_otp_main_context(pico_ward_context);
     if (context->common_context.id != OTP_MAIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_main_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_main_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
@@ -103,54 +266,121 @@ bool otp_main_begin(pico_ward_context_t *pico_ward_context)
     // Further OTP Core Initialisation
     otp_core->flash_context = otp_storage_get_flash_context(storage_context);
     otp_core->storage_context = otp_storage_get_storage_context(storage_context);
+    // The root record is mounted from otp_main_run once the flash is ready.
+    context->storage_context = storage_context;
 
     return true;
 }
 
+static void _mount_root(struct _otp_main_context *context)
+{
+    enum otp_storage_state state = otp_storage_get_state(context->storage_context);
+    if (state == OTP_STORAGE_MOUNTING)
+    {
+        return;
+    }
+
+    otp_core_t *otp_core = &context->otp_core;
+    // Without the external flash storage is on the internal flash, which has no
+    // security registers so the root record is kept in a reserved sector.
+    bool external = otp_storage_external_flash(context->storage_context);
+    otp_core->flash_ready = state == OTP_STORAGE_READY && external;
+    otp_core->root_internal = state == OTP_STORAGE_READY && !external;
+    context->root_mounted = true;
+    enum pico_otp_root_status status = pico_otp_mount_root(otp_core);
+    if (status == PICO_OTP_ROOT_MOUNTED)
+    {
+        boot_profile_mark(BOOT_PHASE_ROOT_MOUNTED);
+        boot_profile_mark(BOOT_PHASE_PIN_READY);
+    }
+    else if (status == PICO_OTP_ROOT_DAMAGED)
+    {
+        // The record may hold the only copy of the wrapped data key so it is left
+        // alone, without a verifier no PIN is accepted and the PIN can not be set.
+        context->root_damaged = true;
+        OTP_LOG_ERROR("Root record damaged, refusing to unlock.\n");
+    }
+    else
+    {
+        // No root record for this device so derive a verifier for the default
+        // PIN, the first slice calibrates the iterations for this device.
+        _begin_pin_task(context, set_pin, OTP_MAIN_DEFAULT_PIN, 0, NULL, NULL);
+        context->main_task.pin_task.calibrate = true;
+    }
+}
+
 void otp_main_run(otp_main_context_t *main_context)
 {
     if (main_context->id != OTP_MAIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_main_run 0x%02x\n", main_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_main_run 0x%02x\n", main_context->id);
         return;
     }
 
     struct _otp_main_context *context = (struct _otp_main_context*)main_context;
 
+    if (!context->root_mounted)
+    {
+        _mount_root(context);
+    }
+
     switch (context->main_task.base_task.task_id)
     {
         case none:
-            // No task to run.
+            // No task to run, use the time to have the next HOTP code ready.
+            if (pico_otp_precompute(&context->otp_core))
+            {
+                OTP_LOG_DEBUG("Precomputed HOTP code.\n");
+            }
             break;
 
         case validate_pin:
-            printf("Running validate pin task.\n");
-            // Validate the PIN.
-            if (pico_otp_validate_pin(&context->otp_core, context->main_task.validate_pin_task.pin))
-            {
-                // Call the callback with success.
-                context->main_task.validate_pin_task.base_task.callback(0, context->main_task.validate_pin_task.base_task.handback);
-            }
-            else
+        case set_pin:
+            // A slice at a time, otp_main_idle keeps the main loop awake until complete.
+            if (_run_pin_slice(&context->main_task.pin_task))
             {
-                // Call the callback with failure.
-                context->main_task.validate_pin_task.base_task.callback(-1, context->main_task.validate_pin_task.base_task.handback);
+                OTP_LOG_DEBUG("PIN task complete.\n");
+                _complete_pin_task(context);
             }
-            // Clear the task ID.
-            context->main_task.base_task.task_id = none;
             break;
 
         default:
-            printf("Unknown task ID 0x%02x\n", context->main_task.base_task.task_id);
+            OTP_LOG_ERROR("Unknown task ID 0x%02x\n", context->main_task.base_task.task_id);
             break;
     }
 }
 
+bool otp_main_idle(otp_main_context_t *main_context)
+{
+    if (main_context->id != OTP_MAIN_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_main_idle 0x%02x\n", main_context->id);
+        return true;
+    }
+
+    struct _otp_main_context *context = (struct _otp_main_context*)main_context;
+
+    return context->main_task.base_task.task_id == none;
+}
+
+bool otp_main_root_damaged(otp_main_context_t *main_context)
+{
+    if (main_context->id != OTP_MAIN_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_main_root_damaged 0x%02x\n", main_context->id);
+        return false;
+    }
+
+    struct _otp_main_context *context = (struct _otp_main_context*)main_context;
+
+    return context->root_damaged;
+}
+
 otp_core_t* otp_main_get_otp_core(otp_main_context_t *main_context)
 {
     if (main_context->id != OTP_MAIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_main_get_otp_core 0x%02x\n", main_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_main_get_otp_core 0x%02x\n", main_context->id);
         return 0x00;
     }
 
@@ -163,21 +393,47 @@ bool otp_main_validate_pin(otp_main_context_t *main_context, char *pin, otp_main
 {
     if (main_context->id != OTP_MAIN_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_main_validate_pin 0x%02x\n", main_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_main_validate_pin 0x%02x\n", main_context->id);
         return false;
     }
 
     struct _otp_main_context *context = (struct _otp_main_context*) main_context;
-    if (context->main_task.base_task.task_id == none)
+    // Whilst the default PIN is still being derived there is nothing to validate against.
+    if (context->main_task.base_task.task_id == none && pico_otp_pin_set(&context->otp_core))
     {
-        printf("Registering validate pin task.\n");
-        context->main_task.validate_pin_task.base_task.task_id = validate_pin;
-        context->main_task.validate_pin_task.base_task.callback = callback;
-        context->main_task.validate_pin_task.base_task.handback = handback;
-        context->main_task.validate_pin_task.pin = pin;
+        OTP_LOG_DEBUG("Registering validate pin task.\n");
+        _begin_pin_task(context, validate_pin, pin, 0, callback, handback);
 
         return true;
     }
 
     return false; // Validate PIN task was not registered.
+}
+
+bool otp_main_set_pin(otp_main_context_t *main_context, char *pin, otp_main_callback callback, void *handback)
+{
+    if (main_context->id != OTP_MAIN_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_main_set_pin 0x%02x\n", main_context->id);
+        return false;
+    }
+
+    struct _otp_main_context *context = (struct _otp_main_context*) main_context;
+    if (pico_otp_root_locked(&context->otp_core))
+    {
+        OTP_LOG_ERROR("Root record locked, the PIN can not be changed.\n");
+        return false;
+    }
+
+    if (context->main_task.base_task.task_id == none && pico_otp_pin_set(&context->otp_core))
+    {
+        OTP_LOG_DEBUG("Registering set pin task.\n");
+        // The iterations calibrated on first boot are kept.
+        _begin_pin_task(context, set_pin, pin, pico_otp_get_pin_verifier(&context->otp_core)->iterations,
+            callback, handback);
+
+        return true;
+    }
+
+    return false; // Set PIN task was not registered.
 }
\ No newline at end of file
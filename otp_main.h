@@ -47,6 +47,20 @@ bool otp_main_begin(pico_ward_context_t *pico_ward_context);
  */
 void otp_main_run(otp_main_context_t *main_context);
 
+/**
+ * Is the main component idle?
+ *
+ * @returns true if no task is waiting to be run, false otherwise.
+ */
+bool otp_main_idle(otp_main_context_t *main_context);
+
+/*
+ * Was the root record present but unreadable, corrupt or from another device?
+ *
+ * @returns true if so, no PIN will be accepted.
+ */
+bool otp_main_root_damaged(otp_main_context_t *main_context);
+
 // TODO - This will go - instead callers should obtain a reference to the context for OTP main.
 otp_core_t* otp_main_get_otp_core(otp_main_context_t *main_context);
 
@@ -55,6 +69,20 @@ typedef void (*otp_main_callback)(int result, void *handback);
 // Main Functions for OTP main context.
 // These functions are all asynchronous so they should not block and
 // instead set up a task for the run loop.
+
+/*
+ * Validate the PIN, the derivation runs in slices from otp_main_run and the callback
+ * is called with 0 if the PIN matches or -1 if it does not.
+ *
+ * @returns false if another task is running, including the initial derivation of the default PIN.
+ */
 bool otp_main_validate_pin(otp_main_context_t *main_context, char *pin, otp_main_callback callback, void *handback);
 
+/*
+ * Replace the PIN with a new salt, the callback is called with 0 once the new verifier is in place.
+ *
+ * @returns false if another task is running.
+ */
+bool otp_main_set_pin(otp_main_context_t *main_context, char *pin, otp_main_callback callback, void *handback);
+
 #endif // OTP_MAIN_H
\ No newline at end of file
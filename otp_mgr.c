@@ -18,13 +18,30 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "boot_profile.h"
+#include "cdc_tx_ring.h"
+#include "clock_policy.h"
+#include "flash_browser.h"
+#include "flash_device.h"
+#include "flash_erase.h"
+#include "flash_power.h"
+#include "flash_scan.h"
 #include "otp_admin.h"
+#include "otp_event.h"
+#include "otp_log.h"
 #include "otp_main.h"
 #include "otp_mgr.h"
+#include "otp_perf.h"
+#include "otpauth.h"
 #include "pico_otp.h"
+#include "pico/time.h"
+#include "screen_buffer.h"
+#include "storage_backend.h"
+#include "tusb.h"
 #include "term/terminal_handler.h"
 #include "term/vt102.h"
 #include "util/hexutil.h"
+#include "vt102_decoder.h"
 
 
 struct otp_mgr_context;
@@ -45,15 +62,55 @@ typedef bool (*screen_handler)(vt102_event *event, struct otp_mgr_context *conte
  * @param context The otp_mgr_context pointer.
  */
 typedef void (*full_renderer)(struct otp_mgr_context *context);
-struct base_screen_details
+
+/**
+ * Optional batch handler for screens which accept runs of characters such as a paste.
+ *
+ * Characters are handled in order, if the screen changes part way through the remaining
+ * characters are passed to the new screen.
+ *
+ * @param characters The run of characters received.
+ * @param length The number of characters, always at least 1.
+ * @param context The OTP Manager context.
+ * @param redraw Set to true if the screen should be redrawn.
+ * @return The number of characters consumed, must be at least 1.
+ */
+typedef uint32_t (*screen_batch_handler)(const char *characters, uint32_t length,
+    struct otp_mgr_context *context, bool *redraw);
+
+/**
+ * Optional function called as a screen is entered, either by navigating to it or by
+ * returning to it, used to reset the state of the screen.
+ *
+ * @param context The OTP Manager context.
+ */
+typedef void (*screen_enter)(struct otp_mgr_context *context);
+
+/**
+ * Optional background work for a screen, called on each pass of the main loop while
+ * the screen is current.
+ *
+ * @param context The OTP Manager context.
+ * @param redraw Set to true if the screen should be redrawn.
+ * @return true if background work remains and the main loop should not sleep.
+ */
+typedef bool (*screen_background)(struct otp_mgr_context *context, bool *redraw);
+
+/*
+ * Each screen is described by a static const descriptor so the descriptors remain in
+ * flash, switching screen is a case of switching the descriptor pointer.
+ */
+struct screen_descriptor
 {
-    char* program_name;
-    char* screen_name;
-    char* error_message;
-    char* commands;
-    char* footer;
+    const char* program_name;
+    const char* screen_name;
+    const char* commands;
+    const char* footer;
     screen_handler handler;
+    screen_batch_handler batch_handler;
     full_renderer renderer;
+    screen_enter enter;
+    screen_background background;
 };
 
 enum login_screen_state
@@ -64,64 +121,170 @@ enum login_screen_state
     invalid
 };
 
+/*
+ * The per screen state, only the screen at the top of the navigation stack
+ * has state so these share a single union.
+ */
+
 struct login_screen
 {
-    struct base_screen_details base_screen_details;
     char entered_pin[9];
-    enum login_screen_state state;
+    uint8_t state; // enum login_screen_state
 };
 
 struct generate_otp_screen
 {
-    struct base_screen_details base_screen_details;
-    char otp[7];
+    char otp[OTP_MAX_DIGITS + 1];
+    bool precomputed;      // The last code came from the precompute cache.
+    uint32_t requested_us; // When the last code was requested, 0 once rendered.
+    uint32_t latency_us;   // From the request to the code being rendered.
+};
+
+struct otp_information_screen
+{
+    struct otp_truncate_benchmark benchmark;
+    struct otp_crypt_benchmark crypt_benchmark;
+};
+
+#define STORAGE_BACKENDS 3
+
+struct performance_screen
+{
+    struct otp_perf_hotp_benchmark benchmark;
+    struct storage_benchmark storage[STORAGE_BACKENDS];
+    uint8_t storage_count; // 0 until the storage benchmark has been run.
+    bool storage_running;
+};
+
+struct flash_information_screen
+{
+    bool confirm_lock; // Waiting for Y to lock the root record.
 };
 
 struct change_pin_screen
 {
-    struct base_screen_details base_screen_details;
     bool first_pin_entered;
+    bool saving; // The new PIN is being derived.
+    bool saved;
+    bool failed;
     char new_pin[9];
     char confirm_pin[9];
 };
 
 struct configure_screen_handler
 {
-    struct base_screen_details base_screen_details;
     char otp_secret_hex[40];
     uint8_t otp_secret_length;
+    bool base32; // The secret is being entered as Base32 rather than hex.
+};
+
+enum read_flash_entry
+{
+    entry_address,
+    entry_pattern
 };
 
 struct read_flash_screen
 {
-    struct base_screen_details base_screen_details;
-    char flash_address[6];
+    char flash_address[8];
     uint8_t flash_address_length;
-    uint8_t entered_address[3];
+    char pattern_hex[FLASH_BROWSER_MAX_PATTERN * 2];
+    uint8_t pattern_hex_length;
+    uint8_t entry; // enum read_flash_entry
+    uint8_t search_percent; // The search progress last drawn.
     bool display_data;
+    bool match_found;
+    uint32_t address;
+    uint32_t match_address;
 };
 struct reset_storage_screen
 {
-    struct base_screen_details base_screen_details;
     bool confirm_reset;
 };
 
-// TODO We should add a check to verify we are on the screen we
-// expect to be on, especially with Callbacks etc...
+struct flash_scan_screen
+{
+    char pattern_hex[FLASH_SCAN_MAX_PATTERN * 2];
+    uint8_t pattern_hex_length;
+    uint8_t state;   // The enum flash_scan_state last drawn.
+    uint8_t percent; // The progress last drawn.
+    uint16_t first_sector; // The first sector in the CRC table.
+};
+
+struct totp_code
+{
+    uint64_t step; // The time step the code was calculated for.
+    char otp[OTP_MAX_DIGITS + 1];
+};
+
+enum dashboard_entry
+{
+    dashboard_entry_none,
+    dashboard_entry_time,
+    dashboard_entry_name,
+    dashboard_entry_secret
+};
+
+struct dashboard_screen
+{
+    struct totp_code codes[PICO_OTP_MAX_CREDENTIALS]; // Indexed as the credential table.
+    uint64_t second; // The second last drawn.
+    uint8_t calculated; // Codes calculated for the last frame.
+    uint8_t entry; // enum dashboard_entry
+    char entered[PICO_OTP_MAX_SECRET * 2];
+    uint8_t entered_length;
+    char name[PICO_OTP_NAME_LENGTH];
+};
+
+#define CREDENTIAL_SEARCH_ROWS 22
+
+struct credential_search_screen
+{
+    char query[PICO_OTP_NAME_LENGTH];
+    uint8_t query_length;
+    uint8_t results[CREDENTIAL_SEARCH_ROWS];
+    uint16_t total;
+    uint32_t search_us; // The time taken by the last search.
+};
+
+struct import_screen
+{
+    struct otpauth_parser parser;
+    uint8_t staged;   // Credentials parsed and waiting to be added.
+    uint8_t rejected; // URIs rejected since the last import.
+    const char *last_error;
+    uint8_t imported; // Credentials added by the last import.
+};
+
 union screens
 {
     struct login_screen login_screen;
+    struct generate_otp_screen generate_otp_screen;
+    struct otp_information_screen otp_information_screen;
+    struct flash_information_screen flash_information_screen;
+    struct performance_screen performance_screen;
     struct change_pin_screen change_pin_screen;
     struct configure_screen_handler configure_screen_handler;
     struct read_flash_screen read_flash_screen;
     struct reset_storage_screen reset_storage_screen;
+    struct flash_scan_screen flash_scan_screen;
+    struct dashboard_screen dashboard_screen;
+    struct credential_search_screen credential_search_screen;
+    struct import_screen import_screen;
 };
 
 #define OTP_MGR_CONTEXT_ID 0xAC
 
-/*
- * For now this will contain a union to allocate the space for the largest screen type.
- */
+// Characters collected before a batch handler is called.
+#define OTP_MGR_BATCH_SIZE 64
+// Upper bound on passes to empty the CDC FIFO in one loop.
+#define OTP_MGR_MAX_BURST 16
+// The deepest path through the menus is Main Menu -> System Information -> Read Flash.
+#define OTP_MGR_SCREEN_STACK_DEPTH 8
+
+#define OTP_MGR_PROGRAM_NAME "Pico OATH"
+#define OTP_MGR_FOOTER "Taking control of your security."
+
 struct otp_mgr_context
 {
     char id;
@@ -129,25 +292,47 @@ struct otp_mgr_context
     otp_admin_context_t *otp_admin_context; // This is our context.
     otp_main_context_t *otp_main_context; // The majority of our interaction will be through this context.
     otp_core_t *otp_core; // TODO Will be Removed once no longer accesses.
-    void* screen;
+    // Navigation, screen_stack[screen_depth] is the current screen.
+    const struct screen_descriptor *screen_stack[OTP_MGR_SCREEN_STACK_DEPTH];
+    uint8_t screen_depth;
+    union screens screen; // State of the current screen.
+    const char* error_message;
     void *terminal_handler_context;
+    screen_buffer_t *screen_buffer;
+    flash_browser_t *flash_browser;
+    struct otp_credential *import_staging; // Allocated on first use of the import screen.
+    vt102_decoder_t decoder;
+    bool redraw_required; // Deferred until all pending input has been handled.
+    char batch[OTP_MGR_BATCH_SIZE];
+    uint32_t batch_length;
 };
 
 
 static void otp_mgr_handle(vt102_event *event, void *context);
+static void _read_input(struct otp_mgr_context *context);
+static void _handle_batch(struct otp_mgr_context *context);
+static void _redraw(struct otp_mgr_context *context);
+static inline const struct screen_descriptor* current_screen(struct otp_mgr_context *context);
+static void screen_reset(struct otp_mgr_context *context, const struct screen_descriptor *descriptor);
+
+// Until a terminal connects there is no screen to handle events or render.
+static const struct screen_descriptor no_screen = { 0 };
 
 void* otp_mgr_init()
 {
     struct otp_mgr_context *otp_mgr_context = malloc(sizeof(struct otp_mgr_context));
     otp_mgr_context->id = OTP_MGR_CONTEXT_ID;
 
-    union screens *screens = malloc(sizeof(union screens));
-
     // Initialise the context.
     otp_mgr_context->otp_core = NULL;
-    otp_mgr_context->screen = screens;
+    // No handlers until a terminal connects.
+    screen_reset(otp_mgr_context, &no_screen);
 
     otp_mgr_context->terminal_handler_context = terminal_handler_init();
+    otp_mgr_context->screen_buffer = screen_buffer_init();
+    otp_mgr_context->redraw_required = false;
+    otp_mgr_context->batch_length = 0;
+    otp_mgr_context->import_staging = NULL;
 
     return otp_mgr_context;
 }
@@ -158,15 +343,17 @@ bool otp_mgr_begin(void *otp_mgr_context, otp_admin_context_t *otp_admin,
     struct otp_mgr_context *context = (struct otp_mgr_context *)otp_mgr_context;
     if (context->id != OTP_MGR_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_mgr_begin 0x%02x\n", context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_mgr_begin 0x%02x\n", context->id);
         return false;
     }
 
     context->otp_admin_context = otp_admin;
     context->otp_main_context = otp_main;
     context->otp_core = otp_core;
+    context->flash_browser = flash_browser_init(otp_core);
 
     terminal_handler_begin(context->terminal_handler_context, otp_mgr_handle, context);
+    vt102_decoder_init(&context->decoder, otp_mgr_handle, context);
 
     return true;
 }
@@ -175,38 +362,154 @@ void otp_mgr_run(void *otp_mgr_context)
     struct otp_mgr_context *context = (struct otp_mgr_context *)otp_mgr_context;
     if (context->id != OTP_MGR_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_mgr_run 0x%02x\n", context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_mgr_run 0x%02x\n", context->id);
         return;
     }
 
-    if (otp_admin_handle_notification(context->otp_admin_context))
+    bool run_required = otp_admin_handle_usb_activity(context->otp_admin_context);
+    while (otp_admin_handle_notification(context->otp_admin_context))
     {
-        // If we are running with an event then we need to trigger the terminal handler to process the event.
+        // If we are running with an event then we need to trigger the terminal handler to process the event,
+        // each notification gets it's own pass so none are merged.
         terminal_handler_trigger_event(context->terminal_handler_context);
+        terminal_handler_run(context->terminal_handler_context);
+        run_required = false;
+    }
+
+    if (run_required)
+    {
+        // Consume everything waiting in the CDC FIFO in one pass so a paste
+        // is handled and drawn as a single frame.
+        //
+        // The input is read and decoded here before the terminal handler runs,
+        // leaving the terminal handler to track the connection state.
+        uint32_t passes = 0;
+        do
+        {
+            tud_task();
+            _read_input(context);
+            terminal_handler_run(context->terminal_handler_context);
+        } while (tud_cdc_available() > 0 && ++passes < OTP_MGR_MAX_BURST);
     }
 
-    terminal_handler_run(context->terminal_handler_context);
+    _handle_batch(context);
+
+    const struct screen_descriptor *screen = current_screen(context);
+    if (screen->background != NULL)
+    {
+        bool redraw = false;
+        if (screen->background(context, &redraw))
+        {
+            // Come straight back for the remaining work rather than sleeping.
+            otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+        }
+        context->redraw_required |= redraw;
+    }
+
+    if (context->redraw_required)
+    {
+        _redraw(context);
+    }
+
+    // Continue any frame held back by a slow host and keep the TX ring moving.
+    if (screen_buffer_pending(context->screen_buffer))
+    {
+        screen_buffer_present(context->screen_buffer);
+    }
+    cdc_tx_ring_drain();
+
+    if (tud_cdc_available() > 0)
+    {
+        // Input remains in the FIFO which will not raise a further callback,
+        // ensure we come back for it rather than sleeping.
+        otp_event_post(OTP_EVENT_CDC_RX, 0x00);
+    }
 }
 
 
 void handle_disconnected()
 {
-    printf("Disconnected\n");
+    OTP_LOG_INFO("Disconnected\n");
+}
+
+/*
+ * Screen descriptors, defined with each screen below.
+ */
+static const struct screen_descriptor login_screen_descriptor;
+static const struct screen_descriptor main_menu_descriptor;
+static const struct screen_descriptor generate_screen_descriptor;
+static const struct screen_descriptor configure_screen_descriptor;
+static const struct screen_descriptor system_information_screen_descriptor;
+static const struct screen_descriptor otp_information_screen_descriptor;
+static const struct screen_descriptor flash_information_screen_descriptor;
+static const struct screen_descriptor change_pin_screen_descriptor;
+static const struct screen_descriptor read_flash_screen_descriptor;
+static const struct screen_descriptor reset_storage_screen_descriptor;
+static const struct screen_descriptor flash_scan_screen_descriptor;
+static const struct screen_descriptor dashboard_screen_descriptor;
+static const struct screen_descriptor credential_search_screen_descriptor;
+static const struct screen_descriptor import_screen_descriptor;
+static const struct screen_descriptor boot_profile_screen_descriptor;
+static const struct screen_descriptor performance_screen_descriptor;
+
+/*
+ * Screen Navigation
+ */
+
+static inline const struct screen_descriptor* current_screen(struct otp_mgr_context *context)
+{
+    return context->screen_stack[context->screen_depth];
+}
+
+static void _enter_screen(struct otp_mgr_context *context)
+{
+    context->error_message = NULL;
+    const struct screen_descriptor *screen = current_screen(context);
+    if (screen->enter != NULL)
+    {
+        screen->enter(context);
+    }
+}
+
+/*
+ * Clear the navigation stack leaving the descriptor as the only screen.
+ */
+static void screen_reset(struct otp_mgr_context *context, const struct screen_descriptor *descriptor)
+{
+    context->screen_depth = 0;
+    context->screen_stack[0] = descriptor;
+    _enter_screen(context);
+}
+
+/*
+ * Navigate to a new screen, screen_pop will return to the current screen.
+ */
+static void screen_push(struct otp_mgr_context *context, const struct screen_descriptor *descriptor)
+{
+    if (context->screen_depth + 1 < OTP_MGR_SCREEN_STACK_DEPTH)
+    {
+        context->screen_depth++;
+    }
+    else
+    {
+        OTP_LOG_ERROR("Screen stack full, replacing %s\n", current_screen(context)->screen_name);
+    }
+    context->screen_stack[context->screen_depth] = descriptor;
+    _enter_screen(context);
 }
 
 /*
- * Screen initialisation prototype function definitions.
+ * Return to the previous screen, the previous screen is re-entered as the screen
+ * state is only retained for the current screen.
  */
-static void init_login_screen(struct otp_mgr_context *context);
-static void init_main_menu(struct otp_mgr_context *context);
-static void init_generate_screen(struct otp_mgr_context *context);
-static void init_configure_screen(struct otp_mgr_context *context);
-static void init_system_information_screen(struct otp_mgr_context *context);
-static void init_otp_information_screen(struct otp_mgr_context *context);
-static void init_flash_information_screen(struct otp_mgr_context *context);
-static void init_change_pin_screen(struct otp_mgr_context *context);
-static void init_read_flash_screen(struct otp_mgr_context *context);
-static void init_reset_storage_screen(struct otp_mgr_context *context);
+static void screen_pop(struct otp_mgr_context *context)
+{
+    if (context->screen_depth > 0)
+    {
+        context->screen_depth--;
+    }
+    _enter_screen(context);
+}
 
 void otp_mgr_handle(struct vt102_event *event, void *context)
 {
@@ -214,17 +517,31 @@ void otp_mgr_handle(struct vt102_event *event, void *context)
     static bool warned = false;
     if (otp_mgr_context->id != OTP_MGR_CONTEXT_ID && !warned)
     {
-        printf("Invalid context passed to otp_mgr_handle 0x%02x\n", otp_mgr_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_mgr_handle 0x%02x\n", otp_mgr_context->id);
         warned = true;
         return;
     }
 
+    if (event->event_type == character && current_screen(otp_mgr_context)->batch_handler != NULL)
+    {
+        // Collect the run of characters for the batch handler.
+        otp_mgr_context->batch[otp_mgr_context->batch_length++] = event->character;
+        if (otp_mgr_context->batch_length == OTP_MGR_BATCH_SIZE)
+        {
+            _handle_batch(otp_mgr_context);
+        }
+        return;
+    }
+    // Anything collected so far must be handled first to preserve the order.
+    _handle_batch(otp_mgr_context);
+
     bool redraw = false;
     switch (event->event_type)
     {
     case connect:
-        init_login_screen(otp_mgr_context);
-        vt102_ris();
+        screen_reset(otp_mgr_context, &login_screen_descriptor);
+        // Whatever the terminal is showing is not ours.
+        screen_buffer_invalidate(otp_mgr_context->screen_buffer);
         redraw = true;
         break;
     case disconnect:
@@ -237,20 +554,18 @@ void otp_mgr_handle(struct vt102_event *event, void *context)
         // Also this may need a generic way to refresh the screen if our of sync Ctrl+R ?
         if (event->event_type != none)
         {
-            char hex_value[10];
-            hex_value[0] = '0';
-            hex_value[1] = 'x';
-            uint32_to_hex_string(event->character, &hex_value[2]);
-            printf("Event Type: %s, Character: %s\n", vt102_event_type_to_string(event->event_type),
-                   event->event_type == special ? special_key_to_string(event->character) : hex_value);
+            OTP_LOG_DEBUG("Event Type: %s, Character: 0x%02x %s\n", vt102_event_type_to_string(event->event_type),
+                event->character, event->event_type == special ? vt102_key_to_string(event->character) : "");
         }
 
         if (event->event_type == control && event->character == 0x52)
         {
+            // Ctrl+R, the terminal may be out of sync so repaint everything.
+            screen_buffer_invalidate(otp_mgr_context->screen_buffer);
             redraw = true;
         } else
         {
-            struct base_screen_details *screen = otp_mgr_context->screen;
+            const struct screen_descriptor *screen = current_screen(otp_mgr_context);
             if (screen->handler != NULL)
             {
                 redraw = screen->handler(event, otp_mgr_context);
@@ -258,40 +573,89 @@ void otp_mgr_handle(struct vt102_event *event, void *context)
         }
     }
 
-    if (redraw)
+    // The redraw happens once all pending input has been handled.
+    otp_mgr_context->redraw_required |= redraw;
+}
+
+static void _read_input(struct otp_mgr_context *context)
+{
+    uint8_t buffer[CFG_TUD_CDC_EP_BUFSIZE];
+    uint32_t count;
+    while ((count = tud_cdc_read(buffer, sizeof(buffer))) > 0)
+    {
+        vt102_decoder_decode(&context->decoder, buffer, count);
+    }
+}
+
+static void _handle_batch(struct otp_mgr_context *context)
+{
+    uint32_t offset = 0;
+    bool redraw = false;
+    while (offset < context->batch_length)
+    {
+        // Re-read each time as the screen may change part way through.
+        const struct screen_descriptor *screen = current_screen(context);
+        if (screen->batch_handler != NULL)
+        {
+            offset += screen->batch_handler(&context->batch[offset], context->batch_length - offset,
+                context, &redraw);
+        }
+        else
+        {
+            vt102_event event = { .event_type = character, .character = context->batch[offset++] };
+            if (screen->handler != NULL)
+            {
+                redraw |= screen->handler(&event, context);
+            }
+        }
+    }
+
+    context->batch_length = 0;
+    context->redraw_required |= redraw;
+}
+
+static void _redraw(struct otp_mgr_context *context)
+{
+    // Renderers draw the full screen into the screen buffer, only the
+    // differences from what the terminal is already showing are sent.
+    screen_buffer_clear(context->screen_buffer);
+    const struct screen_descriptor *screen = current_screen(context);
+    if (screen->renderer != NULL)
     {
-        vt102_ris(); // Reset to initial state. TODO Check we really need this.
-        struct base_screen_details *screen = otp_mgr_context->screen;
-        screen->renderer(otp_mgr_context);
+        screen->renderer(context);
     }
+    screen_buffer_present(context->screen_buffer);
+
+    context->redraw_required = false;
 }
 
 /*
  *  Common Screen Handling
  */
 
-static void render_screen(struct base_screen_details* screen_details)
+static void render_screen(struct otp_mgr_context *context)
 {
-    vt102_erase_display();
-    _vt102_write_str("== ");
-    _vt102_write_str(screen_details->program_name);
-    vt102_cup("2", "0");
-    _vt102_write_str("-- ");
-    _vt102_write_str(screen_details->screen_name);
+    const struct screen_descriptor *screen_details = current_screen(context);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+
+    screen_buffer_write_str(screen_buffer, "== ");
+    screen_buffer_write_str(screen_buffer, screen_details->program_name);
+    screen_buffer_cup(screen_buffer, 2, 0);
+    screen_buffer_write_str(screen_buffer, "-- ");
+    screen_buffer_write_str(screen_buffer, screen_details->screen_name);
 
-    if (screen_details->error_message != NULL)
+    if (context->error_message != NULL)
     {
-        vt102_cup("4", "10");
-        _vt102_write_str(screen_details->error_message);
+        screen_buffer_cup(screen_buffer, 4, 10);
+        screen_buffer_write_str(screen_buffer, context->error_message);
     }
 
-    vt102_cup("34", "0");
-    _vt102_write_str("-- ");
-    _vt102_write_str(screen_details->commands);
-    vt102_cup("35", "0");
-    _vt102_write_str("== ");
-    _vt102_write_str(screen_details->footer);
-    _vt102_write_flush();
+    screen_buffer_cup(screen_buffer, 34, 0);
+    screen_buffer_write_str(screen_buffer, "-- ");
+    screen_buffer_write_str(screen_buffer, screen_details->commands);
+    screen_buffer_cup(screen_buffer, 35, 0);
+    screen_buffer_write_str(screen_buffer, "== ");
+    screen_buffer_write_str(screen_buffer, screen_details->footer);
 }
 
 /*
@@ -300,49 +664,52 @@ static void render_screen(struct base_screen_details* screen_details)
 
 void render_login_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
 
-    struct login_screen *login_screen = context->screen;
+    struct login_screen *login_screen = &context->screen.login_screen;
 
-    vt102_cup("10", "10");
-    _vt102_write_str("Please enter your PIN and press <ENTER>");
-    vt102_cup("11", "10");
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "Please enter your PIN and press <ENTER>");
+    screen_buffer_cup(screen_buffer, 11, 10);
 
     int entered = 0;
     for (int i = 0; i < 8; i++) // The 9th is the null terminator.
     {
         if (login_screen->entered_pin[i] != 0x00)
         {
-            _vt102_write_char('*');
+            screen_buffer_write_char(screen_buffer, '*');
             entered++;
         }
         else
         {
-            _vt102_write_char('-');
+            screen_buffer_write_char(screen_buffer, '-');
         }
     }
-    int cursor = 10 + entered;
-    char cursor_string[3];
-    sprintf(cursor_string, "%d", cursor);
-
-    vt102_cup("11", cursor_string);
-    _vt102_write_flush();
-
+    if (login_screen->state == validating)
+    {
+        // Deriving the PIN takes a noticeable fraction of a second.
+        screen_buffer_cup(screen_buffer, 13, 10);
+        screen_buffer_write_str(screen_buffer, "Checking PIN...");
+    }
+    screen_buffer_cup(screen_buffer, 11, 10 + entered);
 
-    printf("Login screen sent.\n");
+    OTP_LOG_DEBUG("Login screen sent.\n");
 }
 
 void _handle_pin_validation_result(int result, void *handback)
 {
     struct otp_mgr_context *context = (struct otp_mgr_context *)handback;
-    struct login_screen *login_screen = context->screen;
+    struct login_screen *login_screen = &context->screen.login_screen;
 
-    if (login_screen->state == validating)
+    // The terminal may have reconnected while validating, the state is only ours
+    // if the login screen is still current.
+    if (current_screen(context) == &login_screen_descriptor && login_screen->state == validating)
     {
         // Don't do anthing with the screens other than recore the state from the
         // async call - calling notify means the event handler will be called to
         // handle the result.
-        printf("PIN validation result: %d\n", result);
+        OTP_LOG_INFO("PIN validation result: %d\n", result);
         login_screen->state = result == 0 ? valid : invalid;
         otp_admin_notify(context->otp_admin_context);
 
@@ -356,7 +723,7 @@ void _handle_pin_validation_result(int result, void *handback)
 
 bool login_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
-    struct login_screen *login_screen = context->screen;
+    struct login_screen *login_screen = &context->screen.login_screen;
     if (login_screen->state == pin_entry)
     {
         if (event->event_type == character && event->character >= 0x30 && event->character <= 0x39)
@@ -367,9 +734,8 @@ bool login_screen_handler(vt102_event *event, struct otp_mgr_context *context)
                 if (login_screen->entered_pin[i] == 0x00)
                 {
                     login_screen->entered_pin[i] = event->character;
-                    _vt102_write_char('*');
-                    _vt102_write_flush();
-                    break;
+                    // Only the new '*' and cursor will be sent.
+                    return true;
                 }
             }
         }
@@ -377,12 +743,32 @@ bool login_screen_handler(vt102_event *event, struct otp_mgr_context *context)
         {
 
             // Process the entered pin.
-            printf("Processing entered pin.\n");
-            struct login_screen *login_screen = context->screen;
+            OTP_LOG_DEBUG("Processing entered pin.\n");
+            struct login_screen *login_screen = &context->screen.login_screen;
 
             login_screen->state = validating;
-            otp_main_validate_pin(context->otp_main_context, login_screen->entered_pin,
-                _handle_pin_validation_result, context);
+            if (otp_main_root_damaged(context->otp_main_context))
+            {
+                context->error_message = "Root record damaged";
+                login_screen->state = pin_entry;
+                for (int i = 0; i < 9; i++)
+                {
+                    login_screen->entered_pin[i] = 0x00;
+                }
+            }
+            else if (!otp_main_validate_pin(context->otp_main_context, login_screen->entered_pin,
+                _handle_pin_validation_result, context))
+            {
+                // Another task such as the first boot derivation of the default PIN.
+                context->error_message = "Busy, try again";
+                login_screen->state = pin_entry;
+                for (int i = 0; i < 9; i++)
+                {
+                    login_screen->entered_pin[i] = 0x00;
+                }
+            }
+
+            return true;
         }
     }
     else if (event->event_type == none)
@@ -390,15 +776,14 @@ bool login_screen_handler(vt102_event *event, struct otp_mgr_context *context)
         // We may have received an update for pin validation.
         if (login_screen->state == valid)
         {
-            printf("PIN Valid\n");
-            init_main_menu(context);
+            OTP_LOG_INFO("PIN Valid\n");
+            screen_reset(context, &main_menu_descriptor);
 
             return true;
         } else if (login_screen->state == invalid)
         {
-            printf("PIN Invalid\n");
-            struct base_screen_details *screen = context->screen;
-            screen->error_message = "Invalid PIN";
+            OTP_LOG_INFO("PIN Invalid\n");
+            context->error_message = "Invalid PIN";
             login_screen->state = pin_entry;
 
             return true;
@@ -408,40 +793,34 @@ bool login_screen_handler(vt102_event *event, struct otp_mgr_context *context)
     return false;
 }
 
-/*
- * A base init function for screens, if we add new fields the base can ensure
- * they are initialised to NULL even by init functions that do not know about them.
- */
-static void init_screen(struct base_screen_details *screen)
-{
-    screen->program_name = NULL;
-    screen->screen_name = NULL;
-    screen->commands = NULL;
-    screen->error_message = NULL;
-    screen->footer = NULL;
-    screen->handler = NULL;
-    screen->renderer = NULL;
-}
-
-static void init_login_screen(struct otp_mgr_context *context)
-{
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    struct login_screen *login_screen = context->screen;
-    login_screen->base_screen_details.program_name = "Pico OATH";
-    login_screen->base_screen_details.screen_name = "Login";
-    login_screen->base_screen_details.commands = "Please Login";
-    login_screen->base_screen_details.footer = "Taking control of your security.";
-    login_screen->base_screen_details.handler = login_screen_handler;
-    login_screen->base_screen_details.renderer = render_login_screen;
+static void enter_login_screen(struct otp_mgr_context *context)
+{
+    struct login_screen *login_screen = &context->screen.login_screen;
     // Clear the entered pin.
     for (int i = 0; i < 9; i++)
     {
         login_screen->entered_pin[i] = 0x00;
     }
     login_screen->state = pin_entry;
+    // Logging out or a new connection, the data key is discarded until the next login.
+    pico_otp_end_session(context->otp_core);
+    if (otp_main_root_damaged(context->otp_main_context))
+    {
+        context->error_message = "Root record damaged";
+    }
 }
 
+static const struct screen_descriptor login_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Login",
+    .commands = "Please Login",
+    .footer = OTP_MGR_FOOTER,
+    .handler = login_screen_handler,
+    .renderer = render_login_screen,
+    .enter = enter_login_screen,
+};
+
 /*
  * Main Menu
  */
@@ -455,25 +834,33 @@ bool main_menu_handler(vt102_event *event, struct otp_mgr_context *context)
         case 0x31:
             if (pico_otp_configured(context->otp_core))
             {
-                init_generate_screen(context);
+                screen_push(context, &generate_screen_descriptor);
             } else
             {
-                struct base_screen_details *screen = context->screen;
-                screen->error_message = "OTP not configured";
+                context->error_message = "OTP not configured";
             }
             return true;
         case 0x32:
-            init_configure_screen(context);
+            screen_push(context, &configure_screen_descriptor);
             return true;
         case 0x33:
-            init_system_information_screen(context);
+            screen_push(context, &system_information_screen_descriptor);
             return true;
         case 0x34:
-            init_change_pin_screen(context);
+            screen_push(context, &change_pin_screen_descriptor);
+            return true;
+        case 0x35:
+            screen_push(context, &dashboard_screen_descriptor);
+            return true;
+        case 0x36:
+            screen_push(context, &credential_search_screen_descriptor);
+            return true;
+        case 0x37:
+            screen_push(context, &import_screen_descriptor);
             return true;
         case 0x51:
         case 0x71:
-            init_login_screen(context);
+            screen_reset(context, &login_screen_descriptor);
             return true;
         }
     }
@@ -483,56 +870,71 @@ bool main_menu_handler(vt102_event *event, struct otp_mgr_context *context)
 
 void render_main_menu(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "1 - Generate OTP");
+
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "2 - Configure OTP");
+
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "3 - System Information");
 
-    vt102_cup("8", "10");
-    _vt102_write_str("1 - Generate OTP");
+    screen_buffer_cup(screen_buffer, 14, 10);
+    screen_buffer_write_str(screen_buffer, "4 - Change PIN");
 
-    vt102_cup("10", "10");
-    _vt102_write_str("2 - Configure OTP");
+    screen_buffer_cup(screen_buffer, 16, 10);
+    screen_buffer_write_str(screen_buffer, "5 - TOTP Dashboard");
 
-    vt102_cup("12", "10");
-    _vt102_write_str("3 - System Information");
+    screen_buffer_cup(screen_buffer, 18, 10);
+    screen_buffer_write_str(screen_buffer, "6 - Find Credential");
 
-    vt102_cup("14", "10");
-    _vt102_write_str("4 - Change PIN");
+    screen_buffer_cup(screen_buffer, 20, 10);
+    screen_buffer_write_str(screen_buffer, "7 - Import Credentials");
 
-    vt102_cup("16", "10");
-    _vt102_write_str("Q - Quit");
+    screen_buffer_cup(screen_buffer, 22, 10);
+    screen_buffer_write_str(screen_buffer, "Q - Quit");
 
-    vt102_cup("18", "10");
-    _vt102_write_str("[ ]");
-    vt102_cup("18", "11");
+    screen_buffer_cup(screen_buffer, 24, 10);
+    screen_buffer_write_str(screen_buffer, "[ ]");
+    screen_buffer_cup(screen_buffer, 24, 11);
 }
 
-static void init_main_menu(struct otp_mgr_context *context)
+static const struct screen_descriptor main_menu_descriptor =
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Main Menu";
-    screen->commands = "Please choose an option.";
-    screen->footer = "Taking control of your security.";
-    screen->handler = main_menu_handler;
-    screen->renderer = render_main_menu;
-}
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Main Menu",
+    .commands = "Please choose an option.",
+    .footer = OTP_MGR_FOOTER,
+    .handler = main_menu_handler,
+    .renderer = render_main_menu,
+};
 
 /*
  * Generate Screen
  */
 
+static void _generate_otp(struct otp_mgr_context *context)
+{
+    struct generate_otp_screen *generate_screen = &context->screen.generate_otp_screen;
+    generate_screen->requested_us = time_us_32();
+    generate_screen->precomputed = context->otp_core->hotp_next_valid;
+    pico_otp_calculate(context->otp_core, generate_screen->otp);
+}
+
 bool generate_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
-    if (event->event_type == character && event->character == 0x71 || event->character == 0x51)
+    if (event->event_type == character && (event->character == 0x71 || event->character == 0x51))
     {
         // Quit
-        init_main_menu(context);
+        screen_pop(context);
         return true;
     }
     else if (event->event_type == character && event->character == 0x43 || event->character == 0x63)
     {
-        struct generate_otp_screen *generate_screen = context->screen;
-        pico_otp_calculate(context->otp_core, generate_screen->otp);
+        _generate_otp(context);
 
         return true;
     }
@@ -542,43 +944,58 @@ bool generate_screen_handler(vt102_event *event, struct otp_mgr_context *context
 
 void render_generate_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Generating OTP");
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Generating OTP");
 
-    vt102_cup("10", "10");
-    _vt102_write_str("OTP - ");
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "OTP - ");
 
-    struct generate_otp_screen *generate_screen = context->screen;
-    _vt102_write_str(generate_screen->otp);
+    struct generate_otp_screen *generate_screen = &context->screen.generate_otp_screen;
+    screen_buffer_write_str(screen_buffer, generate_screen->otp);
+
+    if (generate_screen->requested_us != 0)
+    {
+        generate_screen->latency_us = time_us_32() - generate_screen->requested_us;
+        generate_screen->requested_us = 0;
+        OTP_LOG_DEBUG("HOTP rendered %d us after the request, precomputed=%d\n",
+            generate_screen->latency_us, generate_screen->precomputed);
+    }
+    char latency[50];
+    sprintf(latency, "(%ld us, %s)", generate_screen->latency_us,
+        generate_screen->precomputed ? "precomputed" : "calculated");
+    screen_buffer_cup(screen_buffer, 10, 30);
+    screen_buffer_write_str(screen_buffer, latency);
 
-    vt102_cup("12", "10");
-    _vt102_write_str("Press C to calculate next OTP.");
-    vt102_cup("13", "10");
-    _vt102_write_str("Press Q to return to the main menu.");
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "Press C to calculate next OTP.");
+    screen_buffer_cup(screen_buffer, 13, 10);
+    screen_buffer_write_str(screen_buffer, "Press Q to return to the main menu.");
 
-    vt102_cup("15", "10");
-    _vt102_write_str("[ ]");
+    screen_buffer_cup(screen_buffer, 15, 10);
+    screen_buffer_write_str(screen_buffer, "[ ]");
 
-    vt102_cup("15", "11");
+    screen_buffer_cup(screen_buffer, 15, 11);
 }
 
-static void init_generate_screen(struct otp_mgr_context *context)
+static void enter_generate_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Generate OTP";
-    screen->commands = "C - Calculate, Q - Quit";
-    screen->footer = "Taking control of your security.";
-    screen->handler = generate_screen_handler;
-    screen->renderer = render_generate_screen;
-    struct generate_otp_screen *generate_screen = context->screen;
-    pico_otp_calculate(context->otp_core, generate_screen->otp);
-
+    _generate_otp(context);
 }
 
+static const struct screen_descriptor generate_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Generate OTP",
+    .commands = "C - Calculate, Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = generate_screen_handler,
+    .renderer = render_generate_screen,
+    .enter = enter_generate_screen,
+};
+
 /*
  * Configure Screen
  */
@@ -589,13 +1006,9 @@ struct cursor_position
     uint8_t column;
 };
 
-static void set_cursor_position(struct cursor_position *cursor_position, struct cursor_position *origin)
+static void set_cursor_position(screen_buffer_t *screen_buffer, struct cursor_position *cursor_position, struct cursor_position *origin)
 {
-    char row[3];
-    char column[3];
-    sprintf(row, "%d", cursor_position->row + origin->row);
-    sprintf(column, "%d", cursor_position->column + origin->column);
-    vt102_cup(row, column);
+    screen_buffer_cup(screen_buffer, cursor_position->row + origin->row, cursor_position->column + origin->column);
 }
 
 static void calculate_cursor_position(struct cursor_position *cursor_position, uint8_t index)
@@ -604,38 +1017,111 @@ static void calculate_cursor_position(struct cursor_position *cursor_position, u
     cursor_position->column = index % 10;
 }
 
-bool configure_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+/*
+ * Handle a single character entered on the configure screen.
+ *
+ * Returns true if the character was accepted or caused the screen to change.
+ */
+static bool _configure_screen_character(char character, struct otp_mgr_context *context)
 {
     char current = 0x00;
-    if (event->event_type == character && event->character == 0x71 || event->character == 0x51)
+    // Q is a Base32 digit, when entering Base32 <ENTER> on an empty secret returns instead.
+    if ((character == 0x71 || character == 0x51) && !context->screen.configure_screen_handler.base32)
     {
         // Quit
-        init_main_menu(context);
+        screen_pop(context);
         return true;
     }
-    else if (event->event_type == character &&
-        ((event->character >= 0x30 && event->character <= 0x39) || (event->character >= 0x41 && event->character <= 0x5A))
-        )
+    else if ((character >= 0x30 && character <= 0x39) || (character >= 0x41 && character <= 0x5A))
+    {
+        current = character;
+    }
+    else if (character >= 0x61 && character <= 0x7A)
+    {
+        current = character - 0x20; // Convert to upper case.
+    }
+
+    if (current != 0x00)
+    {
+        struct configure_screen_handler *configure_screen = &context->screen.configure_screen_handler;
+
+        if (configure_screen->otp_secret_length < 40)
+        {
+            configure_screen->otp_secret_hex[configure_screen->otp_secret_length] = current;
+            configure_screen->otp_secret_length++;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t configure_screen_batch_handler(const char *characters, uint32_t length,
+    struct otp_mgr_context *context, bool *redraw)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        *redraw |= _configure_screen_character(characters[i], context);
+        if (current_screen(context) != &configure_screen_descriptor)
+        {
+            // Quit part way through, leave the rest for the next screen.
+            return i + 1;
+        }
+    }
+
+    return length;
+}
+
+bool configure_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    if (event->event_type == character)
     {
-        current = event->character;
+        return _configure_screen_character(event->character, context);
     }
-    else if (event->event_type == character && event->character >= 0x61 && event->character <= 0x7A)
+    else if (event->event_type == control && event->character == 0x49)
     {
-        current = event->character - 0x20; // Convert to upper case.
+        // Tab switches between hex and Base32.
+        struct configure_screen_handler *configure_screen = &context->screen.configure_screen_handler;
+        configure_screen->base32 = !configure_screen->base32;
+        configure_screen->otp_secret_length = 0;
+        return true;
     }
     else if (event->event_type == control && event->character == 0x4D)
     {
         // Process the entered secret.
-        struct configure_screen_handler *configure_screen = context->screen;
-        if (configure_screen->otp_secret_length == 0)
-{
-            struct base_screen_details *screen = context->screen;
-            screen->error_message = "No secret entered";
+        struct configure_screen_handler *configure_screen = &context->screen.configure_screen_handler;
+        if (configure_screen->otp_secret_length == 0 && configure_screen->base32)
+        {
+            screen_pop(context);
+        }
+        else if (configure_screen->otp_secret_length == 0)
+        {
+            context->error_message = "No secret entered";
+        }
+        else if (configure_screen->base32)
+        {
+            uint8_t hotp_secret[PICO_OTP_MAX_SECRET];
+            struct base32_decoder decoder;
+            base32_decoder_init(&decoder, hotp_secret, sizeof(hotp_secret));
+            for (int i = 0; i < configure_screen->otp_secret_length; i++)
+            {
+                base32_decoder_put(&decoder, configure_screen->otp_secret_hex[i]);
+            }
+
+            if (decoder.error)
+            {
+                context->error_message = "Secret is not valid Base32 or is too long";
+            }
+            else
+            {
+                pico_otp_set_hotp_secret(context->otp_core, hotp_secret, decoder.length);
+                screen_pop(context);
+            }
         }
         else if (configure_screen->otp_secret_length % 2 != 0)
         {
-            struct base_screen_details *screen = context->screen;
-            screen->error_message = "Secret must be an even number of characters";
+            context->error_message = "Secret must be an even number of characters";
         }
         else
         {
@@ -646,40 +1132,17 @@ bool configure_screen_handler(vt102_event *event, struct otp_mgr_context *contex
                 hotp_secret[i] = hex_to_char(&configure_screen->otp_secret_hex[i * 2]);
             }
             pico_otp_set_hotp_secret(context->otp_core, hotp_secret, hotp_secret_length);
-            init_main_menu(context);
+            screen_pop(context);
         }
 
         // It is either an error or we processed the secret.
         return true;
     }
 
-    if (current != 0x00)
-    {
-        struct configure_screen_handler *configure_screen = context->screen;
-        struct cursor_position cursor_position;
-        calculate_cursor_position(&cursor_position, configure_screen->otp_secret_length);
-        uint8_t current_row = cursor_position.row;
-
-        if (configure_screen->otp_secret_length < 40)
-        {
-            configure_screen->otp_secret_hex[configure_screen->otp_secret_length] = current;
-            configure_screen->otp_secret_length++;
-            _vt102_write_char(current);
-
-            calculate_cursor_position(&cursor_position, configure_screen->otp_secret_length);
-            if (cursor_position.row != current_row)
-            {
-                set_cursor_position(&cursor_position, &(struct cursor_position){10, 10});
-            }
-
-            _vt102_write_flush();
-        }
-    }
-
     return false;
 }
 
-static void render_secret(char *otp_secret, uint8_t secret_length)
+static void render_secret(screen_buffer_t *screen_buffer, char *otp_secret, uint8_t secret_length)
 {
     struct cursor_position cursor_position;
     for (int i = 0; i < 40; i++)
@@ -688,57 +1151,66 @@ static void render_secret(char *otp_secret, uint8_t secret_length)
         if (i % 10 == 0)
         {
             calculate_cursor_position(&cursor_position, i);
-            set_cursor_position(&cursor_position, &(struct cursor_position){10, 10});
+            set_cursor_position(screen_buffer, &cursor_position, &(struct cursor_position){10, 10});
         }
 
         if (i + 1 > secret_length)
         {
-            _vt102_write_char('-');
+            screen_buffer_write_char(screen_buffer, '-');
         }
         else
         {
-            _vt102_write_char(otp_secret[i]);
+            screen_buffer_write_char(screen_buffer, otp_secret[i]);
         }
     }
 }
 
 void render_configure_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Enter OTP secret and press <ENTER>");
+    struct configure_screen_handler *configure_screen = &context->screen.configure_screen_handler;
 
-    struct configure_screen_handler *configure_screen = context->screen;
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, configure_screen->base32 ?
+        "Enter OTP secret as Base32 and press <ENTER>, <TAB> for hex." :
+        "Enter OTP secret as hex and press <ENTER>, <TAB> for Base32.");
 
     struct cursor_position cursor_position;
 
-    render_secret(configure_screen->otp_secret_hex, configure_screen->otp_secret_length);
+    render_secret(screen_buffer, configure_screen->otp_secret_hex, configure_screen->otp_secret_length);
 
-    vt102_cup("15", "10");
-    _vt102_write_str("Press Q to return to the main menu.");
+    screen_buffer_cup(screen_buffer, 15, 10);
+    screen_buffer_write_str(screen_buffer, configure_screen->base32 ?
+        "Press <ENTER> with no secret to return to the main menu." : "Press Q to return to the main menu.");
 
 
     calculate_cursor_position(&cursor_position, configure_screen->otp_secret_length);
-    set_cursor_position(&cursor_position, &(struct cursor_position){10, 10});
+    set_cursor_position(screen_buffer, &cursor_position, &(struct cursor_position){10, 10});
 }
 
-static void init_configure_screen(struct otp_mgr_context *context)
+static void enter_configure_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Configure OTP";
-    screen->commands = "Configuring OTP";
-    screen->footer = "Taking control of your security.";
-    screen->handler = configure_screen_handler;
-    screen->renderer = render_configure_screen;
-    struct configure_screen_handler *configure_screen = context->screen;
+    struct configure_screen_handler *configure_screen = &context->screen.configure_screen_handler;
     configure_screen->otp_secret_length = 0;
+    configure_screen->base32 = false;
 }
 
-/*
- * System Information Screen
+static const struct screen_descriptor configure_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Configure OTP",
+    .commands = "Configuring OTP",
+    .footer = OTP_MGR_FOOTER,
+    .handler = configure_screen_handler,
+    .batch_handler = configure_screen_batch_handler,
+    .renderer = render_configure_screen,
+    .enter = enter_configure_screen,
+};
+
+/*
+ * System Information Screen
  */
 
 bool system_information_screen_handler(vt102_event *event, struct otp_mgr_context *context)
@@ -750,26 +1222,34 @@ bool system_information_screen_handler(vt102_event *event, struct otp_mgr_contex
             case 0x31:
                 if (pico_otp_configured(context->otp_core))
                 {
-                    init_otp_information_screen(context);
+                    screen_push(context, &otp_information_screen_descriptor);
                 } else
                 {
-                    struct base_screen_details *screen = context->screen;
-                    screen->error_message = "OTP not configured";
+                    context->error_message = "OTP not configured";
                 }
                 return true;
             case 0x32:
-                init_flash_information_screen(context);
+                screen_push(context, &flash_information_screen_descriptor);
                 return true;
             case 0x33:
-                init_read_flash_screen(context);
+                screen_push(context, &read_flash_screen_descriptor);
                 return true;
             case 0x34:
-                init_reset_storage_screen(context);
+                screen_push(context, &reset_storage_screen_descriptor);
+                return true;
+            case 0x35:
+                screen_push(context, &flash_scan_screen_descriptor);
+                return true;
+            case 0x36:
+                screen_push(context, &boot_profile_screen_descriptor);
+                return true;
+            case 0x37:
+                screen_push(context, &performance_screen_descriptor);
                 return true;
             case 0x51:
             case 0x71:
                 // Quit
-                init_main_menu(context);
+                screen_pop(context);
                 return true;
         }
     }
@@ -778,51 +1258,59 @@ bool system_information_screen_handler(vt102_event *event, struct otp_mgr_contex
 
 void render_system_information_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
 
-    vt102_cup("8", "10");
-    _vt102_write_str("1 - Show OTP Information");
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "1 - Show OTP Information");
 
-    vt102_cup("10", "10");
-    _vt102_write_str("2 - Show Flash Information");
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "2 - Show Flash Information");
 
-    vt102_cup("12", "10");
-    _vt102_write_str("3 - Read Flash Data");
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "3 - Read Flash Data");
 
-    vt102_cup("14", "10");
-    _vt102_write_str("4 - Reset Storage");
+    screen_buffer_cup(screen_buffer, 14, 10);
+    screen_buffer_write_str(screen_buffer, "4 - Reset Storage");
 
-    vt102_cup("18", "10");
-    _vt102_write_str("Q - Quit");
+    screen_buffer_cup(screen_buffer, 16, 10);
+    screen_buffer_write_str(screen_buffer, "5 - Scan Flash");
 
-    vt102_cup("20", "10");
-    _vt102_write_str("[ ]");
-    vt102_cup("20", "11");
+    screen_buffer_cup(screen_buffer, 18, 10);
+    screen_buffer_write_str(screen_buffer, "6 - Boot Profile");
+
+    screen_buffer_cup(screen_buffer, 20, 10);
+    screen_buffer_write_str(screen_buffer, "7 - Performance");
+
+    screen_buffer_cup(screen_buffer, 22, 10);
+    screen_buffer_write_str(screen_buffer, "Q - Quit");
+
+    screen_buffer_cup(screen_buffer, 24, 10);
+    screen_buffer_write_str(screen_buffer, "[ ]");
+    screen_buffer_cup(screen_buffer, 24, 11);
 }
 
-static void init_system_information_screen(struct otp_mgr_context *context)
+static const struct screen_descriptor system_information_screen_descriptor =
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "System Information";
-    screen->commands = "System Information";
-    screen->footer = "Taking control of your security.";
-    screen->handler = system_information_screen_handler;
-    screen->renderer = render_system_information_screen;
-}
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "System Information",
+    .commands = "System Information",
+    .footer = OTP_MGR_FOOTER,
+    .handler = system_information_screen_handler,
+    .renderer = render_system_information_screen,
+};
 
 /*
  * OTP Information Screen
  */
 
 // Used by multiple information only screens to return.
-bool return_to_system_information_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+bool return_to_previous_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
-    if (event->event_type == character && event->character == 0x71 || event->character == 0x51)
+    if (event->event_type == character && (event->character == 0x71 || event->character == 0x51))
     {
         // Quit
-        init_system_information_screen(context);
+        screen_pop(context);
         return true;
     }
     return false;
@@ -830,10 +1318,11 @@ bool return_to_system_information_screen_handler(vt102_event *event, struct otp_
 
 void render_otp_information_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Configured HOTP Secret");
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Configured HOTP Secret");
 
     uint8_t hotp_secret_length = context->otp_core->hotp_secret_length * 2;
     char hotp_secret_hex[hotp_secret_length];
@@ -842,71 +1331,111 @@ void render_otp_information_screen(struct otp_mgr_context *context)
         uint8_to_hex(context->otp_core->hotp_secret[i], &hotp_secret_hex[i * 2]);
     }
 
-    render_secret(hotp_secret_hex, hotp_secret_length);
+    render_secret(screen_buffer, hotp_secret_hex, hotp_secret_length);
 
-    vt102_cup("15", "10");
+    screen_buffer_cup(screen_buffer, 15, 10);
     char counter[20];
     sprintf(counter, "%ld", context->otp_core->hotp_counter);
-    _vt102_write_str("Count - ");
-    _vt102_write_str(counter);
-
-    vt102_cup("17", "10");
-    _vt102_write_str("Press Q to return to the system information screen.");
-
-    vt102_cup("19", "10");
-    _vt102_write_str("[ ]");
-    vt102_cup("19", "11");
+    screen_buffer_write_str(screen_buffer, "Count - ");
+    screen_buffer_write_str(screen_buffer, counter);
+
+    screen_buffer_cup(screen_buffer, 17, 10);
+    screen_buffer_write_str(screen_buffer, "Press Q to return to the system information screen.");
+
+    struct otp_truncate_benchmark *benchmark = &context->screen.otp_information_screen.benchmark;
+    char line[80];
+    screen_buffer_cup(screen_buffer, 22, 10);
+    screen_buffer_write_str(screen_buffer, "Cycles");
+    sprintf(line, "8 digit conversion, division  : %ld", benchmark->divide_cycles);
+    screen_buffer_cup(screen_buffer, 23, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    sprintf(line, "8 digit conversion, reciprocal: %ld", benchmark->reciprocal_cycles);
+    screen_buffer_cup(screen_buffer, 24, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    sprintf(line, "6 digit HOTP, assembly kernel : %ld", benchmark->kernel_cycles);
+    screen_buffer_cup(screen_buffer, 25, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    sprintf(line, "8 digit HOTP, HMAC + truncate : %ld", benchmark->hmac_cycles);
+    screen_buffer_cup(screen_buffer, 26, 12);
+    screen_buffer_write_str(screen_buffer, line);
+
+    struct otp_crypt_benchmark *crypt_benchmark = &context->screen.otp_information_screen.crypt_benchmark;
+    screen_buffer_cup(screen_buffer, 28, 10);
+    screen_buffer_write_str(screen_buffer, "ChaCha20-Poly1305, 256 byte page");
+    // Bytes per microsecond is MB/s, scaled to KB/s.
+    sprintf(line, "Encrypt: %ld us, %ld KB/s", crypt_benchmark->seal_us,
+        crypt_benchmark->seal_us > 0 ? OTP_CRYPT_BENCHMARK_LENGTH * 1000 / crypt_benchmark->seal_us : 0);
+    screen_buffer_cup(screen_buffer, 29, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    sprintf(line, "Decrypt: %ld us, %ld KB/s", crypt_benchmark->open_us,
+        crypt_benchmark->open_us > 0 ? OTP_CRYPT_BENCHMARK_LENGTH * 1000 / crypt_benchmark->open_us : 0);
+    screen_buffer_cup(screen_buffer, 30, 12);
+    screen_buffer_write_str(screen_buffer, line);
+
+    screen_buffer_cup(screen_buffer, 19, 10);
+    screen_buffer_write_str(screen_buffer, "[ ]");
+    screen_buffer_cup(screen_buffer, 19, 11);
 }
 
-static void init_otp_information_screen(struct otp_mgr_context *context)
+static void enter_otp_information_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "OTP Information";
-    screen->commands = "OTP Information";
-    screen->footer = "Taking control of your security.";
-    screen->handler = return_to_system_information_screen_handler;
-    screen->renderer = render_otp_information_screen;
+    otp_truncate_benchmark(&context->screen.otp_information_screen.benchmark);
+    otp_crypt_benchmark(&context->screen.otp_information_screen.crypt_benchmark);
 }
 
+static const struct screen_descriptor otp_information_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "OTP Information",
+    .commands = "OTP Information",
+    .footer = OTP_MGR_FOOTER,
+    .handler = return_to_previous_screen_handler,
+    .renderer = render_otp_information_screen,
+    .enter = enter_otp_information_screen,
+};
+
 /*
  * Flash Information Screen
 */
 
-static void _render_hex_byte(uint8_t byte)
+static void _render_hex_byte(screen_buffer_t *screen_buffer, uint8_t byte)
 {
     char hex[3];
     uint8_to_hex(byte, hex);
     hex[2] = 0x00; // Guarantee the end.
-    _vt102_write_str(hex);
+    screen_buffer_write_str(screen_buffer, hex);
 }
 
 void render_flash_information_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    // Before reading the device information so the state it was found in is shown.
+    struct flash_power_stats power_stats;
+    flash_power_get_stats(&power_stats);
 
     flash_device_info_t device_info;
     pico_otp_flash_device_info(context->otp_core, &device_info);
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Flash Device Information");
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Flash Device Information");
 
-    vt102_cup("10", "10");
-    _vt102_write_str("Release Power Down ID   : 0x");
-    _render_hex_byte(device_info.manufacturer_id);
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "Release Power Down ID   : 0x");
+    _render_hex_byte(screen_buffer, device_info.manufacturer_id);
 
-    vt102_cup("11", "10");
-    _vt102_write_str("JEDEC Manufacturer ID   : 0x");
-    _render_hex_byte(device_info.jedec_id[0]);
+    screen_buffer_cup(screen_buffer, 11, 10);
+    screen_buffer_write_str(screen_buffer, "JEDEC Manufacturer ID   : 0x");
+    _render_hex_byte(screen_buffer, device_info.jedec_id[0]);
 
-    vt102_cup("12", "10");
-    _vt102_write_str("JEDEC Memory Type       : 0x");
-    _render_hex_byte(device_info.jedec_id[1]);
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "JEDEC Memory Type       : 0x");
+    _render_hex_byte(screen_buffer, device_info.jedec_id[1]);
 
-    vt102_cup("13", "10");
-    _vt102_write_str("JEDEC Capacity          : 0x");
-    _render_hex_byte(device_info.jedec_id[2]);
+    screen_buffer_cup(screen_buffer, 13, 10);
+    screen_buffer_write_str(screen_buffer, "JEDEC Capacity          : 0x");
+    _render_hex_byte(screen_buffer, device_info.jedec_id[2]);
 
     char unique_id[17];
     for (int i = 0; i < 8; i++)
@@ -915,9 +1444,9 @@ void render_flash_information_screen(struct otp_mgr_context *context)
     }
     unique_id[16] = 0x00; // Guarantee the end.
 
-    vt102_cup("14", "10");
-    _vt102_write_str("Unique ID               : ");
-    _vt102_write_str(unique_id);
+    screen_buffer_cup(screen_buffer, 14, 10);
+    screen_buffer_write_str(screen_buffer, "Unique ID               : ");
+    screen_buffer_write_str(screen_buffer, unique_id);
 
     char register_string[150];
     sprintf(register_string, "Status Register 1: BUSY: %d, WEL:  %d, BP0:  %d, BP1:  %d, BP2:  %d, TB:   %d, SEC:  %d,",
@@ -930,15 +1459,15 @@ void render_flash_information_screen(struct otp_mgr_context *context)
         (device_info.status_register_1 & WB_STATUS_REGISTER_1_SEC_MASK) >> 6
         );
 
-    vt102_cup("16", "10");
-    _vt102_write_str(register_string);
+    screen_buffer_cup(screen_buffer, 16, 10);
+    screen_buffer_write_str(screen_buffer, register_string);
 
     sprintf(register_string, "SRP0: %d",
         (device_info.status_register_1 & WB_STATUS_REGISTER_1_SRP0_MASK) >> 7
         );
 
-    vt102_cup("17", "29");
-    _vt102_write_str(register_string);
+    screen_buffer_cup(screen_buffer, 17, 29);
+    screen_buffer_write_str(screen_buffer, register_string);
 
     sprintf(register_string, "Status Register 2: SRL:  %d, QE:   %d, LB1:  %d, LB2:  %d, LB3:  %d, CMP:  %d, SUS:  %d",
         (device_info.status_register_2 & WB_STATUS_REGISTER_2_SRL_MASK) >> 0,
@@ -949,57 +1478,208 @@ void render_flash_information_screen(struct otp_mgr_context *context)
         (device_info.status_register_2 & WB_STATUS_REGISTER_2_CMP_MASK) >> 6,
         (device_info.status_register_2 & WB_STATUS_REGISTER_2_SUS_MASK) >> 7);
 
-    vt102_cup("18", "10");
-    _vt102_write_str(register_string);
+    screen_buffer_cup(screen_buffer, 18, 10);
+    screen_buffer_write_str(screen_buffer, register_string);
 
     sprintf(register_string, "Status Register 3: WPS:  %d, DRV0: %d, DRV1: %d",
         (device_info.status_register_3 & WB_STATUS_REGISTER_3_WPS_MASK) >> 2,
         (device_info.status_register_3 & WB_STATUS_REGISTER_3_DRV0_MASK) >> 5,
         (device_info.status_register_3 & WB_STATUS_REGISTER_3_DRV1_MASK) >> 6);
 
-    vt102_cup("19", "10");
-    _vt102_write_str(register_string);
+    screen_buffer_cup(screen_buffer, 19, 10);
+    screen_buffer_write_str(screen_buffer, register_string);
+
+    screen_buffer_cup(screen_buffer, 21, 10);
+    screen_buffer_write_str(screen_buffer, "Storage Initialised : ");
+    screen_buffer_write_str(screen_buffer, pico_otp_storage_initialised(context->otp_core) ? "Yes" : "No");
+    screen_buffer_write_str(screen_buffer, ", ");
+    screen_buffer_write_str(screen_buffer, pico_otp_storage_backend(context->otp_core));
+
+    bool locked = pico_otp_root_locked(context->otp_core);
+    screen_buffer_cup(screen_buffer, 22, 10);
+    screen_buffer_write_str(screen_buffer, "Root Record (SR1)   : ");
+    screen_buffer_write_str(screen_buffer, pico_otp_root_stored(context->otp_core) ? "Stored" : "Not Stored");
+    screen_buffer_write_str(screen_buffer, locked ? ", Locked" : ", Unlocked");
+
+    sprintf(register_string, "Power               : %s, %lu sleeps, %lu wakes (last %lu us, slowest %lu us), %lu of %lu from RAM",
+        power_stats.asleep ? "Deep Power-Down" : "Awake", power_stats.sleeps, power_stats.wakes,
+        power_stats.last_wake_us, power_stats.max_wake_us, power_stats.cached,
+        power_stats.accesses + power_stats.cached);
+    screen_buffer_cup(screen_buffer, 23, 10);
+    screen_buffer_write_str(screen_buffer, register_string);
+
+    struct flash_erase_status erase_status;
+    flash_erase_get_status(&erase_status);
+    if (erase_status.state != FLASH_ERASE_IDLE)
+    {
+        sprintf(register_string, "Erase               : %s %lu of %lu KiB in %lu ms, %lu suspends (last %lu us, slowest %lu us)",
+            erase_status.state == FLASH_ERASE_RUNNING ? "Running" : "Complete", erase_status.erased / 1024,
+            erase_status.length / 1024, erase_status.elapsed_us / 1000, erase_status.suspends,
+            erase_status.last_suspend_us, erase_status.max_suspend_us);
+        screen_buffer_cup(screen_buffer, 24, 10);
+        screen_buffer_write_str(screen_buffer, register_string);
+    }
 
-    vt102_cup("21", "10");
-    _vt102_write_str("Storage Initialised : ");
-    _vt102_write_str(pico_otp_storage_initialised(context->otp_core) ? "Yes" : "No");
+    const struct flash_geometry *geometry = flash_device_geometry();
+    screen_buffer_cup(screen_buffer, 25, 10);
+    if (!pico_otp_flash_ready(context->otp_core))
+    {
+        screen_buffer_write_str(screen_buffer, "Geometry            : No external flash");
+    }
+    else
+    {
+        if (geometry->sfdp)
+        {
+            sprintf(register_string, "Geometry            : SFDP %d.%d, ", geometry->sfdp_major, geometry->sfdp_minor);
+        }
+        else
+        {
+            sprintf(register_string, "Geometry            : JEDEC ID, ");
+        }
+        screen_buffer_write_str(screen_buffer, register_string);
+        sprintf(register_string, "%lu KiB, %d byte addresses, erase %lu KiB 0x%02X / %lu KiB 0x%02X",
+            geometry->size / 1024, geometry->address_bytes, geometry->sector_size / 1024,
+            geometry->sector_erase_opcode, geometry->block_size / 1024, geometry->block_erase_opcode);
+        screen_buffer_write_str(screen_buffer, register_string);
+        sprintf(register_string, "Read 0x%02X, Fast 0x%02X, Dual 0x%02X, Quad 0x%02X (single bit SPI)",
+            geometry->read_opcode, geometry->fast_read_opcode, geometry->dual_read_opcode,
+            geometry->quad_read_opcode);
+        screen_buffer_cup(screen_buffer, 26, 32);
+        screen_buffer_write_str(screen_buffer, register_string);
+    }
 
-    vt102_cup("23", "10");
-    _vt102_write_str("Press Q to return to the system information screen.");
+    if (context->screen.flash_information_screen.confirm_lock)
+    {
+        screen_buffer_cup(screen_buffer, 28, 10);
+        screen_buffer_write_str(screen_buffer, "Locking is permanent, the PIN can never be changed again.");
+        screen_buffer_cup(screen_buffer, 29, 10);
+        screen_buffer_write_str(screen_buffer, "Press Y to lock or any other key to cancel.");
+    }
+    else
+    {
+        screen_buffer_cup(screen_buffer, 28, 10);
+        screen_buffer_write_str(screen_buffer, locked ?
+            "Press Q to return to the system information screen." :
+            "Press L to lock the root record or Q to return to the system information screen.");
+    }
 
-    vt102_cup("25", "10");
-    _vt102_write_str("[ ]");
-    vt102_cup("25", "11");
+    screen_buffer_cup(screen_buffer, 31, 10);
+    screen_buffer_write_str(screen_buffer, "[ ]");
+    screen_buffer_cup(screen_buffer, 31, 11);
  }
 
+bool flash_information_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    struct flash_information_screen *flash_information_screen = &context->screen.flash_information_screen;
+    if (event->event_type != character)
+    {
+        return false;
+    }
+
+    if (flash_information_screen->confirm_lock)
+    {
+        flash_information_screen->confirm_lock = false;
+        if (event->character == 0x59 || event->character == 0x79)
+        {
+            context->error_message = pico_otp_lock_root(context->otp_core) ?
+                "Root record locked" : "Lock failed";
+        }
+        return true;
+    }
+
+    switch (event->character)
+    {
+    case 0x4C:
+    case 0x6C:
+        if (pico_otp_root_locked(context->otp_core))
+        {
+            context->error_message = "Already locked";
+        }
+        else if (!pico_otp_root_stored(context->otp_core))
+        {
+            context->error_message = "No root record to lock";
+        }
+        else
+        {
+            flash_information_screen->confirm_lock = true;
+        }
+        return true;
+    case 0x51:
+    case 0x71:
+        screen_pop(context);
+        return true;
+    }
+
+    return false;
+}
 
-static void init_flash_information_screen(struct otp_mgr_context *context)
+static void enter_flash_information_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Flash Information";
-    screen->commands = "OTP Information";
-    screen->footer = "Taking control of your security.";
-    screen->handler = return_to_system_information_screen_handler;
-    screen->renderer = render_flash_information_screen;
+    context->screen.flash_information_screen.confirm_lock = false;
 }
 
+
+static const struct screen_descriptor flash_information_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Flash Information",
+    .commands = "L - Lock Root Record, Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = flash_information_screen_handler,
+    .renderer = render_flash_information_screen,
+    .enter = enter_flash_information_screen,
+};
+
 /*
  * Change PIN Screen
  */
 
+void _handle_set_pin_result(int result, void *handback)
+{
+    struct otp_mgr_context *context = (struct otp_mgr_context *)handback;
+    struct change_pin_screen *change_pin_screen = &context->screen.change_pin_screen;
+
+    if (current_screen(context) == &change_pin_screen_descriptor && change_pin_screen->saving)
+    {
+        OTP_LOG_INFO("PIN change result: %d\n", result);
+        change_pin_screen->saved = true;
+        change_pin_screen->failed = result != 0;
+        otp_admin_notify(context->otp_admin_context);
+    }
+}
+
 bool change_pin_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
-    if (event->event_type == character && event->character == 0x71 || event->character == 0x51)
+    struct change_pin_screen *change_pin_screen = &context->screen.change_pin_screen;
+    if (change_pin_screen->saving)
+    {
+        // Nothing to do until the new PIN has been derived.
+        if (event->event_type == none && change_pin_screen->saved)
+        {
+            if (change_pin_screen->failed)
+            {
+                context->error_message = "PIN not changed";
+                change_pin_screen->saving = false;
+                change_pin_screen->saved = false;
+                change_pin_screen->first_pin_entered = false;
+            }
+            else
+            {
+                screen_pop(context);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    if (event->event_type == character && (event->character == 0x71 || event->character == 0x51))
     {
         // Quit
-        init_main_menu(context);
+        screen_pop(context);
         return true;
     }
     else if (event->event_type == character && event->character >= 0x30 && event->character <= 0x39)
     {
-        struct change_pin_screen *change_pin_screen = context->screen;
         char *pin = change_pin_screen->first_pin_entered ?
             change_pin_screen->confirm_pin :
             change_pin_screen->new_pin;
@@ -1009,27 +1689,43 @@ bool change_pin_screen_handler(vt102_event *event, struct otp_mgr_context *conte
             if (pin[i] == 0x00)
             {
                 pin[i] = event->character;
-                _vt102_write_char('*');
-                _vt102_write_flush();
-                break;
+                return true;
             }
         }
     }
     else if (event->event_type == control && event->character == 0x4D)
     {
-        struct change_pin_screen *change_pin_screen = context->screen;
-        if (change_pin_screen->first_pin_entered)
+        if (pico_otp_root_locked(context->otp_core))
+        {
+            context->error_message = "PIN locked in security register";
+            screen_pop(context);
+        }
+        else if (change_pin_screen->first_pin_entered)
         {
             if (strncmp(change_pin_screen->new_pin, change_pin_screen->confirm_pin, 9) == 0)
             {
-                // Change the pin.
-                pico_otp_set_pin(context->otp_core, change_pin_screen->new_pin);
-                init_main_menu(context);
+                // Change the pin, the screen is popped once the new PIN has been derived.
+                if (otp_main_set_pin(context->otp_main_context, change_pin_screen->new_pin,
+                    _handle_set_pin_result, context))
+                {
+                    change_pin_screen->saving = true;
+                    context->error_message = NULL;
+                }
+                else
+                {
+                    context->error_message = "Busy, try again";
+                    change_pin_screen->first_pin_entered = false;
+                }
+                // The derivation has already taken what it needs from the PIN.
+                for (int i = 0; i < 9; i++)
+                {
+                    change_pin_screen->new_pin[i] = 0x00;
+                    change_pin_screen->confirm_pin[i] = 0x00;
+                }
             }
             else
             {
-                struct base_screen_details *screen = context->screen;
-                screen->error_message = "PINs do not match";
+                context->error_message = "PINs do not match";
                 // Clear the entered pins.
                 for (int i = 0; i < 9; i++)
                 {
@@ -1043,7 +1739,7 @@ bool change_pin_screen_handler(vt102_event *event, struct otp_mgr_context *conte
         else
         {
             change_pin_screen->first_pin_entered = true;
-            change_pin_screen->base_screen_details.error_message = NULL;
+            context->error_message = NULL;
 
         }
         // User may have pressed enter after 1st pin - we need to refresh the screen.
@@ -1056,55 +1752,47 @@ bool change_pin_screen_handler(vt102_event *event, struct otp_mgr_context *conte
 
 void render_change_pin_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
-    struct change_pin_screen *change_pin_screen = context->screen;
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+    struct change_pin_screen *change_pin_screen = &context->screen.change_pin_screen;
 
-    vt102_cup("8", "10");
+    screen_buffer_cup(screen_buffer, 8, 10);
     change_pin_screen->first_pin_entered ?
-        _vt102_write_str("Please re-enter your new PIN and press <ENTER>") :
-        _vt102_write_str("Please enter your new PIN and press <ENTER>");
+        screen_buffer_write_str(screen_buffer, "Please re-enter your new PIN and press <ENTER>") :
+        screen_buffer_write_str(screen_buffer, "Please enter your new PIN and press <ENTER>");
 
     char *pin = change_pin_screen->first_pin_entered ?
         change_pin_screen->confirm_pin :
         change_pin_screen->new_pin;
 
-    vt102_cup("10", "10");
+    screen_buffer_cup(screen_buffer, 10, 10);
     int entered = 0;
     for (int i = 0; i < 8; i++) // The 9th is the null terminator.
     {
         if (pin[i] != 0x00)
         {
-            _vt102_write_char('*');
+            screen_buffer_write_char(screen_buffer, '*');
             entered++;
         }
         else
         {
-            _vt102_write_char('-');
+            screen_buffer_write_char(screen_buffer, '-');
         }
     }
-    int cursor = 10 + entered;
-    char cursor_string[3];
-    sprintf(cursor_string, "%d", cursor);
+    screen_buffer_cup(screen_buffer, 14, 10);
+    screen_buffer_write_str(screen_buffer, change_pin_screen->saving ?
+        "Saving PIN..." : "Press Q to return to the main menu.");
 
-    vt102_cup("14", "10");
-    _vt102_write_str("Press Q to return to the main menu.");
-
-    vt102_cup("10", cursor_string);
+    screen_buffer_cup(screen_buffer, 10, 10 + entered);
 }
 
-static void init_change_pin_screen(struct otp_mgr_context *context)
+static void enter_change_pin_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    struct change_pin_screen *change_pin_screen = context->screen;
-    change_pin_screen->base_screen_details.program_name = "Pico OATH";
-    change_pin_screen->base_screen_details.screen_name = "Change PIN";
-    change_pin_screen->base_screen_details.commands = "Q - Quit";
-    change_pin_screen->base_screen_details.footer = "Taking control of your security.";
-    change_pin_screen->base_screen_details.handler = change_pin_screen_handler;
-    change_pin_screen->base_screen_details.renderer = render_change_pin_screen;
-
+    struct change_pin_screen *change_pin_screen = &context->screen.change_pin_screen;
     change_pin_screen->first_pin_entered = false;
+    change_pin_screen->saving = false;
+    change_pin_screen->saved = false;
+    change_pin_screen->failed = false;
     // Clear the entered pins.
     for (int i = 0; i < 9; i++)
     {
@@ -1113,230 +1801,329 @@ static void init_change_pin_screen(struct otp_mgr_context *context)
     }
 }
 
+static const struct screen_descriptor change_pin_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Change PIN",
+    .commands = "Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = change_pin_screen_handler,
+    .renderer = render_change_pin_screen,
+    .enter = enter_change_pin_screen,
+};
+
+/*
+ * Addresses are shown and entered as 6 hex digits, or 8 for flash above 16 MiB.
+ */
+static uint8_t _address_digits()
+{
+    return flash_device_geometry()->address_bytes * 2;
+}
+
+static bool _is_hex_character(char character)
+{
+    return (character >= 0x30 && character <= 0x39) || (character >= 0x41 && character <= 0x46) ||
+        (character >= 0x61 && character <= 0x66);
+}
+
+static void _start_flash_search(struct otp_mgr_context *context, struct read_flash_screen *read_flash_screen)
+{
+    if (read_flash_screen->pattern_hex_length == 0 || read_flash_screen->pattern_hex_length % 2 != 0)
+    {
+        context->error_message = "Pattern must be an even number of characters";
+        return;
+    }
+
+    uint8_t pattern_length = read_flash_screen->pattern_hex_length / 2;
+    uint8_t pattern[FLASH_BROWSER_MAX_PATTERN];
+    for (int i = 0; i < pattern_length; i++)
+    {
+        pattern[i] = hex_to_char(&read_flash_screen->pattern_hex[i * 2]);
+    }
+
+    // Search forward from just after the page being displayed so repeated
+    // searches find each match in turn.
+    uint32_t from = read_flash_screen->display_data ? read_flash_screen->address + 1 : 0;
+    flash_browser_search_start(context->flash_browser, pattern, pattern_length, from);
+    read_flash_screen->search_percent = 0;
+    read_flash_screen->match_found = false;
+    context->error_message = NULL;
+}
+
 bool read_flash_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
-    char current = 0x00;
-    struct read_flash_screen *read_flash_screen = context->screen;
-    if (event->event_type == character && event->character == 0x71 || event->character == 0x51)
+    struct read_flash_screen *read_flash_screen = &context->screen.read_flash_screen;
+    flash_browser_t *flash_browser = context->flash_browser;
+
+    uint32_t search_address;
+    if (flash_browser_search_status(flash_browser, &search_address) == FLASH_BROWSER_SEARCH_RUNNING)
+    {
+        if (event->event_type != none)
+        {
+            // Any key cancels a search in progress.
+            flash_browser_search_cancel(flash_browser);
+            context->error_message = "Search cancelled";
+            return true;
+        }
+        return false;
+    }
+
+    bool next_page = (event->event_type == character && (event->character == 0x4E || event->character == 0x6E)) ||
+        (event->event_type == special && event->character == VT102_KEY_PAGE_DOWN);
+    bool previous_page = (event->event_type == character && (event->character == 0x50 || event->character == 0x70)) ||
+        (event->event_type == special && event->character == VT102_KEY_PAGE_UP);
+
+    if (event->event_type == character && (event->character == 0x71 || event->character == 0x51))
     {
         // Quit
-        init_system_information_screen(context);
+        screen_pop(context);
         return true;
     }
-    else if (event->event_type == character &&
-        ((event->character >= 0x30 && event->character <= 0x39) || (event->character >= 0x41 && event->character <= 0x46))
-        )
+    else if (read_flash_screen->display_data && (next_page || previous_page))
     {
-        current = event->character;
+        int64_t address = (int64_t)read_flash_screen->address +
+            (next_page ? FLASH_BROWSER_PAGE_SIZE : -FLASH_BROWSER_PAGE_SIZE);
+        read_flash_screen->address = flash_browser_clamp(flash_browser, address);
+
+        return true;
     }
-    else if (event->event_type == character && event->character >= 0x61 && event->character <= 0x66)
+    else if (event->event_type == character && event->character == '/')
     {
-        current = event->character - 0x20; // Convert to upper case.
+        // Enter a new search pattern.
+        read_flash_screen->entry = entry_pattern;
+        read_flash_screen->pattern_hex_length = 0;
+
+        return true;
     }
-    else if (read_flash_screen->display_data && event->event_type == character && (event->character == 0x4E || event->character == 0x6E))
+    else if (event->event_type == character && (event->character == 0x53 || event->character == 0x73))
     {
-        // Next page.
-        uint32_t address = 0x00 | read_flash_screen->entered_address[0] << 16 |
-            read_flash_screen->entered_address[1] << 8 |
-            read_flash_screen->entered_address[2];
-        address += 256;
-        read_flash_screen->entered_address[0] = (address >> 16) & 0xFF; // Three Address Bytes
-        read_flash_screen->entered_address[1] = (address >> 8) & 0xFF;
-        read_flash_screen->entered_address[2] = (address) & 0xFF;
+        // Search again for the last pattern.
+        _start_flash_search(context, read_flash_screen);
 
         return true;
     }
     else if (event->event_type == control && event->character == 0x4D)
     {
-        if (read_flash_screen->flash_address_length != 6)
+        if (read_flash_screen->entry == entry_pattern)
+        {
+            _start_flash_search(context, read_flash_screen);
+            read_flash_screen->entry = entry_address;
+        }
+        else if (read_flash_screen->flash_address_length != _address_digits())
         {
-            struct base_screen_details *screen = context->screen;
-            screen->error_message = "Incomplete memory address entered";
+            context->error_message = "Incomplete memory address entered";
             read_flash_screen->display_data = false;
         }
         else
         {
-            read_flash_screen->base_screen_details.error_message = NULL;
-            for (int i = 0; i < 3; i++)
+            context->error_message = NULL;
+            uint32_t address = 0x00;
+            for (int i = 0; i < _address_digits() / 2; i++)
             {
-                read_flash_screen->entered_address[i] = hex_to_char(&read_flash_screen->flash_address[i * 2]);
+                address = address << 8 | hex_to_char(&read_flash_screen->flash_address[i * 2]);
             }
+            read_flash_screen->address = flash_browser_clamp(flash_browser, address);
             read_flash_screen->flash_address_length = 0; // Start new entry.
             read_flash_screen->display_data = true;
+            read_flash_screen->match_found = false;
         }
 
         return true;
     }
-
-    // We know current was only set to valid HEX characters above.
-    if (current != 0x00 && read_flash_screen->flash_address_length < 6)
+    else if (event->event_type == character && _is_hex_character(event->character))
     {
-        read_flash_screen->flash_address[read_flash_screen->flash_address_length] = current;
-        read_flash_screen->flash_address_length++;
-        _vt102_write_char(current);
-        _vt102_write_flush();
+        char current = event->character >= 0x61 ? event->character - 0x20 : event->character; // Upper case.
+        if (read_flash_screen->entry == entry_pattern)
+        {
+            if (read_flash_screen->pattern_hex_length < FLASH_BROWSER_MAX_PATTERN * 2)
+            {
+                read_flash_screen->pattern_hex[read_flash_screen->pattern_hex_length++] = current;
+                return true;
+            }
+        }
+        else if (read_flash_screen->flash_address_length < _address_digits())
+        {
+            read_flash_screen->flash_address[read_flash_screen->flash_address_length++] = current;
+            return true;
+        }
     }
 
     return false;
 }
 
-void render_read_flash_screen(struct otp_mgr_context *context)
+static bool read_flash_screen_background(struct otp_mgr_context *context, bool *redraw)
 {
-    render_screen(context->screen);
+    struct read_flash_screen *read_flash_screen = &context->screen.read_flash_screen;
+    flash_browser_t *flash_browser = context->flash_browser;
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Please enter the address to read from and press <ENTER>");
-    vt102_cup("10", "10");
-    _vt102_write_str("Address: 0x");
+    bool remaining = flash_browser_run(flash_browser);
 
-    struct read_flash_screen *read_flash_screen = context->screen;
-    for (int i = 0; i < 6; i++)
+    uint32_t address;
+    switch (flash_browser_search_status(flash_browser, &address))
     {
-        if (i < read_flash_screen->flash_address_length)
-        {
-            _vt102_write_char(read_flash_screen->flash_address[i]);
-        }
-        else
+        case FLASH_BROWSER_SEARCH_RUNNING:
         {
-            _vt102_write_char('-');
+            // Only redraw as the progress visibly changes.
+            uint8_t percent = (uint64_t)address * 100 / flash_browser_flash_size(flash_browser);
+            if (percent != read_flash_screen->search_percent)
+            {
+                read_flash_screen->search_percent = percent;
+                *redraw = true;
+            }
+            break;
         }
+        case FLASH_BROWSER_SEARCH_FOUND:
+            // Display the page with the match on the first row.
+            read_flash_screen->address = flash_browser_clamp(flash_browser, address & ~(FLASH_BROWSER_ROW_SIZE - 1));
+            read_flash_screen->display_data = true;
+            read_flash_screen->match_found = true;
+            read_flash_screen->match_address = address;
+            flash_browser_search_cancel(flash_browser);
+            *redraw = true;
+            break;
+        case FLASH_BROWSER_SEARCH_NOT_FOUND:
+            context->error_message = "Pattern not found";
+            flash_browser_search_cancel(flash_browser);
+            *redraw = true;
+            break;
+        default:
+            break;
+    }
+
+    return remaining;
+}
+
+static void _render_hex_address(screen_buffer_t *screen_buffer, uint32_t address)
+{
+    char hex[9];
+    uint32_to_hex(address, hex);
+    hex[8] = 0x00;
+    screen_buffer_write_str(screen_buffer, &hex[8 - _address_digits()]);
+}
+
+static void _render_entry(screen_buffer_t *screen_buffer, const char *entered, uint8_t entered_length, uint8_t length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        screen_buffer_write_char(screen_buffer, i < entered_length ? entered[i] : '-');
     }
+}
 
-    vt102_cup("12", "10");
-    _vt102_write_str("Displaying Address: 0x");
+void render_read_flash_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    flash_browser_t *flash_browser = context->flash_browser;
+    render_screen(context);
+
+    struct read_flash_screen *read_flash_screen = &context->screen.read_flash_screen;
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, read_flash_screen->entry == entry_pattern ?
+        "Please enter the hex pattern to search for and press <ENTER>" :
+        "Please enter the address to read from and press <ENTER>, / to search");
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "Address: 0x");
+    _render_entry(screen_buffer, read_flash_screen->flash_address, read_flash_screen->flash_address_length,
+        _address_digits());
+    screen_buffer_cup(screen_buffer, 11, 10);
+    screen_buffer_write_str(screen_buffer, "Pattern: 0x");
+    _render_entry(screen_buffer, read_flash_screen->pattern_hex, read_flash_screen->pattern_hex_length,
+        FLASH_BROWSER_MAX_PATTERN * 2);
+
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "Displaying Address: 0x");
     if (read_flash_screen->display_data)
     {
-        char address[7];
-        for (int i = 0; i < 3; i++)
-        {
-            uint8_to_hex(read_flash_screen->entered_address[i], &address[i * 2]);
-        }
-        address[6] = 0x00;
-        _vt102_write_str(address);
+        _render_hex_address(screen_buffer, read_flash_screen->address);
     }
     else
     {
-        _vt102_write_str("------");
+        _render_entry(screen_buffer, NULL, 0, _address_digits());
     }
 
-    uint8_t data[256];
-    uint32_t address = 0x00;
-    if (read_flash_screen->display_data)
+    uint32_t search_address;
+    if (flash_browser_search_status(flash_browser, &search_address) == FLASH_BROWSER_SEARCH_RUNNING)
     {
-        address = 0x00 | read_flash_screen->entered_address[0] << 16 |
-            read_flash_screen->entered_address[1] << 8 |
-            read_flash_screen->entered_address[2];
-
-        pico_otp_flash_read_data(context->otp_core, address, data, 256);
+        char percent[4];
+        sprintf(percent, "%d", read_flash_screen->search_percent);
+        screen_buffer_write_str(screen_buffer, "    Searching 0x");
+        _render_hex_address(screen_buffer, search_address);
+        screen_buffer_write_str(screen_buffer, " ");
+        screen_buffer_write_str(screen_buffer, percent);
+        screen_buffer_write_str(screen_buffer, "%, press any key to cancel.");
     }
-
-    struct cursor_position actual_position;
-    for (int row = 0; row < 16; row++)
+    else if (read_flash_screen->match_found)
     {
-        uint8_t display_row = 14 + row;
-        char row_string[3];
-        sprintf(row_string, "%d", display_row);
-        vt102_cup(row_string, "5");
+        screen_buffer_write_str(screen_buffer, "    Match at 0x");
+        _render_hex_address(screen_buffer, read_flash_screen->match_address);
+    }
 
-        if (read_flash_screen->display_data)
-        {
-            char row_address[9];
-            uint32_to_hex(address + row * 16, row_address);
-            row_address[8] = 0x00;
-            printf("Row Address: %s\n", row_address);
-            _vt102_write_str(&row_address[2]);
-        }
-        else
-        {
-            _vt102_write_str("------");
-        }
-        _vt102_write_str("  ");
+    // Read ahead means the page is normally already in memory.
+    const uint8_t *data = read_flash_screen->display_data ?
+        flash_browser_page(flash_browser, read_flash_screen->address) : NULL;
 
-        for (int column = 0; column < 16; column++)
-        {
-            uint8_t index = row * 16 + column;
-            if (index < 256)
-            {
-                if (read_flash_screen->display_data)
-                {
-                    uint8_t byte = data[index];
-                    _render_hex_byte(byte);
-                    _vt102_write_str(" ");
-                }
-                else
-                {
-                    _vt102_write_str("-- ");
-                }
-            }
-            if (column == 7)
-            {
-                _vt102_write_str(" ");
-            }
-        }
-        _vt102_write_str(" |");
-        for (int column = 0; column < 16; column++)
-        {
-            uint8_t index = row * 16 + column;
-            if (index < 256)
-            {
-                uint8_t byte = data[index];
-                if (read_flash_screen->display_data && byte >= 0x20 && byte <= 0x7E)
-                {
-                    _vt102_write_char(byte);
-                }
-                else
-                {
-                    _vt102_write_char('.');
-                }
-            }
-            else
-            {
-                _vt102_write_char(' ');
-            }
-        }
-        _vt102_write_str("|");
-        _vt102_write_flush();
+    char line[FLASH_BROWSER_ROW_LENGTH + 1];
+    for (int row = 0; row < FLASH_BROWSER_PAGE_SIZE / FLASH_BROWSER_ROW_SIZE; row++)
+    {
+        uint32_t offset = row * FLASH_BROWSER_ROW_SIZE;
+        flash_browser_format_row(data != NULL ? &data[offset] : NULL, read_flash_screen->address + offset, line);
+        OTP_LOG_DEBUG("Row Address: 0x%08x\n", read_flash_screen->address + offset);
+        screen_buffer_cup(screen_buffer, 14 + row, 5);
+        screen_buffer_write_str(screen_buffer, line);
     }
 
     if (read_flash_screen->display_data)
     {
-        vt102_cup("31", "10");
-        _vt102_write_str("Press N for next page.");
+        screen_buffer_cup(screen_buffer, 31, 10);
+        screen_buffer_write_str(screen_buffer, "Press N or <PgDn> for the next page, P or <PgUp> for the previous page, S to search again.");
     }
 
-    vt102_cup("32", "10");
-    _vt102_write_str("Press Q to return to the system information screen.");
+    screen_buffer_cup(screen_buffer, 32, 10);
+    screen_buffer_write_str(screen_buffer, "Press Q to return to the system information screen.");
 
-    uint8_t column = 21 + read_flash_screen->flash_address_length;
-    char column_string[3];
-    sprintf(column_string, "%d", column);
-    vt102_cup("10", column_string);
+    if (read_flash_screen->entry == entry_pattern)
+    {
+        screen_buffer_cup(screen_buffer, 11, 21 + read_flash_screen->pattern_hex_length);
+    }
+    else
+    {
+        screen_buffer_cup(screen_buffer, 10, 21 + read_flash_screen->flash_address_length);
+    }
 }
 
-static void init_read_flash_screen(struct otp_mgr_context *context)
+static void enter_read_flash_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Read Flash";
-    screen->commands = "Read Flash";
-    screen->footer = "Taking control of your security.";
-    screen->handler = read_flash_screen_handler;
-    screen->renderer = render_read_flash_screen;
-
-    struct read_flash_screen *read_flash_screen = context->screen;
-    // Clear the entered address.
-    for (int i = 0; i < 6; i++) {
+    struct read_flash_screen *read_flash_screen = &context->screen.read_flash_screen;
+    // Clear the entered address and pattern.
+    for (int i = 0; i < sizeof(read_flash_screen->flash_address); i++) {
         read_flash_screen->flash_address[i] = 0x00;
     }
     read_flash_screen->flash_address_length = 0;
+    read_flash_screen->pattern_hex_length = 0;
+    read_flash_screen->entry = entry_address;
+    read_flash_screen->match_found = false;
     // Clear the display data bool.
     read_flash_screen->display_data = false;
-    // We don't need to clear the entered address as on used once
+    // We don't need to clear the address as it is only used once
     // display data is true AND that only happens after user has
     // set the address and pressed enter.
+
+    // The flash may have been written to since it was last browsed.
+    flash_browser_reset(context->flash_browser);
 }
 
+static const struct screen_descriptor read_flash_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Read Flash",
+    .commands = "Read Flash",
+    .footer = OTP_MGR_FOOTER,
+    .handler = read_flash_screen_handler,
+    .renderer = render_read_flash_screen,
+    .enter = enter_read_flash_screen,
+    .background = read_flash_screen_background,
+};
+
 /*
  * Reset Storage Screen
 */
@@ -1344,7 +2131,7 @@ static void init_read_flash_screen(struct otp_mgr_context *context)
 bool reset_storage_screen_handler(vt102_event *event, struct otp_mgr_context *context)
 {
     bool is_quit = false;
-    struct reset_storage_screen *reset_storage_screen = context->screen;
+    struct reset_storage_screen *reset_storage_screen = &context->screen.reset_storage_screen;
     // As a simple confirmation screen we are only interested
     // in character input.
     if (event->event_type == character)
@@ -1360,10 +2147,11 @@ bool reset_storage_screen_handler(vt102_event *event, struct otp_mgr_context *co
             // We are definately proceeding with the reset.
             bool initialise = event->character == 'y' || event->character == 'Y';
             pico_otp_reset_storage(context->otp_core, initialise);
+            context->error_message = "Erasing in the background, progress on Flash Information";
             // Handle as quit to return to menu.
             is_quit = true;
         } else {
-            printf("Character: %c\n", event->character);
+            OTP_LOG_DEBUG("Character: %c\n", event->character);
             // Only interested in Y or N.
             // Other characters are ignored.
             switch (event->character)
@@ -1382,7 +2170,7 @@ bool reset_storage_screen_handler(vt102_event *event, struct otp_mgr_context *co
 
     if (is_quit)
     {
-        init_system_information_screen(context);
+        screen_pop(context);
         return true;
     }
 
@@ -1391,56 +2179,1108 @@ bool reset_storage_screen_handler(vt102_event *event, struct otp_mgr_context *co
 
 void render_reset_storage_screen(struct otp_mgr_context *context)
 {
-    render_screen(context->screen);
-    struct reset_storage_screen *reset_storage_screen = context->screen;
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+    struct reset_storage_screen *reset_storage_screen = &context->screen.reset_storage_screen;
 
-    vt102_cup("8", "10");
-    _vt102_write_str("Reset Storage");
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Reset Storage");
 
     if (reset_storage_screen->confirm_reset)
     {
-        vt102_cup("12", "10");
-        _vt102_write_str("Do you also want to initialise the storage?");
+        screen_buffer_cup(screen_buffer, 12, 10);
+        screen_buffer_write_str(screen_buffer, "Do you also want to initialise the storage?");
 
-        vt102_cup("14", "10");
-        _vt102_write_str("Press Y to confirm, N to reset only.");
+        screen_buffer_cup(screen_buffer, 14, 10);
+        screen_buffer_write_str(screen_buffer, "Press Y to confirm, N to reset only.");
 
-        vt102_cup("15", "10");
-        _vt102_write_str("Press Q to abort and return to the previous menu.");
+        screen_buffer_cup(screen_buffer, 15, 10);
+        screen_buffer_write_str(screen_buffer, "Press Q to abort and return to the previous menu.");
 
-        vt102_cup("17", "10");
-        _vt102_write_str("[ ]");
-        vt102_cup("17", "11");
+        screen_buffer_cup(screen_buffer, 17, 10);
+        screen_buffer_write_str(screen_buffer, "[ ]");
+        screen_buffer_cup(screen_buffer, 17, 11);
     }
     else
     {
-        vt102_cup("10", "10");
-        _vt102_write_str("WARNING: This will reset all OTP data and the PIN.");
+        screen_buffer_cup(screen_buffer, 10, 10);
+        screen_buffer_write_str(screen_buffer, "WARNING: This will reset all OTP data and the PIN.");
 
-        vt102_cup("12", "10");
-        _vt102_write_str("Are you sure you want to reset the storage?");
+        screen_buffer_cup(screen_buffer, 12, 10);
+        screen_buffer_write_str(screen_buffer, "Are you sure you want to reset the storage?");
 
-        vt102_cup("14", "10");
-        _vt102_write_str("Press Y to confirm, N to cancel.");
+        screen_buffer_cup(screen_buffer, 14, 10);
+        screen_buffer_write_str(screen_buffer, "Press Y to confirm, N to cancel.");
 
-        vt102_cup("16", "10");
-        _vt102_write_str("[ ]");
-        vt102_cup("16", "11");
+        screen_buffer_cup(screen_buffer, 16, 10);
+        screen_buffer_write_str(screen_buffer, "[ ]");
+        screen_buffer_cup(screen_buffer, 16, 11);
     }
 }
 
-static void init_reset_storage_screen(struct otp_mgr_context *context)
+static void enter_reset_storage_screen(struct otp_mgr_context *context)
 {
-    struct base_screen_details *screen = context->screen;
-    init_screen(screen);
-    screen->program_name = "Pico OATH";
-    screen->screen_name = "Storage Reset";
-    screen->commands = "Storage Reset";
-    screen->footer = "Taking control of your security.";
-    screen->handler = reset_storage_screen_handler;
-    screen->renderer = render_reset_storage_screen;
-
-    struct reset_storage_screen *reset_storage_screen = context->screen;
+    struct reset_storage_screen *reset_storage_screen = &context->screen.reset_storage_screen;
     reset_storage_screen->confirm_reset = false;
 }
 
+static const struct screen_descriptor reset_storage_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Storage Reset",
+    .commands = "Storage Reset",
+    .footer = OTP_MGR_FOOTER,
+    .handler = reset_storage_screen_handler,
+    .renderer = render_reset_storage_screen,
+    .enter = enter_reset_storage_screen,
+};
+
+
+/*
+ * Flash Scan Screen
+ */
+
+#define FLASH_SCAN_SCREEN_ROWS 12
+#define FLASH_SCAN_SCREEN_COLUMNS 4
+#define FLASH_SCAN_SCREEN_SECTORS (FLASH_SCAN_SCREEN_ROWS * FLASH_SCAN_SCREEN_COLUMNS)
+
+static uint8_t _flash_scan_percent(struct flash_scan_status *status)
+{
+    return status->sectors == 0 ? 0 : (uint64_t)status->sectors_scanned * 100 / status->sectors;
+}
+
+bool flash_scan_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    struct flash_scan_screen *flash_scan_screen = &context->screen.flash_scan_screen;
+
+    struct flash_scan_status status;
+    flash_scan_get_status(&status);
+
+    bool next_page = (event->event_type == character && (event->character == 0x4E || event->character == 0x6E)) ||
+        (event->event_type == special && event->character == VT102_KEY_PAGE_DOWN);
+    bool previous_page = (event->event_type == character && (event->character == 0x50 || event->character == 0x70)) ||
+        (event->event_type == special && event->character == VT102_KEY_PAGE_UP);
+
+    if (event->event_type == character && (event->character == 0x71 || event->character == 0x51))
+    {
+        // Quit, any scan in progress continues in the background.
+        screen_pop(context);
+        return true;
+    }
+    else if (next_page)
+    {
+        if (flash_scan_screen->first_sector + FLASH_SCAN_SCREEN_SECTORS < status.sectors)
+        {
+            flash_scan_screen->first_sector += FLASH_SCAN_SCREEN_SECTORS;
+        }
+        return true;
+    }
+    else if (previous_page)
+    {
+        flash_scan_screen->first_sector = flash_scan_screen->first_sector >= FLASH_SCAN_SCREEN_SECTORS ?
+            flash_scan_screen->first_sector - FLASH_SCAN_SCREEN_SECTORS : 0;
+        return true;
+    }
+    else if (event->event_type == character && (event->character == 0x58 || event->character == 0x78))
+    {
+        flash_scan_cancel();
+        return true;
+    }
+    else if (event->event_type == control && event->character == 0x4D)
+    {
+        if (flash_scan_screen->pattern_hex_length % 2 != 0)
+        {
+            context->error_message = "Pattern must be an even number of characters";
+            return true;
+        }
+
+        uint8_t pattern_length = flash_scan_screen->pattern_hex_length / 2;
+        uint8_t pattern[FLASH_SCAN_MAX_PATTERN];
+        for (int i = 0; i < pattern_length; i++)
+        {
+            pattern[i] = hex_to_char(&flash_scan_screen->pattern_hex[i * 2]);
+        }
+
+        context->error_message = NULL;
+        pico_otp_flash_scan_start(context->otp_core, pattern, pattern_length);
+        flash_scan_screen->first_sector = 0;
+
+        return true;
+    }
+    else if (event->event_type == character && _is_hex_character(event->character) &&
+        flash_scan_screen->pattern_hex_length < FLASH_SCAN_MAX_PATTERN * 2)
+    {
+        char current = event->character >= 0x61 ? event->character - 0x20 : event->character; // Upper case.
+        flash_scan_screen->pattern_hex[flash_scan_screen->pattern_hex_length++] = current;
+        return true;
+    }
+
+    return false;
+}
+
+static bool flash_scan_screen_background(struct otp_mgr_context *context, bool *redraw)
+{
+    struct flash_scan_screen *flash_scan_screen = &context->screen.flash_scan_screen;
+
+    // The scan itself is run by the storage component, only follow the progress here.
+    struct flash_scan_status status;
+    flash_scan_get_status(&status);
+    uint8_t percent = _flash_scan_percent(&status);
+    if (status.state != flash_scan_screen->state || percent != flash_scan_screen->percent)
+    {
+        flash_scan_screen->state = status.state;
+        flash_scan_screen->percent = percent;
+        *redraw = true;
+    }
+
+    return false;
+}
+
+void render_flash_scan_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    struct flash_scan_screen *flash_scan_screen = &context->screen.flash_scan_screen;
+    struct flash_scan_status status;
+    flash_scan_get_status(&status);
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Enter an optional hex pattern to search for and press <ENTER> to scan the flash.");
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, "Pattern: 0x");
+    _render_entry(screen_buffer, flash_scan_screen->pattern_hex, flash_scan_screen->pattern_hex_length,
+        FLASH_SCAN_MAX_PATTERN * 2);
+
+    char line[100];
+    static const char *state_names[] = { "Idle", "Running", "Complete", "Cancelled" };
+    sprintf(line, "Status  : %s %d%%", state_names[status.state], _flash_scan_percent(&status));
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, line);
+
+    sprintf(line, "Sectors : %ld of %ld scanned, %ld erased", status.sectors_scanned, status.sectors,
+        status.erased_sectors);
+    screen_buffer_cup(screen_buffer, 13, 10);
+    screen_buffer_write_str(screen_buffer, line);
+
+    uint32_t elapsed_ms = status.elapsed_us / 1000;
+    uint32_t rate = elapsed_ms == 0 ? 0 :
+        (uint64_t)status.sectors_scanned * (FLASH_SCAN_SECTOR_SIZE / 1024) * 1000 / elapsed_ms;
+    sprintf(line, "Elapsed : %ld ms, %ld KiB/s", elapsed_ms, rate);
+    screen_buffer_cup(screen_buffer, 14, 10);
+    screen_buffer_write_str(screen_buffer, line);
+
+    if (status.pattern_length > 0)
+    {
+        sprintf(line, "Matches : %ld", status.matches);
+        screen_buffer_cup(screen_buffer, 15, 10);
+        screen_buffer_write_str(screen_buffer, line);
+        for (uint32_t i = 0; i < status.matches && i < FLASH_SCAN_MAX_MATCHES; i++)
+        {
+            screen_buffer_write_str(screen_buffer, i == 0 ? "  0x" : ", 0x");
+            _render_hex_address(screen_buffer, status.match_addresses[i]);
+        }
+    }
+
+    // Sector CRC32s, erased sectors are called out so programmed regions stand out.
+    for (int row = 0; row < FLASH_SCAN_SCREEN_ROWS; row++)
+    {
+        screen_buffer_cup(screen_buffer, 17 + row, 5);
+        for (int column = 0; column < FLASH_SCAN_SCREEN_COLUMNS; column++)
+        {
+            uint32_t sector = flash_scan_screen->first_sector + row * FLASH_SCAN_SCREEN_COLUMNS + column;
+            if (sector >= status.sectors)
+            {
+                break;
+            }
+
+            _render_hex_address(screen_buffer, sector * FLASH_SCAN_SECTOR_SIZE);
+            screen_buffer_write_str(screen_buffer, " ");
+            uint32_t crc;
+            if (flash_scan_sector_erased(sector))
+            {
+                screen_buffer_write_str(screen_buffer, " erased ");
+            }
+            else if (flash_scan_sector_crc(sector, &crc))
+            {
+                char hex[9];
+                uint32_to_hex(crc, hex);
+                hex[8] = 0x00;
+                screen_buffer_write_str(screen_buffer, hex);
+            }
+            else
+            {
+                screen_buffer_write_str(screen_buffer, "--------");
+            }
+            screen_buffer_write_str(screen_buffer, "    ");
+        }
+    }
+
+    screen_buffer_cup(screen_buffer, 31, 10);
+    screen_buffer_write_str(screen_buffer, "Press N or <PgDn> for the next sectors, P or <PgUp> for the previous sectors, X to cancel the scan.");
+    screen_buffer_cup(screen_buffer, 32, 10);
+    screen_buffer_write_str(screen_buffer, "Press Q to return to the system information screen.");
+
+    screen_buffer_cup(screen_buffer, 10, 21 + flash_scan_screen->pattern_hex_length);
+}
+
+static void enter_flash_scan_screen(struct otp_mgr_context *context)
+{
+    struct flash_scan_screen *flash_scan_screen = &context->screen.flash_scan_screen;
+    flash_scan_screen->pattern_hex_length = 0;
+    flash_scan_screen->first_sector = 0;
+    flash_scan_screen->percent = 0;
+    flash_scan_screen->state = FLASH_SCAN_IDLE;
+}
+
+static const struct screen_descriptor flash_scan_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Flash Scan",
+    .commands = "Flash Scan",
+    .footer = OTP_MGR_FOOTER,
+    .handler = flash_scan_screen_handler,
+    .renderer = render_flash_scan_screen,
+    .enter = enter_flash_scan_screen,
+    .background = flash_scan_screen_background,
+};
+
+/*
+ * TOTP Dashboard Screen
+ *
+ * Every credential is listed with its current code, the screen is rendered
+ * once a second but as the screen buffer only sends the changed cells each
+ * second costs a few bytes of countdown and the digits of any code which
+ * rolled over. Codes are only recalculated when their time step changes.
+ */
+
+#define DASHBOARD_FIRST_ROW 8
+#define DASHBOARD_ROWS 24
+#define DASHBOARD_COLUMN_WIDTH 44
+#define DASHBOARD_NAME_WIDTH 20
+#define DASHBOARD_BAR_WIDTH 10
+#define DASHBOARD_TIME_DIGITS 10 // Unix time in seconds.
+
+// Set by the alarm, cleared when the alarm fires so only one is ever pending.
+static volatile bool dashboard_tick_pending = false;
+
+static int64_t _dashboard_tick(alarm_id_t id, void *user_data)
+{
+    dashboard_tick_pending = false;
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return 0; // Do not reschedule.
+}
+
+static void _dashboard_end_entry(struct dashboard_screen *dashboard_screen)
+{
+    dashboard_screen->entry = dashboard_entry_none;
+    dashboard_screen->entered_length = 0;
+}
+
+static void _dashboard_entry_complete(struct otp_mgr_context *context)
+{
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+    char *entered = dashboard_screen->entered;
+    uint8_t entered_length = dashboard_screen->entered_length;
+
+    if (entered_length == 0)
+    {
+        // Nothing entered, treat as cancel.
+        _dashboard_end_entry(dashboard_screen);
+        return;
+    }
+
+    switch (dashboard_screen->entry)
+    {
+    case dashboard_entry_time:
+    {
+        uint64_t unix_time = 0;
+        for (int i = 0; i < entered_length; i++)
+        {
+            unix_time = unix_time * 10 + (entered[i] - 0x30);
+        }
+        pico_otp_set_time(context->otp_core, unix_time);
+        // All steps have changed.
+        for (int i = 0; i < PICO_OTP_MAX_CREDENTIALS; i++)
+        {
+            dashboard_screen->codes[i].step = UINT64_MAX;
+        }
+        _dashboard_end_entry(dashboard_screen);
+        break;
+    }
+    case dashboard_entry_name:
+        memcpy(dashboard_screen->name, entered, entered_length);
+        dashboard_screen->name[entered_length] = 0x00;
+        dashboard_screen->entry = dashboard_entry_secret;
+        dashboard_screen->entered_length = 0;
+        break;
+    case dashboard_entry_secret:
+    {
+        if (entered_length % 2 != 0)
+        {
+            context->error_message = "Secret must be an even number of characters";
+            return;
+        }
+
+        uint8_t secret_length = entered_length / 2;
+        uint8_t secret[secret_length];
+        for (int i = 0; i < secret_length; i++)
+        {
+            secret[i] = hex_to_char(&entered[i * 2]);
+        }
+        if (pico_otp_add_credential(context->otp_core, dashboard_screen->name, OTP_CREDENTIAL_TOTP,
+            secret, secret_length, OTP_MIN_DIGITS, PICO_OTP_DEFAULT_PERIOD) < 0)
+        {
+            context->error_message = "Credential table full";
+        }
+        _dashboard_end_entry(dashboard_screen);
+        break;
+    }
+    }
+}
+
+static uint8_t _dashboard_entry_limit(uint8_t entry)
+{
+    switch (entry)
+    {
+    case dashboard_entry_time:
+        return DASHBOARD_TIME_DIGITS;
+    case dashboard_entry_name:
+        return PICO_OTP_NAME_LENGTH - 1;
+    default:
+        return PICO_OTP_MAX_SECRET * 2;
+    }
+}
+
+static bool _dashboard_entry_accepts(uint8_t entry, char character)
+{
+    switch (entry)
+    {
+    case dashboard_entry_time:
+        return character >= 0x30 && character <= 0x39;
+    case dashboard_entry_name:
+        return character >= 0x20 && character <= 0x7E;
+    default:
+        return _is_hex_character(character);
+    }
+}
+
+bool dashboard_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+
+    if (dashboard_screen->entry != dashboard_entry_none)
+    {
+        if (event->event_type == control && event->character == 0x4D)
+        {
+            _dashboard_entry_complete(context);
+            return true;
+        }
+        else if (event->event_type == character && _dashboard_entry_accepts(dashboard_screen->entry, event->character) &&
+            dashboard_screen->entered_length < _dashboard_entry_limit(dashboard_screen->entry))
+        {
+            char current = event->character;
+            if (dashboard_screen->entry == dashboard_entry_secret && current >= 0x61)
+            {
+                current -= 0x20; // Upper case.
+            }
+            dashboard_screen->entered[dashboard_screen->entered_length++] = current;
+            return true;
+        }
+
+        return false;
+    }
+
+    if (event->event_type == character)
+    {
+        switch (event->character)
+        {
+        case 0x51:
+        case 0x71:
+            screen_pop(context);
+            return true;
+        case 0x54:
+        case 0x74:
+            dashboard_screen->entry = dashboard_entry_time;
+            return true;
+        case 0x41:
+        case 0x61:
+            if (pico_otp_credential_count(context->otp_core) < PICO_OTP_MAX_CREDENTIALS)
+            {
+                dashboard_screen->entry = dashboard_entry_name;
+            }
+            else
+            {
+                context->error_message = "Credential table full";
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool dashboard_screen_background(struct otp_mgr_context *context, bool *redraw)
+{
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+    if (!pico_otp_time_set(context->otp_core))
+    {
+        return false;
+    }
+
+    uint64_t now_us = pico_otp_time_us(context->otp_core);
+    uint64_t second = now_us / 1000000;
+    if (second != dashboard_screen->second)
+    {
+        dashboard_screen->second = second;
+        *redraw = true;
+    }
+
+    if (!dashboard_tick_pending)
+    {
+        // Wake just after the start of the next second, the main loop otherwise sleeps.
+        dashboard_tick_pending = true;
+        add_alarm_in_us(1000000 - (now_us % 1000000) + 1000, _dashboard_tick, NULL, true);
+    }
+
+    return false;
+}
+
+static void _render_dashboard_credential(struct otp_mgr_context *context, uint8_t index, uint64_t now)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+    const struct otp_credential *credential = pico_otp_get_credential(context->otp_core, index);
+
+    uint8_t row = DASHBOARD_FIRST_ROW + index % DASHBOARD_ROWS;
+    uint8_t column = 2 + (index / DASHBOARD_ROWS) * DASHBOARD_COLUMN_WIDTH;
+    screen_buffer_cup(screen_buffer, row, column);
+
+    char name[DASHBOARD_NAME_WIDTH + 1];
+    snprintf(name, sizeof(name), "%-*s", DASHBOARD_NAME_WIDTH, credential->name);
+    screen_buffer_write_str(screen_buffer, name);
+    screen_buffer_write_char(screen_buffer, ' ');
+
+    if (credential->type != OTP_CREDENTIAL_TOTP)
+    {
+        screen_buffer_write_str(screen_buffer, "--- --- HOTP");
+        return;
+    }
+    else if (!pico_otp_time_set(context->otp_core))
+    {
+        screen_buffer_write_str(screen_buffer, "--- ---");
+        return;
+    }
+
+    struct totp_code *code = &dashboard_screen->codes[index];
+    uint64_t step = now / credential->period;
+    if (code->step != step)
+    {
+        if (dashboard_screen->calculated == 0)
+        {
+            // Held until the rest of the batch is calculated.
+            clock_policy_boost(CLOCK_OP_OTP_BATCH);
+        }
+        pico_otp_calculate_totp(context->otp_core, index, step, code->otp);
+        code->step = step;
+        dashboard_screen->calculated++;
+    }
+
+    // Split as "123 456" for readability, padded so the bars align whatever the digits.
+    char otp[OTP_MAX_DIGITS + 3];
+    uint8_t split = credential->digits / 2;
+    snprintf(otp, sizeof(otp), "%.*s %-*s", split, code->otp, OTP_MAX_DIGITS - split + 1, &code->otp[split]);
+    screen_buffer_write_str(screen_buffer, otp);
+
+    // The bar empties as the period runs out, only a cell at a time changes.
+    uint32_t remaining = credential->period - now % credential->period;
+    uint32_t filled = (remaining * DASHBOARD_BAR_WIDTH + credential->period - 1) / credential->period;
+    for (uint32_t i = 0; i < DASHBOARD_BAR_WIDTH; i++)
+    {
+        screen_buffer_write_char(screen_buffer, i < filled ? '#' : '.');
+    }
+}
+
+void render_dashboard_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+    otp_core_t *otp_core = context->otp_core;
+
+    char line[100];
+    screen_buffer_cup(screen_buffer, 6, 2);
+    if (pico_otp_time_set(otp_core))
+    {
+        uint64_t now = pico_otp_time_us(otp_core) / 1000000;
+        uint32_t seconds_today = now % 86400;
+        sprintf(line, "Time %02ld:%02ld:%02ld UTC", seconds_today / 3600, (seconds_today / 60) % 60,
+            seconds_today % 60);
+        screen_buffer_write_str(screen_buffer, line);
+
+        dashboard_screen->calculated = 0;
+        for (uint8_t i = 0; i < pico_otp_credential_count(otp_core); i++)
+        {
+            _render_dashboard_credential(context, i, now);
+        }
+        if (dashboard_screen->calculated > 0)
+        {
+            clock_policy_release(CLOCK_OP_OTP_BATCH);
+        }
+    }
+    else
+    {
+        screen_buffer_write_str(screen_buffer, "Time not set, press T to set the current Unix time.");
+        for (uint8_t i = 0; i < pico_otp_credential_count(otp_core); i++)
+        {
+            _render_dashboard_credential(context, i, 0);
+        }
+    }
+
+    if (pico_otp_credential_count(otp_core) == 0)
+    {
+        screen_buffer_cup(screen_buffer, DASHBOARD_FIRST_ROW, 2);
+        screen_buffer_write_str(screen_buffer, "No credentials, press A to add a TOTP credential.");
+    }
+
+    // The cost of the previous update, a steady state second should be a handful of bytes.
+    struct screen_buffer_stats stats;
+    screen_buffer_get_stats(screen_buffer, &stats);
+    sprintf(line, "Last update %ld bytes, %d codes calculated", stats.last_frame_bytes,
+        dashboard_screen->calculated);
+    screen_buffer_cup(screen_buffer, 6, 60);
+    screen_buffer_write_str(screen_buffer, line);
+
+    screen_buffer_cup(screen_buffer, 32, 2);
+    switch (dashboard_screen->entry)
+    {
+    case dashboard_entry_time:
+        screen_buffer_write_str(screen_buffer, "Unix time: ");
+        break;
+    case dashboard_entry_name:
+        screen_buffer_write_str(screen_buffer, "Name: ");
+        break;
+    case dashboard_entry_secret:
+        screen_buffer_write_str(screen_buffer, "Secret (hex): ");
+        break;
+    default:
+        screen_buffer_write_str(screen_buffer, "[ ]");
+        screen_buffer_cup(screen_buffer, 32, 3);
+        return;
+    }
+
+    for (int i = 0; i < dashboard_screen->entered_length; i++)
+    {
+        screen_buffer_write_char(screen_buffer, dashboard_screen->entered[i]);
+    }
+}
+
+static void enter_dashboard_screen(struct otp_mgr_context *context)
+{
+    struct dashboard_screen *dashboard_screen = &context->screen.dashboard_screen;
+    for (int i = 0; i < PICO_OTP_MAX_CREDENTIALS; i++)
+    {
+        dashboard_screen->codes[i].step = UINT64_MAX;
+    }
+    dashboard_screen->second = 0;
+    dashboard_screen->calculated = 0;
+    _dashboard_end_entry(dashboard_screen);
+}
+
+static const struct screen_descriptor dashboard_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "TOTP Dashboard",
+    .commands = "T - Set Time, A - Add TOTP, Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = dashboard_screen_handler,
+    .renderer = render_dashboard_screen,
+    .enter = enter_dashboard_screen,
+    .background = dashboard_screen_background,
+};
+
+/*
+ * Credential Search Screen
+ */
+
+#define CREDENTIAL_SEARCH_FIRST_ROW 11
+
+static void _credential_search(struct otp_mgr_context *context)
+{
+    struct credential_search_screen *search_screen = &context->screen.credential_search_screen;
+    search_screen->query[search_screen->query_length] = 0x00;
+
+    uint32_t start = time_us_32();
+    search_screen->total = pico_otp_find_credentials(context->otp_core, search_screen->query,
+        search_screen->results, CREDENTIAL_SEARCH_ROWS);
+    search_screen->search_us = time_us_32() - start;
+}
+
+bool credential_search_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    struct credential_search_screen *search_screen = &context->screen.credential_search_screen;
+
+    if (event->event_type == control && (event->character == 0x3F || event->character == 0x48))
+    {
+        // DEL or BS
+        if (search_screen->query_length > 0)
+        {
+            search_screen->query_length--;
+            _credential_search(context);
+        }
+        return true;
+    }
+    else if (event->event_type == control && event->character == 0x4D)
+    {
+        // Enter leaves, there is nothing to confirm.
+        screen_pop(context);
+        return true;
+    }
+    else if (event->event_type == character && event->character >= 0x20 && event->character <= 0x7E &&
+        search_screen->query_length < PICO_OTP_NAME_LENGTH - 1)
+    {
+        search_screen->query[search_screen->query_length++] = event->character;
+        _credential_search(context);
+        return true;
+    }
+
+    return false;
+}
+
+void render_credential_search_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    struct credential_search_screen *search_screen = &context->screen.credential_search_screen;
+
+    char line[60];
+    sprintf(line, "%d found in %ld us", search_screen->total, search_screen->search_us);
+    screen_buffer_cup(screen_buffer, 9, 10);
+    screen_buffer_write_str(screen_buffer, line);
+
+    // Only the rows which differ from the last keystroke are sent by the screen buffer.
+    for (int i = 0; i < search_screen->total; i++)
+    {
+        const struct otp_credential *credential = pico_otp_get_credential(context->otp_core, search_screen->results[i]);
+        screen_buffer_cup(screen_buffer, CREDENTIAL_SEARCH_FIRST_ROW + i, 10);
+        screen_buffer_write_str(screen_buffer, credential->type == OTP_CREDENTIAL_TOTP ? "TOTP  " : "HOTP  ");
+        screen_buffer_write_str(screen_buffer, credential->name);
+    }
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Search: ");
+    screen_buffer_write_str(screen_buffer, search_screen->query);
+}
+
+static void enter_credential_search_screen(struct otp_mgr_context *context)
+{
+    struct credential_search_screen *search_screen = &context->screen.credential_search_screen;
+    search_screen->query_length = 0;
+    _credential_search(context);
+}
+
+static const struct screen_descriptor credential_search_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Find Credential",
+    .commands = "Type to search, <ENTER> - Return",
+    .footer = OTP_MGR_FOOTER,
+    .handler = credential_search_screen_handler,
+    .renderer = render_credential_search_screen,
+    .enter = enter_credential_search_screen,
+};
+
+/*
+ * Import Screen
+ *
+ * otpauth:// URIs are parsed as they are pasted, the credentials are staged
+ * and added in a single batch on <ENTER> so a migration from another
+ * authenticator is all or nothing.
+ */
+
+static bool _import_result(struct otp_mgr_context *context, enum otpauth_result result)
+{
+    struct import_screen *import_screen = &context->screen.import_screen;
+    switch (result)
+    {
+    case OTPAUTH_COMPLETE:
+        if (import_screen->staged + pico_otp_credential_count(context->otp_core) < PICO_OTP_MAX_CREDENTIALS)
+        {
+            memcpy(&context->import_staging[import_screen->staged++], &import_screen->parser.credential,
+                sizeof(struct otp_credential));
+        }
+        else
+        {
+            import_screen->rejected++;
+            import_screen->last_error = "Credential table full";
+        }
+        return true;
+    case OTPAUTH_ERROR:
+        import_screen->rejected++;
+        import_screen->last_error = import_screen->parser.error;
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t import_screen_batch_handler(const char *characters, uint32_t length,
+    struct otp_mgr_context *context, bool *redraw)
+{
+    struct otpauth_parser *parser = &context->screen.import_screen.parser;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        *redraw |= _import_result(context, otpauth_parser_put(parser, characters[i]));
+    }
+
+    return length;
+}
+
+bool import_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    struct import_screen *import_screen = &context->screen.import_screen;
+
+    if (event->event_type == special && event->character == VT102_KEY_PASTE_END)
+    {
+        // The last URI of a paste may not be followed by a new line.
+        return _import_result(context, otpauth_parser_finish(&import_screen->parser));
+    }
+    else if (event->event_type == control && event->character == 0x4D)
+    {
+        _import_result(context, otpauth_parser_finish(&import_screen->parser));
+        if (import_screen->staged == 0)
+        {
+            screen_pop(context);
+        }
+        else if (pico_otp_add_credentials(context->otp_core, context->import_staging, import_screen->staged))
+        {
+            import_screen->imported = import_screen->staged;
+            import_screen->staged = 0;
+            import_screen->rejected = 0;
+            import_screen->last_error = NULL;
+        }
+        else
+        {
+            context->error_message = "Not enough room for the credentials";
+        }
+        return true;
+    }
+    else if (event->event_type == control && event->character == 0x58)
+    {
+        // Ctrl+X discards anything staged.
+        otpauth_parser_init(&import_screen->parser);
+        import_screen->staged = 0;
+        import_screen->rejected = 0;
+        import_screen->last_error = NULL;
+        return true;
+    }
+
+    return false;
+}
+
+void render_import_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    struct import_screen *import_screen = &context->screen.import_screen;
+    char line[80];
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Paste one or more otpauth:// URIs, one per line.");
+
+    sprintf(line, "%d staged, %d rejected", import_screen->staged, import_screen->rejected);
+    screen_buffer_cup(screen_buffer, 10, 10);
+    screen_buffer_write_str(screen_buffer, line);
+    if (import_screen->last_error != NULL)
+    {
+        screen_buffer_write_str(screen_buffer, ", last error: ");
+        screen_buffer_write_str(screen_buffer, import_screen->last_error);
+    }
+
+    for (int i = 0; i < import_screen->staged && i < 16; i++)
+    {
+        screen_buffer_cup(screen_buffer, 12 + i, 12);
+        screen_buffer_write_str(screen_buffer, context->import_staging[i].type == OTP_CREDENTIAL_TOTP ? "TOTP  " : "HOTP  ");
+        screen_buffer_write_str(screen_buffer, context->import_staging[i].name);
+    }
+
+    if (import_screen->imported > 0)
+    {
+        sprintf(line, "Imported %d credentials.", import_screen->imported);
+        screen_buffer_cup(screen_buffer, 29, 10);
+        screen_buffer_write_str(screen_buffer, line);
+    }
+
+    screen_buffer_cup(screen_buffer, 31, 10);
+    screen_buffer_write_str(screen_buffer, "Press <ENTER> to import the staged credentials, Ctrl+X to discard them.");
+    screen_buffer_cup(screen_buffer, 32, 10);
+    screen_buffer_write_str(screen_buffer, "Press <ENTER> with nothing staged to return to the main menu.");
+
+    screen_buffer_cup(screen_buffer, 10, 10);
+}
+
+static void enter_import_screen(struct otp_mgr_context *context)
+{
+    struct import_screen *import_screen = &context->screen.import_screen;
+    if (context->import_staging == NULL)
+    {
+        context->import_staging = malloc(PICO_OTP_MAX_CREDENTIALS * sizeof(struct otp_credential));
+    }
+    otpauth_parser_init(&import_screen->parser);
+    import_screen->staged = 0;
+    import_screen->rejected = 0;
+    import_screen->last_error = NULL;
+    import_screen->imported = 0;
+}
+
+static const struct screen_descriptor import_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Import Credentials",
+    .commands = "<ENTER> - Import, Ctrl+X - Discard",
+    .footer = OTP_MGR_FOOTER,
+    .handler = import_screen_handler,
+    .batch_handler = import_screen_batch_handler,
+    .renderer = render_import_screen,
+    .enter = enter_import_screen,
+};
+
+/*
+ * Boot Profile Screen
+ */
+
+void render_boot_profile_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "Phase                      Time (us)     Step (us)");
+
+    // USB enumeration completes alongside the later phases so list the phases
+    // in the order they were reached, those not yet reached last.
+    uint8_t order[BOOT_PHASE_COUNT];
+    uint32_t times[BOOT_PHASE_COUNT];
+    int reached = 0;
+    for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+    {
+        uint32_t time_us;
+        if (boot_profile_get(phase, &time_us))
+        {
+            int i = reached++;
+            for (; i > 0 && times[i - 1] > time_us; i--)
+            {
+                order[i] = order[i - 1];
+                times[i] = times[i - 1];
+            }
+            order[i] = phase;
+            times[i] = time_us;
+        }
+    }
+
+    char line[80];
+    int row = 10;
+    for (int i = 0; i < reached; i++)
+    {
+        sprintf(line, "%-24s %10ld    %10ld", boot_profile_name(order[i]), times[i],
+            times[i] - (i > 0 ? times[i - 1] : 0));
+        screen_buffer_cup(screen_buffer, row++, 10);
+        screen_buffer_write_str(screen_buffer, line);
+    }
+    for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++)
+    {
+        uint32_t time_us;
+        if (!boot_profile_get(phase, &time_us))
+        {
+            sprintf(line, "%-24s %10s", boot_profile_name(phase), "-");
+            screen_buffer_cup(screen_buffer, row++, 10);
+            screen_buffer_write_str(screen_buffer, line);
+        }
+    }
+
+    screen_buffer_cup(screen_buffer, 12 + BOOT_PHASE_COUNT, 10);
+    screen_buffer_write_str(screen_buffer, "Press Q to return to the system information screen.");
+}
+
+static const struct screen_descriptor boot_profile_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Boot Profile",
+    .commands = "Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = return_to_previous_screen_handler,
+    .renderer = render_boot_profile_screen,
+};
+
+/*
+ * Performance Screen
+ */
+
+static void _render_perf_run(screen_buffer_t *screen_buffer, uint8_t row, const char *name,
+    struct otp_perf_run *cold, struct otp_perf_run *warm)
+{
+    char line[100];
+    sprintf(line, "%-24s %8ld (%4ld / %4ld)   %8ld (%4ld / %4ld)", name,
+        cold->cycles, cold->xip.accesses, cold->xip.hits,
+        warm->cycles, warm->xip.accesses, warm->xip.hits);
+    screen_buffer_cup(screen_buffer, row, 10);
+    screen_buffer_write_str(screen_buffer, line);
+}
+
+void render_performance_screen(struct otp_mgr_context *context)
+{
+    screen_buffer_t *screen_buffer = context->screen_buffer;
+    render_screen(context);
+
+    struct otp_perf_xip xip;
+    otp_perf_get_xip(&xip);
+    // Tenths of a percent, 64 bit as the counters run from reset.
+    uint32_t hit_rate = xip.accesses > 0 ? (uint64_t) xip.hits * 1000 / xip.accesses : 0;
+
+    char line[100];
+    screen_buffer_cup(screen_buffer, 8, 10);
+    screen_buffer_write_str(screen_buffer, "XIP Cache Since Reset");
+    sprintf(line, "Accesses: %lu, Hits: %lu, Hit Rate: %lu.%lu%%", xip.accesses, xip.hits,
+        hit_rate / 10, hit_rate % 10);
+    screen_buffer_cup(screen_buffer, 9, 12);
+    screen_buffer_write_str(screen_buffer, line);
+
+    struct otp_perf_hotp_benchmark *benchmark = &context->screen.performance_screen.benchmark;
+    screen_buffer_cup(screen_buffer, 11, 10);
+    screen_buffer_write_str(screen_buffer, "HOTP Calculation          Cache flushed, cycles     Cache warm, cycles");
+    screen_buffer_cup(screen_buffer, 12, 10);
+    screen_buffer_write_str(screen_buffer, "                          (XIP accesses / hits)     (XIP accesses / hits)");
+#ifdef OTP_HOT_PATHS_IN_FLASH
+    _render_perf_run(screen_buffer, 13, "HMAC path, in flash", &benchmark->hmac_cold, &benchmark->hmac_warm);
+#else
+    _render_perf_run(screen_buffer, 13, "HMAC path, in SRAM", &benchmark->hmac_cold, &benchmark->hmac_warm);
+#endif
+    _render_perf_run(screen_buffer, 14, "Assembly kernel, in flash", &benchmark->kernel_cold, &benchmark->kernel_warm);
+
+    struct clock_policy_stats clock_stats;
+    clock_policy_get_stats(&clock_stats);
+    screen_buffer_cup(screen_buffer, 16, 10);
+    screen_buffer_write_str(screen_buffer, "Clock Policy");
+    sprintf(line, "clk_sys %lu kHz, %lu changes, last %lu us, slowest %lu us", clock_stats.khz,
+        clock_stats.transitions, clock_stats.last_transition_us, clock_stats.max_transition_us);
+    screen_buffer_cup(screen_buffer, 17, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    sprintf(line, "Idle %lu ms, boosted %lu ms", (uint32_t)(clock_stats.low_us / 1000),
+        (uint32_t)(clock_stats.high_us / 1000));
+    screen_buffer_cup(screen_buffer, 18, 12);
+    screen_buffer_write_str(screen_buffer, line);
+    screen_buffer_cup(screen_buffer, 19, 12);
+    screen_buffer_write_str(screen_buffer, "Operation   Count   Total ms   Total uJ     Last us    Last uJ");
+    for (int i = 0; i < CLOCK_OP_COUNT; i++)
+    {
+        struct clock_policy_operation_stats *operation = &clock_stats.operations[i];
+        sprintf(line, "%-10s %6lu %10lu %10lu  %10lu %10lu", clock_policy_operation_name(i), operation->count,
+            (uint32_t)(operation->total_us / 1000), (uint32_t) operation->total_uj, operation->last_us,
+            operation->last_uj);
+        screen_buffer_cup(screen_buffer, 20 + i, 12);
+        screen_buffer_write_str(screen_buffer, line);
+    }
+
+    struct performance_screen *performance_screen = &context->screen.performance_screen;
+    uint8_t row = 21 + CLOCK_OP_COUNT;
+    screen_buffer_cup(screen_buffer, row++, 10);
+    screen_buffer_write_str(screen_buffer, "Storage Backends, 4 KiB");
+    screen_buffer_cup(screen_buffer, row++, 12);
+    screen_buffer_write_str(screen_buffer, "Backend                   Erase us   Program us    Read us   Read KiB/s");
+    for (int i = 0; i < performance_screen->storage_count; i++)
+    {
+        struct storage_benchmark *storage = &performance_screen->storage[i];
+        if (storage->state != STORAGE_BENCHMARK_COMPLETE)
+        {
+            sprintf(line, "%-24s running", storage->name);
+        }
+        else if (storage->skipped)
+        {
+            sprintf(line, "%-24s busy or too small", storage->name);
+        }
+        else
+        {
+            uint32_t rate = storage->read_us > 0 ? STORAGE_BENCHMARK_LENGTH * 1000000ull / 1024 / storage->read_us : 0;
+            sprintf(line, "%-24s %9lu %12lu %10lu %12lu%s", storage->name, storage->erase_us, storage->program_us,
+                storage->read_us, rate, storage->verified ? "" : "  mismatch");
+        }
+        screen_buffer_cup(screen_buffer, row++, 12);
+        screen_buffer_write_str(screen_buffer, line);
+    }
+
+    screen_buffer_cup(screen_buffer, row + 1, 10);
+    screen_buffer_write_str(screen_buffer,
+        "Press R to run again, S to benchmark storage or Q to return to the system information screen.");
+}
+
+bool performance_screen_handler(vt102_event *event, struct otp_mgr_context *context)
+{
+    if (event->event_type == character && (event->character == 0x52 || event->character == 0x72))
+    {
+        otp_perf_hotp_benchmark(&context->screen.performance_screen.benchmark);
+        return true;
+    }
+    if (event->event_type == character && (event->character == 0x53 || event->character == 0x73))
+    {
+        // Erases and programs scratch at the end of each backend so only run on request,
+        // the benchmarks are advanced by performance_screen_background.
+        struct performance_screen *performance_screen = &context->screen.performance_screen;
+        performance_screen->storage_count = pico_otp_storage_benchmark_start(context->otp_core,
+            performance_screen->storage, STORAGE_BACKENDS);
+        performance_screen->storage_running = performance_screen->storage_count > 0;
+        return true;
+    }
+
+    return return_to_previous_screen_handler(event, context);
+}
+
+static bool performance_screen_background(struct otp_mgr_context *context, bool *redraw)
+{
+    struct performance_screen *performance_screen = &context->screen.performance_screen;
+    if (!performance_screen->storage_running)
+    {
+        return false;
+    }
+
+    uint8_t completed = 0;
+    for (int i = 0; i < performance_screen->storage_count; i++)
+    {
+        completed += performance_screen->storage[i].state == STORAGE_BENCHMARK_COMPLETE ? 1 : 0;
+    }
+
+    performance_screen->storage_running = pico_otp_storage_benchmark_run(context->otp_core,
+        performance_screen->storage, performance_screen->storage_count);
+
+    // Redrawn as each backend completes, whilst an erase is polled the backend's
+    // own alarm wakes the main loop so there is no need to come straight back.
+    for (int i = 0; i < performance_screen->storage_count; i++)
+    {
+        completed -= performance_screen->storage[i].state == STORAGE_BENCHMARK_COMPLETE ? 1 : 0;
+    }
+    *redraw = completed != 0;
+
+    return performance_screen->storage_running && *redraw;
+}
+
+static void enter_performance_screen(struct otp_mgr_context *context)
+{
+    otp_perf_hotp_benchmark(&context->screen.performance_screen.benchmark);
+    context->screen.performance_screen.storage_count = 0;
+    context->screen.performance_screen.storage_running = false;
+}
+
+static const struct screen_descriptor performance_screen_descriptor =
+{
+    .program_name = OTP_MGR_PROGRAM_NAME,
+    .screen_name = "Performance",
+    .commands = "R - Run Again, S - Storage Benchmark, Q - Quit",
+    .footer = OTP_MGR_FOOTER,
+    .handler = performance_screen_handler,
+    .renderer = render_performance_screen,
+    .enter = enter_performance_screen,
+    .background = performance_screen_background,
+};
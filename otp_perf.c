@@ -0,0 +1,90 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdbool.h>
+
+#include "hardware/structs/systick.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/sync.h"
+
+#include "otp_hmac.h"
+#include "otp_hot_path.h"
+#include "otp_perf.h"
+#include "otp_truncate.h"
+#include "security/hotp.h"
+
+#define SYSTICK_MASK 0x00FFFFFF
+
+typedef void (*hotp_function)(uint8_t *secret, uint8_t secret_length, uint64_t counter, char *otp);
+
+void otp_perf_get_xip(struct otp_perf_xip *xip)
+{
+    xip->hits = xip_ctrl_hw->ctr_hit;
+    xip->accesses = xip_ctrl_hw->ctr_acc;
+}
+
+static void OTP_HOT_PATH(_hmac_hotp)(uint8_t *secret, uint8_t secret_length, uint64_t counter, char *otp)
+{
+    uint8_t message[8];
+    for (int i = 7; i >= 0; i--)
+    {
+        message[i] = counter;
+        counter >>= 8;
+    }
+
+    uint8_t mac[OTP_HMAC_SHA1_LENGTH];
+    otp_hmac_sha1(secret, secret_length, message, sizeof(message), mac);
+    otp_format(otp_truncate(mac, sizeof(mac)), OTP_MAX_DIGITS, otp);
+}
+
+/*
+ * In SRAM so the measurement itself causes no XIP accesses, only the function
+ * being measured does.
+ */
+static void OTP_HOT_PATH(_measure)(hotp_function function, bool flush, struct otp_perf_run *run)
+{
+    static const uint8_t secret[] OTP_HOT_DATA = "12345678901234567890"; // RFC 4226 test secret.
+    char otp[OTP_MAX_DIGITS + 1];
+
+    if (flush)
+    {
+        xip_ctrl_hw->flush = 1;
+        // Reading FLUSH stalls until the flush is complete.
+        (void) xip_ctrl_hw->flush;
+    }
+
+    uint32_t hits = xip_ctrl_hw->ctr_hit;
+    uint32_t accesses = xip_ctrl_hw->ctr_acc;
+    uint32_t start = systick_hw->cvr;
+    function((uint8_t *)secret, 20, 0, otp);
+    // SysTick counts down.
+    run->cycles = (start - systick_hw->cvr) & SYSTICK_MASK;
+    run->xip.hits = xip_ctrl_hw->ctr_hit - hits;
+    run->xip.accesses = xip_ctrl_hw->ctr_acc - accesses;
+}
+
+void otp_perf_hotp_benchmark(struct otp_perf_hotp_benchmark *benchmark)
+{
+    uint32_t interrupts = save_and_disable_interrupts();
+
+    _measure(_hmac_hotp, true, &benchmark->hmac_cold);
+    _measure(_hmac_hotp, false, &benchmark->hmac_warm);
+    _measure(calculate_hotp, true, &benchmark->kernel_cold);
+    _measure(calculate_hotp, false, &benchmark->kernel_warm);
+
+    restore_interrupts(interrupts);
+}
@@ -0,0 +1,62 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Performance counters and the HOTP latency benchmark.
+ *
+ * The RP2040 XIP cache counts every access and every hit, the counters run
+ * from reset and saturate so deltas are taken rather than clearing them.
+ */
+
+#ifndef OTP_PERF_H
+#define OTP_PERF_H
+
+#include <stdint.h>
+
+struct otp_perf_xip
+{
+    uint32_t hits;
+    uint32_t accesses;
+};
+
+struct otp_perf_run
+{
+    uint32_t cycles;
+    struct otp_perf_xip xip; // The XIP activity during the run.
+};
+
+/*
+ * Each calculation is timed straight after the XIP cache is flushed and then
+ * again with the cache warm, the difference is the cost of the misses.
+ */
+struct otp_perf_hotp_benchmark
+{
+    struct otp_perf_run hmac_cold;   // The C HMAC path, placed in SRAM.
+    struct otp_perf_run hmac_warm;
+    struct otp_perf_run kernel_cold; // The assembly kernel, executing in place.
+    struct otp_perf_run kernel_warm;
+};
+
+void otp_perf_get_xip(struct otp_perf_xip *xip);
+
+/*
+ * Run the benchmark with interrupts disabled so nothing else touches the cache,
+ * otp_log_init must have been called to start SysTick.
+ */
+void otp_perf_hotp_benchmark(struct otp_perf_hotp_benchmark *benchmark);
+
+#endif // OTP_PERF_H
@@ -19,6 +19,7 @@
 #include <stdio.h>
 
 #include "hardware/gpio.h"
+#include "otp_log.h"
 #include "pico_ward.h"
 
 #define OTP_STATUS_CONTEXT_ID 0xB0
@@ -46,7 +47,7 @@ bool otp_status_begin(pico_ward_context_t *pico_ward_context)
     struct _otp_status_context *context = (struct _otp_status_context*) access_otp_status_context(pico_ward_context);
     if (context->common_context.id != OTP_STATUS_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_status_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_status_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
@@ -57,7 +58,7 @@ void otp_status_run(otp_status_context_t *status_context)
 {
     if (status_context->id != OTP_STATUS_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_status_run 0x%02x\n", status_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_status_run 0x%02x\n", status_context->id);
         return;
     }
 
@@ -18,21 +18,45 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+#include "boot_profile.h"
 #include "flash/flash.h"
+#include "flash_device.h"
+#include "flash_erase.h"
+#include "flash_power.h"
+#include "flash_scan.h"
+#include "otp_event.h"
 #include "hardware_map.h"
+#include "otp_log.h"
+#include "otp_storage.h"
 #include "pico_ward.h"
 #include "storage.h" // TODO Should merge here.
+#include "storage_internal.h"
+#include "storage_spi_nor.h"
 
 #define OTP_STORAGE_CONTEXT_ID 0xB1
+// The steps to mount, one is taken on each pass of the main loop.
+enum mount_step
+{
+    mount_reset,
+    mount_test,
+    mount_detect,
+    mount_storage,
+    mount_complete
+};
+
 struct _otp_storage_context
 {
     struct common_context common_context;
     flash_context_t flash_context;
-    bool flash_initialised;
+    uint8_t mount_step; // enum mount_step
+    uint8_t state; // enum otp_storage_state
+    bool external; // The external flash passed its post reset test.
+    const struct storage_backend *backend;
     storage_context_t storage_context;
 };
 
 static void _configure_flash_context(flash_context_t *flash_context);
+static void _mount_step(struct _otp_storage_context *context);
 
 otp_storage_context_t* otp_storage_init()
 {
@@ -40,17 +64,21 @@ otp_storage_context_t* otp_storage_init()
     context->common_context.id = OTP_STORAGE_CONTEXT_ID;
     context->storage_context.id = STORAGE_CONTEXT_ID;
 
+    // Only the pins and SPI are set up here, talking to the flash is deferred
+    // to the main loop so USB can enumerate first.
     _configure_flash_context(&context->flash_context);
     flash_spi_init(&context->flash_context);
-    flash_reset(&context->flash_context);
-
-    context->flash_initialised = flash_post_reset_test(&context->flash_context);
-
-    if (context->flash_initialised)
-    {
-        storage_begin(&context->storage_context, &context->flash_context);
-        printf("Storage Initialised = %d\n", &context->storage_context.initialised);
-    }
+    flash_power_init(&context->flash_context);
+    flash_erase_init(&context->flash_context);
+    context->storage_context.initialised = false;
+    context->external = false;
+    // Replaced by the internal flash if the external flash is missing.
+    context->backend = storage_spi_nor_init(&context->flash_context);
+    context->storage_context.backend = context->backend;
+    context->mount_step = mount_reset;
+    context->state = OTP_STORAGE_MOUNTING;
+
+    flash_scan_init();
 
     return (otp_storage_context_t*) context;
 }
@@ -60,15 +88,12 @@ bool otp_storage_begin(pico_ward_context_t *pico_ward_context)
     struct _otp_storage_context *context = (struct _otp_storage_context*) access_otp_storage_context(pico_ward_context);
     if (context->common_context.id != OTP_STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_storage_begin 0x%02x\n", context->common_context.id);
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_begin 0x%02x\n", context->common_context.id);
         return false;
     }
 
-    if (!context->flash_initialised)
-    {
-        printf("Flash not initialised\n");
-        return false;
-    }
+    // Ensure the main loop runs to take the first mount step.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
 
     return true;
 }
@@ -77,18 +102,52 @@ void otp_storage_run(otp_storage_context_t *storage_context)
 {
     if (storage_context->id != OTP_STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_storage_run 0x%02x\n", storage_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_run 0x%02x\n", storage_context->id);
         return;
     }
 
     struct _otp_storage_context *context = (struct _otp_storage_context*)storage_context;
+
+    if (context->state == OTP_STORAGE_MOUNTING)
+    {
+        _mount_step(context);
+        return;
+    }
+
+    storage_backend_run(context->backend);
+}
+
+enum otp_storage_state otp_storage_get_state(otp_storage_context_t *storage_context)
+{
+    if (storage_context->id != OTP_STORAGE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_get_state 0x%02x\n", storage_context->id);
+        return OTP_STORAGE_FAILED;
+    }
+
+    struct _otp_storage_context *context = (struct _otp_storage_context*)storage_context;
+
+    return context->state;
+}
+
+bool otp_storage_external_flash(otp_storage_context_t *storage_context)
+{
+    if (storage_context->id != OTP_STORAGE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_external_flash 0x%02x\n", storage_context->id);
+        return false;
+    }
+
+    struct _otp_storage_context *context = (struct _otp_storage_context*)storage_context;
+
+    return context->external;
 }
 
 flash_context_t* otp_storage_get_flash_context(otp_storage_context_t *storage_context)
 {
     if (storage_context->id != OTP_STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_storage_get_flash_context 0x%02x\n", storage_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_get_flash_context 0x%02x\n", storage_context->id);
         return NULL;
     }
 
@@ -102,7 +161,7 @@ storage_context_t* otp_storage_get_storage_context(otp_storage_context_t *storag
 {
     if (storage_context->id != OTP_STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to otp_storage_get_storage_context 0x%02x\n", storage_context->id);
+        OTP_LOG_ERROR("Invalid context passed to otp_storage_get_storage_context 0x%02x\n", storage_context->id);
         return NULL;
     }
 
@@ -111,6 +170,62 @@ storage_context_t* otp_storage_get_storage_context(otp_storage_context_t *storag
     return &context->storage_context;
 }
 
+static void _mount_step(struct _otp_storage_context *context)
+{
+    // Every step talks to the external flash until it is found to be missing,
+    // the first releases it from any deep power-down left from before a reset.
+    if (context->mount_step != mount_storage || context->external)
+    {
+        flash_power_wake();
+    }
+    switch (context->mount_step)
+    {
+        case mount_reset:
+            flash_reset(&context->flash_context);
+            context->mount_step = mount_test;
+            break;
+
+        case mount_test:
+            if (!flash_post_reset_test(&context->flash_context))
+            {
+                // Boards without the external flash keep their storage in the RP2040's own flash.
+                OTP_LOG_ERROR("Flash not initialised, using internal flash\n");
+                const struct storage_backend *internal = storage_internal_init();
+                if (internal == NULL)
+                {
+                    context->state = OTP_STORAGE_FAILED;
+                    return;
+                }
+                context->backend = internal;
+                boot_profile_mark(BOOT_PHASE_FLASH_READY);
+                context->mount_step = mount_storage;
+                break;
+            }
+            boot_profile_mark(BOOT_PHASE_FLASH_READY);
+            context->external = true;
+            context->mount_step = mount_detect;
+            break;
+
+        case mount_detect:
+            // Everything after this point uses the detected geometry.
+            flash_device_detect(&context->flash_context);
+            context->mount_step = mount_storage;
+            break;
+
+        case mount_storage:
+            storage_begin(&context->storage_context, context->backend);
+            OTP_LOG_INFO("Storage Initialised = %d, %s\n", context->storage_context.initialised,
+                context->backend->name);
+            boot_profile_mark(BOOT_PHASE_STORAGE_MOUNTED);
+            context->mount_step = mount_complete;
+            context->state = OTP_STORAGE_READY;
+            return;
+    }
+
+    // Come back for the next step.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+}
+
 static void _configure_flash_context(flash_context_t *flash_context)
 {
     flash_context->spi = FLASH_SPI_BANK;
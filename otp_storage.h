@@ -25,6 +25,13 @@
 #include "pico_ward.h"
 #include "storage.h" // TODO TEMP Remove
 
+enum otp_storage_state
+{
+    OTP_STORAGE_MOUNTING, // The flash is reset, tested and mounted from the main loop.
+    OTP_STORAGE_READY,
+    OTP_STORAGE_FAILED    // Neither the external flash nor the internal flash can be used.
+};
+
 /*
  * This function initialises the OTP storage component.
  * It should be called once at the start of the program.
@@ -47,6 +54,18 @@ bool otp_storage_begin(pico_ward_context_t *pico_ward_context);
  */
 void otp_storage_run(otp_storage_context_t *storage_context);
 
+/*
+ * The flash is brought up a step at a time by otp_storage_run after USB so
+ * nothing else should use it until it is ready.
+ */
+enum otp_storage_state otp_storage_get_state(otp_storage_context_t *storage_context);
+
+/*
+ * @returns true if storage is on the external flash, false if it is on the
+ * internal flash as the external flash did not pass its post reset test.
+ */
+bool otp_storage_external_flash(otp_storage_context_t *storage_context);
+
 // TODO TEMP REMOVE
 flash_context_t* otp_storage_get_flash_context(otp_storage_context_t *storage_context);
 storage_context_t* otp_storage_get_storage_context(otp_storage_context_t *storage_context);
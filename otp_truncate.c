@@ -0,0 +1,122 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "hardware/structs/systick.h"
+
+#include "otp_hmac.h"
+#include "otp_hot_path.h"
+#include "otp_truncate.h"
+#include "security/hotp.h"
+
+#define BENCHMARK_ITERATIONS 64
+#define SYSTICK_MASK 0x00FFFFFF
+
+// Indexed by digits - OTP_MIN_DIGITS.
+static const uint32_t powers[] = { 1000000, 10000000, 100000000 };
+// floor(2^shift / power) + 1, exact for all 31 bit values.
+static const uint32_t reciprocals[] OTP_HOT_DATA = { 2251799814, 3602879702, 2882303762 };
+static const uint8_t shifts[] OTP_HOT_DATA = { 51, 55, 58 };
+
+// Two characters for each value 0 - 99.
+#define _PAIRS(t) t "0" t "1" t "2" t "3" t "4" t "5" t "6" t "7" t "8" t "9"
+static const char pairs[] OTP_HOT_DATA =
+    _PAIRS("0") _PAIRS("1") _PAIRS("2") _PAIRS("3") _PAIRS("4")
+    _PAIRS("5") _PAIRS("6") _PAIRS("7") _PAIRS("8") _PAIRS("9");
+
+uint32_t OTP_HOT_PATH(otp_truncate)(const uint8_t *mac, uint8_t mac_length)
+{
+    const uint8_t *p = &mac[mac[mac_length - 1] & 0x0F];
+
+    return ((uint32_t)p[0] & 0x7F) << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline void _format_four(uint32_t value, char *otp)
+{
+    // value / 100 is exact for values below 43699.
+    uint32_t high = (value * 5243) >> 19;
+    uint32_t low = value - high * 100;
+    memcpy(otp, &pairs[high * 2], 2);
+    memcpy(otp + 2, &pairs[low * 2], 2);
+}
+
+void OTP_HOT_PATH(otp_format)(uint32_t value, uint8_t digits, char *otp)
+{
+    uint8_t index = digits - OTP_MIN_DIGITS;
+    uint32_t quotient = ((uint64_t)value * reciprocals[index]) >> shifts[index];
+    uint32_t remainder = value - quotient * powers[index];
+
+    // Always format 8 digits, the leading digits are zero for 6 and 7.
+    uint32_t high = ((uint64_t)remainder * 219902326) >> 41; // remainder / 10000
+    char all[OTP_MAX_DIGITS];
+    _format_four(high, all);
+    _format_four(remainder - high * 10000, &all[4]);
+
+    memcpy(otp, &all[OTP_MAX_DIGITS - digits], digits);
+    otp[digits] = 0x00;
+}
+
+static void _format_divide(uint32_t value, uint8_t digits, char *otp)
+{
+    uint32_t remainder = value % powers[digits - OTP_MIN_DIGITS];
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        otp[i] = 0x30 + remainder % 10;
+        remainder /= 10;
+    }
+    otp[digits] = 0x00;
+}
+
+static inline uint32_t _elapsed(uint32_t start)
+{
+    // SysTick counts down.
+    return (start - systick_hw->cvr) & SYSTICK_MASK;
+}
+
+void otp_truncate_benchmark(struct otp_truncate_benchmark *benchmark)
+{
+    static const uint8_t secret[] = "12345678901234567890"; // RFC 4226 test secret.
+    volatile uint32_t value = 1284755224; // Counter 0 truncated.
+    char otp[OTP_MAX_DIGITS + 1];
+
+    uint32_t start = systick_hw->cvr;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        _format_divide(value, OTP_MAX_DIGITS, otp);
+    }
+    benchmark->divide_cycles = _elapsed(start) / BENCHMARK_ITERATIONS;
+
+    start = systick_hw->cvr;
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        otp_format(value, OTP_MAX_DIGITS, otp);
+    }
+    benchmark->reciprocal_cycles = _elapsed(start) / BENCHMARK_ITERATIONS;
+
+    // A single calculation each, the 24 bit SysTick would wrap on a loop.
+    start = systick_hw->cvr;
+    calculate_hotp((uint8_t *)secret, 20, 0, otp);
+    benchmark->kernel_cycles = _elapsed(start);
+
+    start = systick_hw->cvr;
+    uint8_t counter[8] = { 0 };
+    uint8_t mac[OTP_HMAC_SHA1_LENGTH];
+    otp_hmac_sha1(secret, 20, counter, sizeof(counter), mac);
+    otp_format(otp_truncate(mac, sizeof(mac)), OTP_MAX_DIGITS, otp);
+    benchmark->hmac_cycles = _elapsed(start);
+}
@@ -0,0 +1,58 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Dynamic truncation of a HOTP MAC (RFC 4226 section 5.3) and conversion of
+ * the result to 6, 7 or 8 decimal digits.
+ *
+ * The Cortex-M0+ has no divide instruction so the conversion uses multiplication
+ * by a reciprocal and a table of digit pairs, without data dependent branches.
+ */
+
+#ifndef OTP_TRUNCATE_H
+#define OTP_TRUNCATE_H
+
+#include <stdint.h>
+
+#define OTP_MIN_DIGITS 6
+#define OTP_MAX_DIGITS 8
+
+struct otp_truncate_benchmark
+{
+    uint32_t divide_cycles;     // Conversion using division, as the original path.
+    uint32_t reciprocal_cycles; // Conversion using otp_format.
+    uint32_t kernel_cycles;     // The assembly HOTP kernel, always 6 digits.
+    uint32_t hmac_cycles;       // HMAC, truncation and conversion for 8 digits.
+};
+
+/*
+ * @returns The 31 bit value selected by the low nibble of the final byte of the MAC.
+ */
+uint32_t otp_truncate(const uint8_t *mac, uint8_t mac_length);
+
+/*
+ * Format the last digits of value as decimal, otp must hold digits + 1 characters.
+ */
+void otp_format(uint32_t value, uint8_t digits, char *otp);
+
+/*
+ * Time the conversion and calculation paths using SysTick, otp_log_init must
+ * have been called to start SysTick.
+ */
+void otp_truncate_benchmark(struct otp_truncate_benchmark *benchmark);
+
+#endif // OTP_TRUNCATE_H
@@ -0,0 +1,396 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "otpauth.h"
+
+enum otpauth_state
+{
+    STATE_SCHEME, // Matching "otpauth://"
+    STATE_TYPE,   // "totp/" or "hotp/"
+    STATE_LABEL,
+    STATE_KEY,
+    STATE_VALUE,
+    STATE_SKIP    // Discarding the rest of a rejected URI.
+};
+
+static const char scheme[] = "otpauth://";
+
+static inline char _fold(char c)
+{
+    return c >= 0x41 && c <= 0x5A ? c + 0x20 : c;
+}
+
+static bool _is_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/*
+ * @returns The value of the hex digit or -1 if it is not a hex digit.
+ */
+static int8_t _hex_value(char c)
+{
+    c = _fold(c);
+    if (c >= 0x30 && c <= 0x39)
+    {
+        return c - 0x30;
+    }
+    else if (c >= 0x61 && c <= 0x66)
+    {
+        return c - 0x61 + 10;
+    }
+
+    return -1;
+}
+
+static bool _equals(const char *str, const char *lower)
+{
+    for (; *lower != 0x00; str++, lower++)
+    {
+        if (_fold(*str) != *lower)
+        {
+            return false;
+        }
+    }
+
+    return *str == 0x00;
+}
+
+static bool _parse_number(const char *str, uint64_t *number)
+{
+    if (*str == 0x00)
+    {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (; *str != 0x00; str++)
+    {
+        if (*str < 0x30 || *str > 0x39)
+        {
+            return false;
+        }
+        result = result * 10 + (*str - 0x30);
+    }
+    *number = result;
+
+    return true;
+}
+
+static void _reset(struct otpauth_parser *parser)
+{
+    parser->state = STATE_SCHEME;
+    parser->matched = 0;
+    parser->key_length = 0;
+    parser->value_length = 0;
+    parser->in_escape = false;
+    parser->escape_length = 0;
+    parser->name_length = 0;
+    parser->issuer[0] = 0x00;
+    parser->secret_seen = false;
+    parser->error = NULL;
+    memset(&parser->credential, 0x00, sizeof(struct otp_credential));
+    parser->credential.period = PICO_OTP_DEFAULT_PERIOD;
+    parser->credential.digits = OTP_MIN_DIGITS;
+    base32_decoder_init(&parser->decoder, parser->credential.secret, PICO_OTP_MAX_SECRET);
+}
+
+void otpauth_parser_init(struct otpauth_parser *parser)
+{
+    _reset(parser);
+}
+
+static enum otpauth_result _reject(struct otpauth_parser *parser, const char *error)
+{
+    parser->error = error;
+    parser->state = STATE_SKIP;
+
+    return OTPAUTH_MORE;
+}
+
+/*
+ * Apply a completed query parameter.
+ */
+static enum otpauth_result _parameter(struct otpauth_parser *parser)
+{
+    parser->key[parser->key_length] = 0x00;
+    parser->value[parser->value_length] = 0x00;
+    char *key = parser->key;
+    char *value = parser->value;
+    uint64_t number;
+
+    if (_equals(key, "secret"))
+    {
+        // An empty repeat never reaches _decoded.
+        if (parser->secret_seen)
+        {
+            return _reject(parser, "Repeated secret");
+        }
+        parser->secret_seen = true;
+        if (parser->decoder.error)
+        {
+            return _reject(parser, "Invalid or too long secret");
+        }
+    }
+    else if (_equals(key, "issuer"))
+    {
+        strncpy(parser->issuer, value, PICO_OTP_NAME_LENGTH - 1);
+        parser->issuer[PICO_OTP_NAME_LENGTH - 1] = 0x00;
+    }
+    else if (_equals(key, "algorithm"))
+    {
+        // Only the SHA-1 kernel is available.
+        if (!_equals(value, "sha1"))
+        {
+            return _reject(parser, "Unsupported algorithm");
+        }
+    }
+    else if (_equals(key, "digits"))
+    {
+        if (!_parse_number(value, &number) || number < OTP_MIN_DIGITS || number > OTP_MAX_DIGITS)
+        {
+            return _reject(parser, "Unsupported digits");
+        }
+        parser->credential.digits = number;
+    }
+    else if (_equals(key, "period"))
+    {
+        if (!_parse_number(value, &number) || number == 0 || number > UINT32_MAX)
+        {
+            return _reject(parser, "Invalid period");
+        }
+        parser->credential.period = number;
+    }
+    else if (_equals(key, "counter"))
+    {
+        if (!_parse_number(value, &number))
+        {
+            return _reject(parser, "Invalid counter");
+        }
+        parser->credential.counter = number;
+    }
+    // Anything else, e.g. image, is ignored.
+
+    parser->key_length = 0;
+    parser->value_length = 0;
+
+    return OTPAUTH_MORE;
+}
+
+/*
+ * Complete the URI once all of it has been received.
+ */
+static enum otpauth_result _complete(struct otpauth_parser *parser)
+{
+    enum otpauth_result result = OTPAUTH_ERROR;
+    if (parser->state == STATE_VALUE || parser->state == STATE_KEY)
+    {
+        _parameter(parser);
+    }
+
+    struct otp_credential *credential = &parser->credential;
+    if (parser->state == STATE_SKIP)
+    {
+        // Already rejected with the error set.
+    }
+    else if (parser->state < STATE_LABEL)
+    {
+        parser->error = "Not an otpauth URI";
+    }
+    else if (!parser->secret_seen || parser->decoder.length == 0)
+    {
+        parser->error = "No secret";
+    }
+    else
+    {
+        credential->secret_length = parser->decoder.length;
+        // Labels are usually "Issuer:account", only add the issuer if it is missing.
+        if (parser->issuer[0] != 0x00 && strchr(credential->name, ':') == NULL)
+        {
+            char account[PICO_OTP_NAME_LENGTH];
+            strcpy(account, credential->name);
+            snprintf(credential->name, PICO_OTP_NAME_LENGTH, account[0] != 0x00 ? "%s:%s" : "%s",
+                parser->issuer, account);
+        }
+        else if (credential->name[0] == 0x00)
+        {
+            strcpy(credential->name, "Imported");
+        }
+        result = OTPAUTH_COMPLETE;
+    }
+
+    // Retain the results until the next character.
+    parser->state = STATE_SCHEME;
+    parser->matched = 0;
+
+    return result;
+}
+
+/*
+ * Handle a character of the label, key or value after any escape is decoded.
+ */
+static enum otpauth_result _decoded(struct otpauth_parser *parser, char character)
+{
+    switch (parser->state)
+    {
+    case STATE_LABEL:
+        if (parser->name_length < PICO_OTP_NAME_LENGTH - 1)
+        {
+            parser->credential.name[parser->name_length++] = character;
+        }
+        break;
+    case STATE_KEY:
+        if (parser->key_length < OTPAUTH_MAX_KEY)
+        {
+            parser->key[parser->key_length++] = character;
+        }
+        break;
+    case STATE_VALUE:
+        parser->key[parser->key_length] = 0x00;
+        if (_equals(parser->key, "secret"))
+        {
+            // A second secret would be appended to the first, rejected before it reaches the decoder.
+            if (parser->secret_seen)
+            {
+                return _reject(parser, "Repeated secret");
+            }
+            // Decoded as it arrives, any error is reported at the end of the parameter.
+            base32_decoder_put(&parser->decoder, character);
+        }
+        else if (parser->value_length < OTPAUTH_MAX_VALUE)
+        {
+            parser->value[parser->value_length++] = character;
+        }
+        break;
+    }
+
+    return OTPAUTH_MORE;
+}
+
+enum otpauth_result otpauth_parser_put(struct otpauth_parser *parser, char character)
+{
+    if (parser->state == STATE_SCHEME && parser->matched == 0)
+    {
+        if (_is_separator(character))
+        {
+            // Between URIs.
+            return OTPAUTH_MORE;
+        }
+        // A new URI, discard the previous result.
+        _reset(parser);
+    }
+
+    if (_is_separator(character))
+    {
+        return _complete(parser);
+    }
+
+    switch (parser->state)
+    {
+    case STATE_SCHEME:
+        if (_fold(character) != scheme[parser->matched])
+        {
+            return _reject(parser, "Not an otpauth URI");
+        }
+        if (scheme[++parser->matched] == 0x00)
+        {
+            parser->state = STATE_TYPE;
+            parser->matched = 0;
+        }
+        return OTPAUTH_MORE;
+    case STATE_TYPE:
+        if (character == '/')
+        {
+            parser->value[parser->value_length] = 0x00;
+            if (_equals(parser->value, "totp"))
+            {
+                parser->credential.type = OTP_CREDENTIAL_TOTP;
+            }
+            else if (_equals(parser->value, "hotp"))
+            {
+                parser->credential.type = OTP_CREDENTIAL_HOTP;
+            }
+            else
+            {
+                return _reject(parser, "Unsupported type");
+            }
+            parser->value_length = 0;
+            parser->state = STATE_LABEL;
+        }
+        else if (parser->value_length < OTPAUTH_MAX_VALUE)
+        {
+            parser->value[parser->value_length++] = character;
+        }
+        return OTPAUTH_MORE;
+    case STATE_SKIP:
+        return OTPAUTH_MORE;
+    }
+
+    // Label and query, delimiters are only recognised before escapes are decoded.
+    if (parser->in_escape)
+    {
+        parser->escape[parser->escape_length++] = character;
+        if (parser->escape_length < 2)
+        {
+            return OTPAUTH_MORE;
+        }
+        parser->in_escape = false;
+        int8_t high = _hex_value(parser->escape[0]);
+        int8_t low = _hex_value(parser->escape[1]);
+        if (high < 0 || low < 0)
+        {
+            return _reject(parser, "Invalid escape");
+        }
+        return _decoded(parser, high << 4 | low);
+    }
+    else if (character == '%')
+    {
+        parser->in_escape = true;
+        parser->escape_length = 0;
+        return OTPAUTH_MORE;
+    }
+    else if (character == '?' && parser->state == STATE_LABEL)
+    {
+        parser->state = STATE_KEY;
+        return OTPAUTH_MORE;
+    }
+    else if (character == '=' && parser->state == STATE_KEY)
+    {
+        parser->state = STATE_VALUE;
+        return OTPAUTH_MORE;
+    }
+    else if (character == '&' && (parser->state == STATE_KEY || parser->state == STATE_VALUE))
+    {
+        parser->state = STATE_KEY;
+        return _parameter(parser);
+    }
+
+    return _decoded(parser, character);
+}
+
+enum otpauth_result otpauth_parser_finish(struct otpauth_parser *parser)
+{
+    if (parser->state == STATE_SCHEME && parser->matched == 0)
+    {
+        return OTPAUTH_MORE;
+    }
+
+    return _complete(parser);
+}
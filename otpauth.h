@@ -0,0 +1,82 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * A streaming parser for otpauth:// URIs as used in provisioning QR codes.
+ *
+ *   otpauth://totp/Issuer:account?secret=BASE32&issuer=Issuer&algorithm=SHA1&digits=6&period=30
+ *
+ * Characters are passed in as they are received so a paste of any number of
+ * URIs, separated by whitespace, is parsed without buffering it. The secret is
+ * decoded as it arrives by a streaming Base32 decoder.
+ */
+
+#ifndef OTPAUTH_H
+#define OTPAUTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "base32.h"
+#include "pico_otp.h"
+
+#define OTPAUTH_MAX_KEY 10
+#define OTPAUTH_MAX_VALUE 24
+
+enum otpauth_result
+{
+    OTPAUTH_MORE,     // More characters are needed.
+    OTPAUTH_COMPLETE, // A URI was parsed into the credential.
+    OTPAUTH_ERROR     // A URI was rejected, error describes why.
+};
+
+struct otpauth_parser
+{
+    uint8_t state;
+    uint8_t matched; // Characters of the scheme and type matched.
+    char key[OTPAUTH_MAX_KEY + 1];
+    uint8_t key_length;
+    char value[OTPAUTH_MAX_VALUE + 1];
+    uint8_t value_length;
+    char escape[2]; // The hex digits of a %XX escape.
+    uint8_t escape_length; // 0 when not within an escape.
+    bool in_escape;
+    uint8_t name_length;
+    char issuer[PICO_OTP_NAME_LENGTH];
+    bool secret_seen;
+    struct base32_decoder decoder;
+    struct otp_credential credential; // The result once OTPAUTH_COMPLETE is returned.
+    const char *error; // The reason once OTPAUTH_ERROR is returned.
+};
+
+void otpauth_parser_init(struct otpauth_parser *parser);
+
+/*
+ * Parse the next character, whitespace ends a URI.
+ *
+ * After OTPAUTH_COMPLETE or OTPAUTH_ERROR the parser is ready for the next URI.
+ */
+enum otpauth_result otpauth_parser_put(struct otpauth_parser *parser, char character);
+
+/*
+ * End the input, completing any URI in progress.
+ *
+ * @returns OTPAUTH_MORE if no URI was in progress.
+ */
+enum otpauth_result otpauth_parser_finish(struct otpauth_parser *parser);
+
+#endif // OTPAUTH_H
@@ -16,10 +16,14 @@
 
 #include <stdio.h>
 
+#include "boot_profile.h"
+#include "clock_policy.h"
 #include "hardware_map.h"
 #include "otp_admin.h"
 #include "otp_display.h"
+#include "otp_event.h"
 #include "otp_input.h"
+#include "otp_log.h"
 #include "otp_main.h"
 #include "otp_mgr.h"
 #include "otp_status.h"
@@ -51,9 +55,12 @@ struct _otp_context
 int main()
 {
     board_init();
+    otp_log_init();
+    boot_profile_mark(BOOT_PHASE_BOARD_INIT);
 
     // init device stack on configured roothub port
     tud_init(BOARD_TUD_RHPORT);
+    boot_profile_mark(BOOT_PHASE_USB_INIT);
 
     printf("\n\n\nHello World, welcome to pico-ward !!!\n\n");
     struct _otp_context otp_context;
@@ -74,6 +81,7 @@ int main()
     otp_context.user_input_context = otp_input_init();
     // 6. Pico OTP (Main OTP Core)
     otp_context.otp_main_context = otp_main_init();
+    boot_profile_mark(BOOT_PHASE_COMPONENTS_INIT);
 
     // Phase 2 - Begin each component.
     //           At this stage the components may interact to complete their
@@ -101,6 +109,14 @@ int main()
         printf("Failed to initialise all components\n");
         return -1;
     }
+    boot_profile_mark(BOOT_PHASE_COMPONENTS_BEGIN);
+
+    // After the components so the flash SPI is configured before its divider is captured.
+    clock_policy_init();
+
+    // Storage is still mounting, it completes a step at a time from the loop
+    // so the first pass reaches tud_task as soon as possible.
+    boot_profile_mark(BOOT_PHASE_MAIN_LOOP);
 
     // Phase 3 - Begin the main loop.
     while (true)
@@ -117,6 +133,17 @@ int main()
         otp_input_run(otp_context.user_input_context);
         // 6. Pico OTP (Main OTP Core)
         otp_main_run(otp_context.otp_main_context);
+
+        // When idle drop the clock and drain some of the deferred log, then sleep
+        // until the next event unless a task is still in progress or log records remain.
+        if (otp_main_idle(otp_context.otp_main_context))
+        {
+            clock_policy_idle();
+            if (!otp_log_drain(OTP_LOG_DRAIN_BATCH))
+            {
+                otp_event_wait();
+            }
+        }
     }
 
     printf("Exiting main loop\n");
@@ -14,42 +14,389 @@
  * If  not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
 #include <string.h>
 
+#include "pico/rand.h"
+#include "pico/time.h"
+#include "pico/unique_id.h"
+
+#include "flash_power.h"
+#include "flash_scan.h"
+#include "flash_security.h"
+#include "otp_hmac.h"
+#include "otp_log.h"
 #include "pico_otp.h"
-#include "security/hotp.h"
+#include "storage_address_map.h"
+#include "storage_internal.h"
+#include "storage_ram.h"
+#include "storage_spi_nor.h"
+
+bool pico_otp_pin_set(otp_core_t *otp_core)
+{
+    return otp_core->pin_set;
+}
+
+const struct pin_verifier* pico_otp_get_pin_verifier(otp_core_t *otp_core)
+{
+    return &otp_core->pin_verifier;
+}
 
-bool pico_otp_validate_pin(otp_core_t *otp_core, char *pin)
+void pico_otp_set_pin_verifier(otp_core_t *otp_core, const struct pin_verifier *pin_verifier)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_validate_pin 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_set_pin_verifier 0x%02x\n", otp_core->id);
+        return;
+    }
+
+    memcpy(&otp_core->pin_verifier, pin_verifier, sizeof(struct pin_verifier));
+    otp_core->pin_set = true;
+}
+
+bool pico_otp_pin_matches(otp_core_t *otp_core, const uint8_t *hash)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_pin_matches 0x%02x\n", otp_core->id);
         return false;
     }
 
-    return strncmp(otp_core->pin, pin, 9) == 0;
+    // Every byte is compared whatever the result so the time taken reveals nothing.
+    volatile uint8_t difference = 0;
+    for (int i = 0; i < OTP_HMAC_SHA256_LENGTH; i++)
+    {
+        difference |= otp_core->pin_verifier.hash[i] ^ hash[i];
+    }
+
+    return otp_core->pin_set && difference == 0;
 }
 
-void pico_otp_set_pin(otp_core_t *otp_core, char *pin)
+// The root record lives in the first security register.
+#define PICO_OTP_ROOT_REGISTER 1
+#define PICO_OTP_ROOT_VERSION 0x01
+static const uint8_t root_magic[4] = { 'P', 'W', 'R', 'T' };
+
+/*
+ * The material needed to unlock, kept in a security register so it can be read
+ * with one command at mount. The board ID binds the flash to this RP2040.
+ */
+struct root_record
+{
+    uint8_t magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+    uint8_t board_id[PICO_UNIQUE_BOARD_ID_SIZE_BYTES];
+    struct pin_verifier pin_verifier;
+    struct wrapped_key wrapped_data_key;
+    uint32_t crc; // Of everything before it, detects an interrupted write.
+};
+
+// The record waiting for the internal flash, which can only track one erase at a time.
+static struct
+{
+    bool pending; // Waiting for a reset of the storage to complete first.
+    struct root_record record;
+} internal_root;
+
+static void _random_bytes(uint8_t *bytes, uint8_t length)
+{
+    while (length > 0)
+    {
+        rng_128_t random;
+        get_rand_128(&random);
+        uint8_t chunk = length < sizeof(random) ? length : sizeof(random);
+        memcpy(bytes, &random, chunk);
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+bool pico_otp_wrap_data_key(otp_core_t *otp_core, const uint8_t *key)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_set_pin 0x%02x\n", otp_core->id);
-        return;
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_wrap_data_key 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    uint8_t data_key[OTP_CRYPT_KEY_LENGTH];
+    if (otp_core->session_active)
+    {
+        memcpy(data_key, otp_core->data_key, OTP_CRYPT_KEY_LENGTH);
+    }
+    else if (!otp_core->data_key_wrapped)
+    {
+        OTP_LOG_INFO("Generating data key.\n");
+        _random_bytes(data_key, OTP_CRYPT_KEY_LENGTH);
+    }
+    else
+    {
+        // Re-wrapping needs the current PIN to have been validated.
+        return false;
+    }
+
+    struct wrapped_key *wrapped = &otp_core->wrapped_data_key;
+    _random_bytes(wrapped->nonce, OTP_CRYPT_NONCE_LENGTH);
+    otp_crypt_seal(key, wrapped->nonce, NULL, 0, data_key, OTP_CRYPT_KEY_LENGTH, wrapped->key, wrapped->tag);
+    otp_core->data_key_wrapped = true;
+    memset(data_key, 0x00, OTP_CRYPT_KEY_LENGTH);
+
+    return true;
+}
+
+bool pico_otp_begin_session(otp_core_t *otp_core, const uint8_t *key)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_begin_session 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    struct wrapped_key *wrapped = &otp_core->wrapped_data_key;
+    otp_core->session_active = otp_core->data_key_wrapped &&
+        otp_crypt_open(key, wrapped->nonce, NULL, 0, wrapped->key, OTP_CRYPT_KEY_LENGTH, wrapped->tag,
+            otp_core->data_key);
+
+    return otp_core->session_active;
+}
+
+void pico_otp_end_session(otp_core_t *otp_core)
+{
+    memset(otp_core->data_key, 0x00, OTP_CRYPT_KEY_LENGTH);
+    otp_core->session_active = false;
+}
+
+bool pico_otp_session_active(otp_core_t *otp_core)
+{
+    return otp_core->session_active;
+}
+
+static uint32_t _crc32(const uint8_t *data, uint32_t length)
+{
+    // Only run at mount and when the PIN changes, no table needed.
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static uint32_t _internal_root_address(otp_core_t *otp_core)
+{
+    // The root record is the first of the reserved region.
+    return storage_backend_usable_size(otp_core->storage_context->backend);
+}
+
+static bool _read_root(otp_core_t *otp_core, struct root_record *record)
+{
+    if (otp_core->flash_ready)
+    {
+        storage_spi_nor_read_access();
+        return flash_security_read(otp_core->flash_context, PICO_OTP_ROOT_REGISTER, 0, record,
+            sizeof(struct root_record));
+    }
+
+    return otp_core->storage_context->backend->read(_internal_root_address(otp_core), record,
+        sizeof(struct root_record));
+}
+
+enum pico_otp_root_status pico_otp_mount_root(otp_core_t *otp_core)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_mount_root 0x%02x\n", otp_core->id);
+        return PICO_OTP_ROOT_DAMAGED;
+    }
+
+    if (!otp_core->flash_ready && !otp_core->root_internal)
+    {
+        return PICO_OTP_ROOT_ABSENT;
+    }
+
+    struct root_record record;
+    memset(&record, 0x00, sizeof(record));
+    pico_unique_board_id_t board_id;
+    pico_get_unique_board_id(&board_id);
+
+    if (!_read_root(otp_core, &record))
+    {
+        OTP_LOG_ERROR("Unable to read the root record.\n");
+        return PICO_OTP_ROOT_DAMAGED;
+    }
+
+    // Only an erased or never written record is absent, anything else may be
+    // the only copy of the wrapped data key so must not be replaced.
+    if (memcmp(record.magic, root_magic, sizeof(root_magic)) != 0)
+    {
+        OTP_LOG_INFO("No root record stored.\n");
+        return PICO_OTP_ROOT_ABSENT;
+    }
+    if (record.version != PICO_OTP_ROOT_VERSION)
+    {
+        OTP_LOG_ERROR("Root record version %d not supported.\n", record.version);
+        return PICO_OTP_ROOT_DAMAGED;
+    }
+    if (record.crc != _crc32((const uint8_t*) &record, offsetof(struct root_record, crc)))
+    {
+        OTP_LOG_ERROR("Root record CRC mismatch.\n");
+        return PICO_OTP_ROOT_DAMAGED;
+    }
+    if (memcmp(record.board_id, board_id.id, PICO_UNIQUE_BOARD_ID_SIZE_BYTES) != 0)
+    {
+        OTP_LOG_ERROR("Root record belongs to another device.\n");
+        return PICO_OTP_ROOT_DAMAGED;
+    }
+
+    memcpy(&otp_core->pin_verifier, &record.pin_verifier, sizeof(struct pin_verifier));
+    otp_core->pin_set = true;
+    memcpy(&otp_core->wrapped_data_key, &record.wrapped_data_key, sizeof(struct wrapped_key));
+    otp_core->data_key_wrapped = true;
+    otp_core->root_stored = true;
+    memset(&record, 0x00, sizeof(record));
+    OTP_LOG_INFO("Root record mounted.\n");
+
+    return PICO_OTP_ROOT_MOUNTED;
+}
+
+static void _root_written(bool written, void *handback)
+{
+    otp_core_t *otp_core = (otp_core_t*)handback;
+    otp_core->root_stored = otp_core->root_stored || written;
+    OTP_LOG_INFO("Root record stored=%d\n", written);
+}
+
+static void _internal_root_erased(void *handback)
+{
+    otp_core_t *otp_core = handback;
+    bool written = otp_core->storage_context->backend->program(_internal_root_address(otp_core),
+        &internal_root.record, sizeof(struct root_record));
+    memset(&internal_root.record, 0x00, sizeof(struct root_record));
+    _root_written(written, otp_core);
+}
+
+static bool _internal_root_write(otp_core_t *otp_core)
+{
+    const struct storage_backend *backend = otp_core->storage_context->backend;
+    // Starting an erase would replace a reset in progress, _storage_erased calls again.
+    if (backend->busy())
+    {
+        internal_root.pending = true;
+        return true;
+    }
+
+    internal_root.pending = false;
+    return storage_backend_erase(backend, _internal_root_address(otp_core), ROOT_RECORD_LENGTH,
+        _internal_root_erased, otp_core);
+}
+
+bool pico_otp_store_root(otp_core_t *otp_core)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_store_root 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    if (!otp_core->flash_ready && !otp_core->root_internal)
+    {
+        return false;
+    }
+
+    struct root_record record;
+    memset(&record, 0x00, sizeof(record));
+    memcpy(record.magic, root_magic, sizeof(root_magic));
+    record.version = PICO_OTP_ROOT_VERSION;
+    pico_unique_board_id_t board_id;
+    pico_get_unique_board_id(&board_id);
+    memcpy(record.board_id, board_id.id, PICO_UNIQUE_BOARD_ID_SIZE_BYTES);
+    memcpy(&record.pin_verifier, &otp_core->pin_verifier, sizeof(struct pin_verifier));
+    memcpy(&record.wrapped_data_key, &otp_core->wrapped_data_key, sizeof(struct wrapped_key));
+    record.crc = _crc32((const uint8_t*) &record, offsetof(struct root_record, crc));
+
+    bool started;
+    if (otp_core->flash_ready)
+    {
+        storage_spi_nor_write_access();
+        started = flash_security_write_start(otp_core->flash_context, PICO_OTP_ROOT_REGISTER, &record,
+            sizeof(record), _root_written, otp_core);
+    }
+    else
+    {
+        memcpy(&internal_root.record, &record, sizeof(record));
+        started = _internal_root_write(otp_core);
+    }
+    memset(&record, 0x00, sizeof(record));
+    OTP_LOG_INFO("Root record write started=%d\n", started);
+
+    return started;
+}
+
+bool pico_otp_root_stored(otp_core_t *otp_core)
+{
+    return otp_core->root_stored;
+}
+
+bool pico_otp_root_locked(otp_core_t *otp_core)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_root_locked 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    if (!otp_core->flash_ready)
+    {
+        return false;
+    }
+
+    // The lock bit can only be set by pico_otp_lock_root so only needs reading once.
+    if (otp_core->root_lock_cached)
+    {
+        flash_power_cached();
+        return otp_core->root_locked;
+    }
+
+    storage_spi_nor_read_access();
+    otp_core->root_locked = flash_security_locked(otp_core->flash_context, PICO_OTP_ROOT_REGISTER);
+    otp_core->root_lock_cached = true;
+
+    return otp_core->root_locked;
+}
+
+bool pico_otp_lock_root(otp_core_t *otp_core)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_lock_root 0x%02x\n", otp_core->id);
+        return false;
     }
-    // Clear Existing Pin
-    for (uint32_t i = 0; i < 9; i++)
+
+    // Locking an empty register would leave the device unable to ever store its PIN,
+    // the internal flash has no lock bits.
+    if (!otp_core->flash_ready || !otp_core->root_stored)
     {
-        otp_core->pin[i] = 0x00;
+        return false;
     }
-    strncpy(otp_core->pin, pin, 9);
+
+    storage_spi_nor_write_access();
+    bool locked = flash_security_lock(otp_core->flash_context, PICO_OTP_ROOT_REGISTER);
+    otp_core->root_lock_cached = false;
+
+    return locked;
 }
 
 void pico_otp_set_hotp_secret(otp_core_t *otp_core, uint8_t *hotp_secret, uint8_t hotp_secret_length)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_set_hotp_secret 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_set_hotp_secret 0x%02x\n", otp_core->id);
         return;
     }
     // Clear Existing Secret - TODO should more clean up elsewhere.
@@ -60,13 +407,15 @@ void pico_otp_set_hotp_secret(otp_core_t *otp_core, uint8_t *hotp_secret, uint8_
     memcpy(otp_core->hotp_secret, hotp_secret, hotp_secret_length);
     otp_core->hotp_secret_length = hotp_secret_length;
     otp_core->hotp_counter = 0; // Reset Counter
+    // The cached code was for the previous secret.
+    otp_core->hotp_next_valid = false;
 }
 
 bool pico_otp_configured(otp_core_t *otp_core)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_configured 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_configured 0x%02x\n", otp_core->id);
         return false;
     }
     return otp_core->hotp_secret_length > 0;
@@ -76,65 +425,312 @@ void pico_otp_calculate(otp_core_t *otp_core, char *otp)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_calculate 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_calculate 0x%02x\n", otp_core->id);
         return;
     }
-    calculate_hotp(otp_core->hotp_secret, otp_core->hotp_secret_length, otp_core->hotp_counter, otp);
+    pico_otp_precompute(otp_core);
+    memcpy(otp, otp_core->hotp_next, 7);
 
-    // Convert to printable characters.
-    for (int i=0; i<6; i++)
+    // The cache is for the counter so moves on with it.
+    otp_core->hotp_counter++;
+    otp_core->hotp_next_valid = false;
+}
+
+bool pico_otp_precompute(otp_core_t *otp_core)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        otp[i] += 0x30;
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_precompute 0x%02x\n", otp_core->id);
+        return false;
     }
-    otp[6] = 0x00;
 
-    otp_core->hotp_counter++;
+    if (otp_core->hotp_next_valid || otp_core->hotp_secret_length == 0)
+    {
+        return false;
+    }
+
+    uint8_t counter[8];
+    for (int i = 0; i < 8; i++)
+    {
+        counter[i] = otp_core->hotp_counter >> (56 - i * 8);
+    }
+
+    // The SRAM HMAC rather than the assembly kernel which executes from flash.
+    uint8_t mac[OTP_HMAC_SHA1_LENGTH];
+    otp_hmac_sha1(otp_core->hotp_secret, otp_core->hotp_secret_length, counter, sizeof(counter), mac);
+    otp_format(otp_truncate(mac, sizeof(mac)), OTP_MIN_DIGITS, otp_core->hotp_next);
+    memset(mac, 0x00, sizeof(mac));
+    otp_core->hotp_next_valid = true;
+
+    return true;
+}
+
+int pico_otp_add_credential(otp_core_t *otp_core, const char *name, enum otp_credential_type type,
+    const uint8_t *secret, uint8_t secret_length, uint8_t digits, uint32_t period)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_add_credential 0x%02x\n", otp_core->id);
+        return -1;
+    }
+
+    if (otp_core->credential_count >= PICO_OTP_MAX_CREDENTIALS || secret_length > PICO_OTP_MAX_SECRET ||
+        digits < OTP_MIN_DIGITS || digits > OTP_MAX_DIGITS)
+    {
+        return -1;
+    }
+
+    int index = otp_core->credential_count;
+    struct otp_credential *credential = &otp_core->credentials[index];
+    memset(credential, 0x00, sizeof(struct otp_credential));
+    strncpy(credential->name, name, PICO_OTP_NAME_LENGTH - 1);
+    credential->type = type;
+    memcpy(credential->secret, secret, secret_length);
+    credential->secret_length = secret_length;
+    credential->digits = digits;
+    credential->period = period > 0 ? period : PICO_OTP_DEFAULT_PERIOD;
+    otp_core->credential_count++;
+    credential_index_add(otp_core->credential_index, index, credential->name);
+
+    return index;
+}
+
+bool pico_otp_add_credentials(otp_core_t *otp_core, const struct otp_credential *credentials, uint8_t count)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_add_credentials 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    if (otp_core->credential_count + count > PICO_OTP_MAX_CREDENTIALS)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t index = otp_core->credential_count++;
+        memcpy(&otp_core->credentials[index], &credentials[i], sizeof(struct otp_credential));
+        credential_index_add(otp_core->credential_index, index, otp_core->credentials[index].name);
+    }
+    OTP_LOG_INFO("Added %d credentials\n", count);
+
+    return true;
+}
+
+uint8_t pico_otp_credential_count(otp_core_t *otp_core)
+{
+    return otp_core->credential_count;
+}
+
+const struct otp_credential* pico_otp_get_credential(otp_core_t *otp_core, uint8_t index)
+{
+    return index < otp_core->credential_count ? &otp_core->credentials[index] : NULL;
+}
+
+uint16_t pico_otp_find_credentials(otp_core_t *otp_core, const char *query, uint8_t *results, uint16_t max_results)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_find_credentials 0x%02x\n", otp_core->id);
+        return 0;
+    }
+
+    return credential_index_search(otp_core->credential_index, query, results, max_results);
+}
+
+void pico_otp_set_time(otp_core_t *otp_core, uint64_t unix_time)
+{
+    otp_core->time_offset_us = (int64_t)(unix_time * 1000000) - (int64_t)time_us_64();
+    otp_core->time_set = true;
+}
+
+bool pico_otp_time_set(otp_core_t *otp_core)
+{
+    return otp_core->time_set;
+}
+
+uint64_t pico_otp_time_us(otp_core_t *otp_core)
+{
+    return time_us_64() + otp_core->time_offset_us;
+}
+
+void pico_otp_calculate_totp(otp_core_t *otp_core, uint8_t index, uint64_t step, char *otp)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_calculate_totp 0x%02x\n", otp_core->id);
+        return;
+    }
+
+    // TOTP is HOTP with the time step as the counter, RFC 6238.
+    struct otp_credential *credential = &otp_core->credentials[index];
+    uint8_t counter[8];
+    for (int i = 0; i < 8; i++)
+    {
+        counter[i] = step >> (56 - i * 8);
+    }
+
+    // The assembly kernel only returns 6 digits, the full MAC is needed for 7 or 8.
+    uint8_t mac[OTP_HMAC_SHA1_LENGTH];
+    otp_hmac_sha1(credential->secret, credential->secret_length, counter, sizeof(counter), mac);
+    otp_format(otp_truncate(mac, sizeof(mac)), credential->digits, otp);
+    memset(mac, 0x00, sizeof(mac));
+}
+
+bool pico_otp_flash_ready(otp_core_t *otp_core)
+{
+    return otp_core->flash_ready;
 }
 
 void pico_otp_flash_device_info(otp_core_t *otp_core, flash_device_info_t *device_info)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_flash_device_info 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_flash_device_info 0x%02x\n", otp_core->id);
         return;
     }
 
+    if (!otp_core->flash_ready)
+    {
+        memset(device_info, 0x00, sizeof(flash_device_info_t));
+        return;
+    }
+
+    storage_spi_nor_read_access();
     flash_load_device_info(otp_core->flash_context, device_info);
 }
 
+uint32_t pico_otp_flash_size(otp_core_t *otp_core)
+{
+    // Detected as storage mounted, the flash is not touched.
+    flash_power_cached();
+    struct storage_geometry geometry;
+    otp_core->storage_context->backend->geometry(&geometry);
+
+    return geometry.size;
+}
+
+const char* pico_otp_storage_backend(otp_core_t *otp_core)
+{
+    return otp_core->storage_context->backend->name;
+}
+
+uint8_t pico_otp_storage_benchmark_start(otp_core_t *otp_core, struct storage_benchmark *benchmarks, uint8_t max)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_storage_benchmark_start 0x%02x\n", otp_core->id);
+        return 0;
+    }
+
+    const struct storage_backend *backends[3];
+    uint8_t count = 0;
+    if (otp_core->flash_ready)
+    {
+        backends[count++] = otp_core->storage_context->backend;
+    }
+    backends[count++] = storage_internal_init();
+    backends[count++] = storage_ram_init();
+
+    uint8_t benchmarked = 0;
+    for (int i = 0; i < count && benchmarked < max; i++)
+    {
+        if (backends[i] != NULL)
+        {
+            storage_benchmark_init(backends[i], &benchmarks[benchmarked++]);
+        }
+    }
+
+    return benchmarked;
+}
+
+bool pico_otp_storage_benchmark_run(otp_core_t *otp_core, struct storage_benchmark *benchmarks, uint8_t count)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_storage_benchmark_run 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    // One backend at a time so the timings do not overlap.
+    for (int i = 0; i < count; i++)
+    {
+        if (benchmarks[i].state != STORAGE_BENCHMARK_COMPLETE)
+        {
+            return !storage_benchmark_run(&benchmarks[i]) || i + 1 < count;
+        }
+    }
+
+    return false;
+}
+
 bool pico_otp_storage_initialised(otp_core_t *otp_core)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_storage_initialised 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_storage_initialised 0x%02x\n", otp_core->id);
         return false;
     }
 
     return storage_initialised(otp_core->storage_context);
 }
 
+static void _storage_erased(void *handback)
+{
+    otp_core_t *otp_core = handback;
+    // Run storage_begin again as this will test if storage is correctly
+    // initialised.
+    storage_begin(otp_core->storage_context, otp_core->storage_context->backend);
+
+    if (internal_root.pending)
+    {
+        _internal_root_write(otp_core);
+    }
+}
+
 void pico_otp_reset_storage(otp_core_t *otp_core, bool initialise)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_reset_storage 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_reset_storage 0x%02x\n", otp_core->id);
         return;
     }
-    printf("Resetting Storage initialise=%d\n", initialise);
-    flash_chip_erase(otp_core->flash_context);
-
-    // Run storage_begin again as this will test if storage is correctly
-    // initialised.
-    //storage_begin(otp_core->storage_context, otp_core->flash_context);
+    OTP_LOG_INFO("Resetting Storage initialise=%d\n", initialise);
+    // Block by block in the background rather than a chip erase, which can not
+    // be suspended and would block the main loop for tens of seconds.
+    uint32_t length = otp_core->root_internal ? _internal_root_address(otp_core) : pico_otp_flash_size(otp_core);
+    storage_backend_erase(otp_core->storage_context->backend, 0, length, _storage_erased, otp_core);
 }
 
 void pico_otp_flash_read_data(otp_core_t *otp_core, uint32_t address, uint8_t *data, uint32_t length)
 {
     if (otp_core->id != OTP_CORE_CONTEXT_ID)
     {
-        printf("Invalid context passed to pico_otp_flash_read_data 0x%02x\n", otp_core->id);
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_flash_read_data 0x%02x\n", otp_core->id);
         return;
     }
-    printf("Reading from address 0x%08x\n", address);
-    flash_read_data(otp_core->flash_context, address, data, length);
+    OTP_LOG_DEBUG("Reading from address 0x%08x\n", address);
+    if (!otp_core->storage_context->backend->read(address, data, length))
+    {
+        // Beyond the end of the backend reads as erased.
+        memset(data, 0xFF, length);
+    }
+}
+
+bool pico_otp_flash_scan_start(otp_core_t *otp_core, const uint8_t *pattern, uint8_t pattern_length)
+{
+    if (otp_core->id != OTP_CORE_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to pico_otp_flash_scan_start 0x%02x\n", otp_core->id);
+        return false;
+    }
+
+    if (!otp_core->flash_ready)
+    {
+        return false;
+    }
+
+    return flash_scan_start(otp_core->flash_context, pico_otp_flash_size(otp_core), pattern, pattern_length);
 }
\ No newline at end of file
@@ -20,18 +20,88 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "credential_index.h"
+#include "otp_crypt.h"
+#include "otp_hmac.h"
+#include "otp_truncate.h"
 #include "storage.h"
 #include "flash/flash.h"
 
 #define OTP_CORE_CONTEXT_ID 0xB2
+#define PICO_OTP_MAX_CREDENTIALS 64
+#define PICO_OTP_NAME_LENGTH 32 // Including the null terminator.
+#define PICO_OTP_MAX_SECRET 20
+#define PICO_OTP_DEFAULT_PERIOD 30
+#define PICO_OTP_PIN_SALT_LENGTH 16
+
+enum otp_credential_type
+{
+    OTP_CREDENTIAL_HOTP,
+    OTP_CREDENTIAL_TOTP
+};
+
+struct otp_credential
+{
+    char name[PICO_OTP_NAME_LENGTH];
+    uint8_t type; // enum otp_credential_type
+    uint8_t secret[PICO_OTP_MAX_SECRET];
+    uint8_t secret_length;
+    uint8_t digits;   // OTP_MIN_DIGITS to OTP_MAX_DIGITS.
+    uint32_t period;  // TOTP time step in seconds.
+    uint64_t counter; // HOTP moving factor.
+};
+
+/*
+ * The PIN is never held, only a salted PBKDF2-HMAC-SHA256 of it.
+ */
+struct pin_verifier
+{
+    uint8_t salt[PICO_OTP_PIN_SALT_LENGTH];
+    uint32_t iterations;
+    uint8_t hash[OTP_HMAC_SHA256_LENGTH];
+};
+
+/*
+ * The data key encrypted under the key derived from the PIN, changing the PIN
+ * only re-wraps the data key so existing records remain readable.
+ */
+struct wrapped_key
+{
+    uint8_t nonce[OTP_CRYPT_NONCE_LENGTH];
+    uint8_t key[OTP_CRYPT_KEY_LENGTH];
+    uint8_t tag[OTP_CRYPT_TAG_LENGTH];
+};
+
 struct otp_core
 {
     char id;
-    char pin[9]; // 8 characters plus null terminator.
+    struct pin_verifier pin_verifier;
+    bool pin_set; // False until the initial verifier has been derived.
+    struct wrapped_key wrapped_data_key;
+    bool data_key_wrapped;
+    // The unwrapped data key, only held from a successful PIN validation until logout.
+    uint8_t data_key[OTP_CRYPT_KEY_LENGTH];
+    bool session_active;
+    bool root_stored; // The verifier and wrapped key are in the security register.
+    bool flash_ready; // The external flash passed its post reset test, set once storage has mounted.
+    bool root_internal; // Storage is on the internal flash so the root record is too.
+    // Held in RAM so checking them does not wake the flash.
+    bool root_lock_cached;
+    bool root_locked;
     // OTP Data
     uint8_t hotp_secret[20];
     uint8_t hotp_secret_length;
     uint64_t hotp_counter;
+    // The code for hotp_counter calculated ahead of the request.
+    bool hotp_next_valid;
+    char hotp_next[OTP_MAX_DIGITS + 1];
+    // Credentials
+    struct otp_credential credentials[PICO_OTP_MAX_CREDENTIALS];
+    uint8_t credential_count;
+    credential_index_t *credential_index;
+    // Time, the device has no RTC so the Unix time is set from the terminal.
+    bool time_set;
+    int64_t time_offset_us; // Unix time in microseconds less the time since boot.
     flash_context_t *flash_context;  // Maybe later we will make the storage more abstract.
     storage_context_t *storage_context; // This should become the primary mechanism to interact with storage.
 };
@@ -40,36 +110,201 @@ typedef struct otp_core otp_core_t;
 
 
 
-bool pico_otp_validate_pin(otp_core_t *otp_core, char *pin);
+bool pico_otp_pin_set(otp_core_t *otp_core);
 
-void pico_otp_set_pin(otp_core_t *otp_core, char *pin);
+const struct pin_verifier* pico_otp_get_pin_verifier(otp_core_t *otp_core);
+
+void pico_otp_set_pin_verifier(otp_core_t *otp_core, const struct pin_verifier *pin_verifier);
+
+/*
+ * Compare a derived hash with the verifier in constant time.
+ */
+bool pico_otp_pin_matches(otp_core_t *otp_core, const uint8_t *hash);
+
+/*
+ * Wrap the data key under the key derived from a new PIN, an active session is
+ * needed unless this is the first PIN in which case a new data key is generated.
+ *
+ * @returns false if there is no data key available to wrap.
+ */
+bool pico_otp_wrap_data_key(otp_core_t *otp_core, const uint8_t *key);
+
+/*
+ * Unwrap the data key and hold it until pico_otp_end_session.
+ *
+ * @returns false if the wrapped key fails authentication.
+ */
+bool pico_otp_begin_session(otp_core_t *otp_core, const uint8_t *key);
+
+void pico_otp_end_session(otp_core_t *otp_core);
+
+bool pico_otp_session_active(otp_core_t *otp_core);
+
+enum pico_otp_root_status
+{
+    PICO_OTP_ROOT_MOUNTED,
+    PICO_OTP_ROOT_ABSENT,  // Nothing has been stored, or there is no storage.
+    PICO_OTP_ROOT_DAMAGED  // Unreadable, corrupt or from another device, must be left alone.
+};
+
+/*
+ * Load the PIN verifier and wrapped data key from the root record in the flash
+ * security register, a single read command. Without the external flash the
+ * record is in a reserved sector of the internal flash instead.
+ */
+enum pico_otp_root_status pico_otp_mount_root(otp_core_t *otp_core);
+
+/*
+ * Write the current PIN verifier and wrapped data key to the root record.
+ *
+ * The erase and program run in the background, pico_otp_root_stored is true
+ * once the write completes.
+ *
+ * @returns false if the register is locked or there is no storage.
+ */
+bool pico_otp_store_root(otp_core_t *otp_core);
+
+bool pico_otp_root_stored(otp_core_t *otp_core);
+
+bool pico_otp_root_locked(otp_core_t *otp_core);
+
+/*
+ * Permanently lock the root record, from then on the PIN can not be changed.
+ *
+ * @returns false if no record has been stored or the lock failed.
+ */
+bool pico_otp_lock_root(otp_core_t *otp_core);
 
 void pico_otp_set_hotp_secret(otp_core_t *otp_core, uint8_t *hotp_secret, uint8_t hotp_secret_length);
 
 bool pico_otp_configured(otp_core_t *otp_core);
 
+/*
+ * Publish the next HOTP code and advance the counter.
+ *
+ * If the code was already calculated by pico_otp_precompute it is returned
+ * without calculation.
+ */
 void pico_otp_calculate(otp_core_t *otp_core, char *otp);
 
+/*
+ * Calculate the next HOTP code ahead of it being requested, called when the
+ * main loop is otherwise idle.
+ *
+ * @returns true if a code was calculated, false if the cache was already current.
+ */
+bool pico_otp_precompute(otp_core_t *otp_core);
+
+/*
+ * Add a credential to the end of the credential table.
+ *
+ * @returns The index of the new credential or -1 if the table is full, the secret too long
+ *          or the digits unsupported.
+ */
+int pico_otp_add_credential(otp_core_t *otp_core, const char *name, enum otp_credential_type type,
+    const uint8_t *secret, uint8_t secret_length, uint8_t digits, uint32_t period);
+
+/*
+ * Add a batch of credentials, either all are added or none are.
+ *
+ * @returns false if there is not room for all of the credentials.
+ */
+bool pico_otp_add_credentials(otp_core_t *otp_core, const struct otp_credential *credentials, uint8_t count);
+
+uint8_t pico_otp_credential_count(otp_core_t *otp_core);
+
+const struct otp_credential* pico_otp_get_credential(otp_core_t *otp_core, uint8_t index);
+
+/*
+ * Find the credentials with names containing the query, see credential_index_search.
+ */
+uint16_t pico_otp_find_credentials(otp_core_t *otp_core, const char *query, uint8_t *results, uint16_t max_results);
+
+/*
+ * Set the current Unix time in seconds.
+ */
+void pico_otp_set_time(otp_core_t *otp_core, uint64_t unix_time);
+
+bool pico_otp_time_set(otp_core_t *otp_core);
+
+/*
+ * @returns The current Unix time in microseconds, only meaningful once the time has been set.
+ */
+uint64_t pico_otp_time_us(otp_core_t *otp_core);
+
+/*
+ * Calculate the TOTP code of a credential for a time step, the step is passed in
+ * so callers can cache the code and only recalculate as the step advances.
+ *
+ * @param otp Set to the code and null terminator, at most OTP_MAX_DIGITS + 1 characters.
+ */
+void pico_otp_calculate_totp(otp_core_t *otp_core, uint8_t index, uint64_t step, char *otp);
+
+/*
+ * @returns true if the external flash is present, without it storage is on the
+ * internal flash and there are no security registers for the root record.
+ */
+bool pico_otp_flash_ready(otp_core_t *otp_core);
+
+/*
+ * Zeroed if the external flash is not present.
+ */
 void pico_otp_flash_device_info(otp_core_t *otp_core, flash_device_info_t *device_info);
 
+/*
+ * The size of the storage backend in bytes, for the external flash as detected
+ * from SFDP or the JEDEC ID at mount.
+ */
+uint32_t pico_otp_flash_size(otp_core_t *otp_core);
+
+/*
+ * The name of the storage backend in use.
+ */
+const char* pico_otp_storage_backend(otp_core_t *otp_core);
+
+/*
+ * Prepare to benchmark each storage backend available, the external flash if
+ * present, the internal flash and RAM.
+ *
+ * @returns the number of backends to be benchmarked.
+ */
+uint8_t pico_otp_storage_benchmark_start(otp_core_t *otp_core, struct storage_benchmark *benchmarks, uint8_t max);
+
+/*
+ * Advance the benchmarks a step, called on each pass of the main loop.
+ *
+ * @returns true whilst any benchmark remains to be completed.
+ */
+bool pico_otp_storage_benchmark_run(otp_core_t *otp_core, struct storage_benchmark *benchmarks, uint8_t count);
+
 /*
  * Has the underlying storage been initialised?
 */
 bool pico_otp_storage_initialised(otp_core_t *otp_core);
 
 /*
- * Wipe the underlying storage.
+ * Wipe the underlying storage, the erase runs in the background and on the
+ * external flash can be followed with flash_erase_get_status.
  *
  * If initialise is true the storage will be re-initialised.
 */
 void pico_otp_reset_storage(otp_core_t *otp_core, bool initialise);
 
 /*
- * Read data from flash at the specified address.
+ * Read data from the storage backend at the specified address.
  *
  * This function is probably too low level and knowledge about the use of flash should
  * not be exposed here.
  */
 void pico_otp_flash_read_data(otp_core_t *otp_core, uint32_t address, uint8_t *data, uint32_t length);
 
+/*
+ * Begin a background scan of the whole external flash, see flash_scan.h for the
+ * progress and results.
+ *
+ * @param pattern An optional pattern to search for, NULL if pattern_length is 0.
+ * @returns false if the external flash is not present or the scan could not start.
+ */
+bool pico_otp_flash_scan_start(otp_core_t *otp_core, const uint8_t *pattern, uint8_t pattern_length);
+
 #endif // OTP_H
\ No newline at end of file
@@ -0,0 +1,485 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "cdc_tx_ring.h"
+#include "otp_hot_path.h"
+#include "otp_log.h"
+#include "screen_buffer.h"
+#include "vt102_decoder.h"
+
+#define SCREEN_BUFFER_CONTEXT_ID 0xB4
+
+// The longest cursor movement, ESC [ 35 ; 132 H, any cheaper alternative is shorter.
+#define MAX_MOVE_LENGTH 10
+
+struct screen_buffer
+{
+    char id;
+    char back[SCREEN_BUFFER_ROWS][SCREEN_BUFFER_COLUMNS];  // The frame being drawn.
+    char front[SCREEN_BUFFER_ROWS][SCREEN_BUFFER_COLUMNS]; // What the terminal is showing.
+    // Drawing position within the back buffer, 0 based.
+    uint8_t row;
+    uint8_t column;
+    // Position of the terminal cursor, 0 based.
+    uint8_t cursor_row;
+    uint8_t cursor_column;
+    bool cursor_known;
+    bool invalid;
+    bool pending; // The last present was held back waiting for the TX ring to drain.
+    // Statistics
+    struct screen_buffer_stats stats;
+    uint32_t frame_bytes;
+    uint32_t frame_saved_bytes;
+    uint32_t frame_transfers; // The transfer count when the last frame completed.
+    uint64_t second_start_us;
+    uint32_t second_frames;
+};
+
+screen_buffer_t* screen_buffer_init()
+{
+    struct screen_buffer *screen_buffer = malloc(sizeof(struct screen_buffer));
+    screen_buffer->id = SCREEN_BUFFER_CONTEXT_ID;
+
+    memset(&screen_buffer->stats, 0x00, sizeof(struct screen_buffer_stats));
+    screen_buffer->second_start_us = 0;
+    screen_buffer->second_frames = 0;
+    screen_buffer->frame_transfers = 0;
+    screen_buffer->pending = false;
+
+    screen_buffer_clear(screen_buffer);
+    screen_buffer_invalidate(screen_buffer);
+
+    return screen_buffer;
+}
+
+void screen_buffer_clear(screen_buffer_t *screen_buffer)
+{
+    memset(screen_buffer->back, ' ', sizeof(screen_buffer->back));
+    screen_buffer->row = 0;
+    screen_buffer->column = 0;
+}
+
+void screen_buffer_cup(screen_buffer_t *screen_buffer, uint8_t row, uint8_t column)
+{
+    row = row == 0 ? 0 : row - 1;
+    column = column == 0 ? 0 : column - 1;
+    screen_buffer->row = row < SCREEN_BUFFER_ROWS ? row : SCREEN_BUFFER_ROWS - 1;
+    screen_buffer->column = column < SCREEN_BUFFER_COLUMNS ? column : SCREEN_BUFFER_COLUMNS - 1;
+}
+
+void screen_buffer_write_char(screen_buffer_t *screen_buffer, char c)
+{
+    // Characters beyond the right margin are discarded.
+    if (screen_buffer->column < SCREEN_BUFFER_COLUMNS)
+    {
+        screen_buffer->back[screen_buffer->row][screen_buffer->column] = c;
+        screen_buffer->column++;
+    }
+}
+
+void screen_buffer_write_str(screen_buffer_t *screen_buffer, const char *str)
+{
+    while (*str != 0x00)
+    {
+        screen_buffer_write_char(screen_buffer, *str++);
+    }
+}
+
+void screen_buffer_invalidate(screen_buffer_t *screen_buffer)
+{
+    screen_buffer->invalid = true;
+    screen_buffer->cursor_known = false;
+    // Anything not yet sent is about to be replaced by the reset and repaint.
+    cdc_tx_ring_clear();
+}
+
+bool screen_buffer_pending(screen_buffer_t *screen_buffer)
+{
+    return screen_buffer->pending;
+}
+
+/*
+ * Output
+ *
+ * All output goes through these functions so the bytes sent can be counted,
+ * space in the TX ring must have been reserved first.
+ */
+
+static void OTP_HOT_PATH(_emit_char)(struct screen_buffer *screen_buffer, char c)
+{
+    cdc_tx_ring_write_char(c);
+    screen_buffer->frame_bytes++;
+}
+
+static void _emit_str(struct screen_buffer *screen_buffer, const char *str)
+{
+    while (*str != 0x00)
+    {
+        _emit_char(screen_buffer, *str++);
+    }
+}
+
+static void _emit_decimal(struct screen_buffer *screen_buffer, uint8_t value)
+{
+    if (value >= 100)
+    {
+        _emit_char(screen_buffer, '0' + value / 100);
+    }
+    if (value >= 10)
+    {
+        _emit_char(screen_buffer, '0' + (value / 10) % 10);
+    }
+    _emit_char(screen_buffer, '0' + value % 10);
+}
+
+static uint8_t _decimal_length(uint8_t value)
+{
+    return value >= 100 ? 3 : value >= 10 ? 2 : 1;
+}
+
+/*
+ * Cursor Movement
+ *
+ * Each move picks the cheapest of an absolute CUP, the relative CUU / CUD /
+ * CUF / CUB sequences, CR and LF or re-sending the characters the terminal is
+ * already showing between the cursor and the target.
+ *
+ * LF is only used to move down within the rows we draw so it never scrolls on
+ * a terminal with at least SCREEN_BUFFER_ROWS rows.
+ */
+
+// The length of the CUP sequence to move to a 0 based position.
+static uint8_t _cup_length(uint8_t row, uint8_t column)
+{
+    if (row == 0 && column == 0)
+    {
+        return 3; // ESC [ H
+    }
+
+    return 4 + _decimal_length(row + 1) + _decimal_length(column + 1);
+}
+
+static void _emit_cup(struct screen_buffer *screen_buffer, uint8_t row, uint8_t column)
+{
+    _emit_str(screen_buffer, "\x1b[");
+    if (row != 0 || column != 0)
+    {
+        _emit_decimal(screen_buffer, row + 1);
+        _emit_char(screen_buffer, ';');
+        _emit_decimal(screen_buffer, column + 1);
+    }
+    _emit_char(screen_buffer, 'H');
+}
+
+// The length of a relative move sequence, the count is omitted when it is 1.
+static uint8_t _sequence_length(uint8_t count)
+{
+    return count == 1 ? 3 : 3 + _decimal_length(count);
+}
+
+static void _emit_sequence(struct screen_buffer *screen_buffer, uint8_t count, char final)
+{
+    _emit_str(screen_buffer, "\x1b[");
+    if (count != 1)
+    {
+        _emit_decimal(screen_buffer, count);
+    }
+    _emit_char(screen_buffer, final);
+}
+
+/*
+ * Move the cursor within a row, returns the number of bytes needed and only
+ * sends them if emit is true.
+ */
+static uint32_t _move_horizontal(struct screen_buffer *screen_buffer, uint8_t row, uint8_t from, uint8_t to, bool emit)
+{
+    if (from == to)
+    {
+        return 0;
+    }
+
+    if (to > from)
+    {
+        uint8_t distance = to - from;
+        if (distance <= _sequence_length(distance))
+        {
+            if (emit)
+            {
+                for (uint8_t i = from; i < to; i++)
+                {
+                    _emit_char(screen_buffer, screen_buffer->front[row][i]);
+                }
+            }
+            return distance;
+        }
+
+        if (emit)
+        {
+            _emit_sequence(screen_buffer, distance, 'C');
+        }
+        return _sequence_length(distance);
+    }
+
+    uint8_t distance = from - to;
+    uint32_t carriage_return = 1 + _move_horizontal(screen_buffer, row, 0, to, false);
+    if (carriage_return < _sequence_length(distance))
+    {
+        if (emit)
+        {
+            _emit_char(screen_buffer, '\r');
+            _move_horizontal(screen_buffer, row, 0, to, true);
+        }
+        return carriage_return;
+    }
+
+    if (emit)
+    {
+        _emit_sequence(screen_buffer, distance, 'D');
+    }
+    return _sequence_length(distance);
+}
+
+/*
+ * Move the cursor between rows keeping the column, returns the number of
+ * bytes needed and only sends them if emit is true.
+ */
+static uint32_t _move_vertical(struct screen_buffer *screen_buffer, uint8_t from, uint8_t to, bool emit)
+{
+    if (to > from)
+    {
+        uint8_t distance = to - from;
+        if (distance <= _sequence_length(distance))
+        {
+            if (emit)
+            {
+                for (uint8_t i = 0; i < distance; i++)
+                {
+                    _emit_char(screen_buffer, '\n');
+                }
+            }
+            return distance;
+        }
+
+        if (emit)
+        {
+            _emit_sequence(screen_buffer, distance, 'B');
+        }
+        return _sequence_length(distance);
+    }
+    else if (to < from)
+    {
+        if (emit)
+        {
+            _emit_sequence(screen_buffer, from - to, 'A');
+        }
+        return _sequence_length(from - to);
+    }
+
+    return 0;
+}
+
+static void OTP_HOT_PATH(_move_cursor)(struct screen_buffer *screen_buffer, uint8_t row, uint8_t column)
+{
+    uint32_t cup = _cup_length(row, column);
+
+    if (!screen_buffer->cursor_known)
+    {
+        _emit_cup(screen_buffer, row, column);
+    }
+    else if (screen_buffer->cursor_row != row || screen_buffer->cursor_column != column)
+    {
+        uint8_t cursor_row = screen_buffer->cursor_row;
+        uint8_t cursor_column = screen_buffer->cursor_column;
+
+        uint32_t vertical = _move_vertical(screen_buffer, cursor_row, row, false);
+        // Either keep the current column or return to the start of the row first.
+        uint32_t keep_column = vertical + _move_horizontal(screen_buffer, row, cursor_column, column, false);
+        uint32_t carriage_return = 1 + vertical + _move_horizontal(screen_buffer, row, 0, column, false);
+
+        if (cup <= keep_column && cup <= carriage_return)
+        {
+            _emit_cup(screen_buffer, row, column);
+        }
+        else if (keep_column <= carriage_return)
+        {
+            _move_vertical(screen_buffer, cursor_row, row, true);
+            _move_horizontal(screen_buffer, row, cursor_column, column, true);
+            screen_buffer->frame_saved_bytes += cup - keep_column;
+        }
+        else
+        {
+            _emit_char(screen_buffer, '\r');
+            _move_vertical(screen_buffer, cursor_row, row, true);
+            _move_horizontal(screen_buffer, row, 0, column, true);
+            screen_buffer->frame_saved_bytes += cup - carriage_return;
+        }
+    }
+    else
+    {
+        // Already in position, the whole CUP is saved.
+        screen_buffer->frame_saved_bytes += cup;
+    }
+
+    screen_buffer->cursor_row = row;
+    screen_buffer->cursor_column = column;
+    screen_buffer->cursor_known = true;
+}
+
+void OTP_HOT_PATH(screen_buffer_present)(screen_buffer_t *screen_buffer)
+{
+    if (screen_buffer->id != SCREEN_BUFFER_CONTEXT_ID)
+    {
+        OTP_LOG_ERROR("Invalid context passed to screen_buffer_present 0x%02x\n", screen_buffer->id);
+        return;
+    }
+
+    if (!screen_buffer->pending)
+    {
+        // Only a new frame resets the counts, a held back frame continues.
+        screen_buffer->frame_bytes = 0;
+        screen_buffer->frame_saved_bytes = 0;
+    }
+    screen_buffer->pending = true;
+    // A full repaint is a reset, erase display and every row drawn in full.
+    uint32_t full_bytes = 6;
+
+    if (screen_buffer->invalid)
+    {
+        if (!cdc_tx_ring_reserve(2 + sizeof(VT102_ENABLE_BRACKETED_PASTE)))
+        {
+            return;
+        }
+
+        // Reset to initial state, the terminal is left blank with the cursor home.
+        _emit_str(screen_buffer, "\x1b" "c");
+        // The reset clears the modes so bracketed paste needs enabling each time.
+        _emit_str(screen_buffer, VT102_ENABLE_BRACKETED_PASTE);
+        memset(screen_buffer->front, ' ', sizeof(screen_buffer->front));
+        screen_buffer->cursor_row = 0;
+        screen_buffer->cursor_column = 0;
+        screen_buffer->cursor_known = true;
+        screen_buffer->invalid = false;
+    }
+
+    for (uint8_t row = 0; row < SCREEN_BUFFER_ROWS; row++)
+    {
+        char *back = screen_buffer->back[row];
+        char *front = screen_buffer->front[row];
+
+        int last = SCREEN_BUFFER_COLUMNS - 1;
+        while (last >= 0 && back[last] == ' ')
+        {
+            last--;
+        }
+        if (last >= 0)
+        {
+            full_bytes += _cup_length(row, 0) + last + 1;
+        }
+
+        int column = 0;
+        while (column < SCREEN_BUFFER_COLUMNS)
+        {
+            if (back[column] == front[column])
+            {
+                column++;
+                continue;
+            }
+
+            // Short gaps between spans are bridged by _move_cursor re-sending
+            // the unchanged characters when that is cheaper than a sequence.
+            int end = column;
+            while (end + 1 < SCREEN_BUFFER_COLUMNS && back[end + 1] != front[end + 1])
+            {
+                end++;
+            }
+
+            if (!cdc_tx_ring_reserve(MAX_MOVE_LENGTH + end - column + 1))
+            {
+                // Back pressure, the front buffer still reflects exactly what
+                // was sent so the next present continues from here.
+                cdc_tx_ring_drain();
+                return;
+            }
+
+            _move_cursor(screen_buffer, row, column);
+            for (int i = column; i <= end; i++)
+            {
+                _emit_char(screen_buffer, back[i]);
+                front[i] = back[i];
+            }
+
+            if (end + 1 < SCREEN_BUFFER_COLUMNS)
+            {
+                screen_buffer->cursor_column = end + 1;
+            }
+            else
+            {
+                // Wrapping behaviour at the right margin depends on the terminal.
+                screen_buffer->cursor_known = false;
+            }
+            column = end + 1;
+        }
+    }
+
+    full_bytes += _cup_length(screen_buffer->row, screen_buffer->column);
+    if (!cdc_tx_ring_reserve(MAX_MOVE_LENGTH))
+    {
+        cdc_tx_ring_drain();
+        return;
+    }
+    _move_cursor(screen_buffer, screen_buffer->row, screen_buffer->column);
+    // One flush for the whole frame.
+    cdc_tx_ring_drain();
+    screen_buffer->pending = false;
+
+    // Update the statistics.
+    struct screen_buffer_stats *stats = &screen_buffer->stats;
+    stats->frames++;
+    stats->last_frame_bytes = screen_buffer->frame_bytes;
+    stats->last_full_bytes = full_bytes;
+    stats->total_bytes += screen_buffer->frame_bytes;
+    stats->last_frame_saved_bytes = screen_buffer->frame_saved_bytes;
+    stats->total_saved_bytes += screen_buffer->frame_saved_bytes;
+
+    uint64_t now = time_us_64();
+    screen_buffer->second_frames++;
+    if (now - screen_buffer->second_start_us >= 1000000)
+    {
+        stats->frames_per_second = screen_buffer->second_frames;
+        screen_buffer->second_frames = 0;
+        screen_buffer->second_start_us = now;
+    }
+
+    // Transfers complete asynchronously, report those since the previous frame.
+    struct cdc_tx_ring_stats ring_stats;
+    cdc_tx_ring_get_stats(&ring_stats);
+    uint32_t transfers = ring_stats.transfers - screen_buffer->frame_transfers;
+    screen_buffer->frame_transfers = ring_stats.transfers;
+
+    OTP_LOG_DEBUG("Frame %d sent %d bytes, full repaint %d bytes, cursor moves saved %d bytes, %d fps, %d USB transfers since last frame\n",
+        stats->frames, stats->last_frame_bytes, stats->last_full_bytes, stats->last_frame_saved_bytes,
+        stats->frames_per_second, transfers);
+}
+
+void screen_buffer_get_stats(screen_buffer_t *screen_buffer, struct screen_buffer_stats *stats)
+{
+    memcpy(stats, &screen_buffer->stats, sizeof(struct screen_buffer_stats));
+}
@@ -0,0 +1,93 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The screen buffer is a shadow of the VT102 terminal.
+ *
+ * Renderers draw into a back buffer of cells, presenting the buffer compares it
+ * with a front buffer holding what the terminal is currently showing and only
+ * the cells which have changed are sent.
+ */
+
+#ifndef SCREEN_BUFFER_H
+#define SCREEN_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCREEN_BUFFER_ROWS 35
+#define SCREEN_BUFFER_COLUMNS 132
+
+struct screen_buffer_stats
+{
+    uint32_t frames;            // Total frames presented.
+    uint32_t frames_per_second; // Frames presented in the last full second.
+    uint32_t last_frame_bytes;  // Bytes sent for the last frame.
+    uint32_t last_full_bytes;   // Bytes a full repaint of the last frame would have sent.
+    uint64_t total_bytes;       // Total bytes sent for all frames.
+    uint32_t last_frame_saved_bytes; // Bytes saved by cursor movement for the last frame compared to CUP.
+    uint64_t total_saved_bytes;      // Bytes saved by cursor movement for all frames.
+};
+
+typedef struct screen_buffer screen_buffer_t;
+
+/*
+ * Allocate and initialise a new screen buffer.
+ *
+ * The terminal contents are initially unknown so the first present will be a
+ * full repaint.
+ */
+screen_buffer_t* screen_buffer_init();
+
+/*
+ * Clear the back buffer ready for a renderer to draw a new frame.
+ */
+void screen_buffer_clear(screen_buffer_t *screen_buffer);
+
+/*
+ * Move the drawing position, row and column are 1 based with 0 treated as 1
+ * in the same way as a VT102 CUP sequence.
+ *
+ * The final position set before presenting is where the terminal cursor is left.
+ */
+void screen_buffer_cup(screen_buffer_t *screen_buffer, uint8_t row, uint8_t column);
+
+void screen_buffer_write_char(screen_buffer_t *screen_buffer, char c);
+
+void screen_buffer_write_str(screen_buffer_t *screen_buffer, const char *str);
+
+/*
+ * Mark the terminal contents as unknown, the next present will reset the
+ * terminal and repaint everything.
+ */
+void screen_buffer_invalidate(screen_buffer_t *screen_buffer);
+
+/*
+ * Send the differences between the back buffer and the terminal.
+ *
+ * If the TX ring is full the present is held back part way, call again once
+ * the ring has drained to continue.
+ */
+void screen_buffer_present(screen_buffer_t *screen_buffer);
+
+/*
+ * @returns true if the last present was held back waiting for the TX ring.
+ */
+bool screen_buffer_pending(screen_buffer_t *screen_buffer);
+
+void screen_buffer_get_stats(screen_buffer_t *screen_buffer, struct screen_buffer_stats *stats);
+
+#endif // SCREEN_BUFFER_H
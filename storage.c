@@ -14,29 +14,34 @@
  * If  not, see <https://www.gnu.org/licenses/>.
 */
 
-#include <stdio.h> // TODO Remove Later If Not Needed
 #include <string.h>
 
+#include "otp_log.h"
 #include "storage.h"
 #include "storage_address_map.h"
+#include "storage_internal.h"
 
 static char header[8] = "PICOWARD";
 
+// The internal flash is the smallest backend storage is kept on.
+_Static_assert(HEADER_B + sizeof(header) <= STORAGE_INTERNAL_SIZE - STORAGE_RESERVED_LENGTH,
+    "The storage headers overlap the reserved region of the internal flash");
+
 static void _storage_output_header(char *header)
 {
-    printf("Header: ");
-    for (int i = 0; i < 8; i++)
-    {
-        printf("%02x", header[i]);
-    }
-    printf("\n");
+    // Deferred rather than printf, this runs as part of mounting.
+    uint32_t high;
+    uint32_t low;
+    memcpy(&high, header, 4);
+    memcpy(&low, &header[4], 4);
+    OTP_LOG_DEBUG("Header: %08x%08x\n", __builtin_bswap32(high), __builtin_bswap32(low));
 }
 
-void storage_begin(storage_context_t *context, flash_context_t *flash_context)
+void storage_begin(storage_context_t *context, const struct storage_backend *backend)
 {
     if (context->id != STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to storage_begin 0x%02x\n", context->id);
+        OTP_LOG_ERROR("Invalid context passed to storage_begin 0x%02x\n", context->id);
         return;
     }
 
@@ -47,13 +52,20 @@ void storage_begin(storage_context_t *context, flash_context_t *flash_context)
     char header_a[8];
     char header_b[8];
 
-    flash_read_data(flash_context, HEADER_A, header_a, 8);
+    // A backend too small to hold the headers below its reserved region is never initialised.
+    memset(header_a, 0xFF, sizeof(header_a));
+    memset(header_b, 0xFF, sizeof(header_b));
+    bool fits = HEADER_B + sizeof(header_b) <= storage_backend_usable_size(backend);
+    if (!fits)
+    {
+        OTP_LOG_ERROR("Storage headers overlap the reserved region of %s\n", backend->name);
+    }
+    bool read = fits && backend->read(HEADER_A, header_a, 8) && backend->read(HEADER_B, header_b, 8);
     _storage_output_header(header_a);
-    flash_read_data(flash_context, HEADER_B, header_b, 8);
     _storage_output_header(header_b);
 
-    context->flash_context = flash_context;
-    context->initialised = strncmp(header_a, header, 8) == 0 &&
+    context->backend = backend;
+    context->initialised = read && strncmp(header_a, header, 8) == 0 &&
                             strncmp(header_b, header, 8) == 0;
 }
 
@@ -61,7 +73,7 @@ bool storage_initialised(storage_context_t *context)
 {
     if (context->id != STORAGE_CONTEXT_ID)
     {
-        printf("Invalid context passed to storage_initialised 0x%02x\n", context->id);
+        OTP_LOG_ERROR("Invalid context passed to storage_initialised 0x%02x\n", context->id);
         return false;
     }
 
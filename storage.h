@@ -19,13 +19,13 @@
 
 #include <stdbool.h>
 
-#include "flash/flash.h"
+#include "storage_backend.h"
 
 #define STORAGE_CONTEXT_ID 0xB3
 struct storage_context
 {
     char id;
-    flash_context_t *flash_context;
+    const struct storage_backend *backend;
     bool initialised;
 
 };
@@ -35,7 +35,7 @@ typedef struct storage_context storage_context_t;
 /*
  * Establish the storage context and detect if it has been initialised.
 */
-void storage_begin(storage_context_t *context, flash_context_t *flash_context);
+void storage_begin(storage_context_t *context, const struct storage_backend *backend);
 
 /*
  * Has the underlying storage been initialised?
@@ -17,6 +17,8 @@
 #ifndef STORAGE_ADDRESS_MAP_H
 #define STORAGE_ADDRESS_MAP_H
 
+#include "storage_backend.h"
+
 /*
 * This file is used to map the storage addresses to the specific locations used in the application.
 */
@@ -24,4 +26,16 @@
 #define HEADER_A 0x000000
 #define HEADER_B 0x008000
 
+// The final STORAGE_BENCHMARK_LENGTH bytes of every backend are scratch for
+// storage_benchmark and must not be used.
+
+// Without the external flash there are no security registers so the root record
+// is kept in the sector before the benchmark scratch, resetting storage leaves
+// it as it leaves the security registers.
+#define ROOT_RECORD_LENGTH 0x1000
+
+// Everything above storage_backend_usable_size, storage_begin refuses a backend
+// too small to hold the headers below it.
+#define STORAGE_RESERVED_LENGTH (STORAGE_BENCHMARK_LENGTH + ROOT_RECORD_LENGTH)
+
 #endif // STORAGE_ADDRESS_MAP_H
\ No newline at end of file
@@ -0,0 +1,170 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stddef.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "clock_policy.h"
+#include "otp_event.h"
+#include "storage_address_map.h"
+#include "storage_backend.h"
+
+// The erase waiting to be reported.
+static struct
+{
+    const struct storage_backend *backend;
+    storage_backend_callback callback;
+    void *handback;
+} pending;
+
+bool storage_backend_erase(const struct storage_backend *backend, uint32_t address, uint32_t length,
+    storage_backend_callback callback, void *handback)
+{
+    if (!backend->erase(address, length))
+    {
+        return false;
+    }
+
+    pending.backend = backend;
+    pending.callback = callback;
+    pending.handback = handback;
+    // Backends which erase immediately still report from the main loop.
+    otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+
+    return true;
+}
+
+void storage_backend_run(const struct storage_backend *backend)
+{
+    backend->run();
+
+    if (pending.backend == backend && !backend->busy())
+    {
+        storage_backend_callback callback = pending.callback;
+        void *handback = pending.handback;
+        // Cleared first so the callback can start another erase.
+        pending.backend = NULL;
+        pending.callback = NULL;
+        if (callback != NULL)
+        {
+            callback(handback);
+        }
+    }
+}
+
+uint32_t storage_backend_usable_size(const struct storage_backend *backend)
+{
+    struct storage_geometry geometry;
+    backend->geometry(&geometry);
+
+    return geometry.size > STORAGE_RESERVED_LENGTH ? geometry.size - STORAGE_RESERVED_LENGTH : 0;
+}
+
+void storage_benchmark_init(const struct storage_backend *backend, struct storage_benchmark *benchmark)
+{
+    memset(benchmark, 0x00, sizeof(struct storage_benchmark));
+    benchmark->backend = backend;
+    benchmark->name = backend->name;
+    benchmark->state = STORAGE_BENCHMARK_PENDING;
+}
+
+static void _benchmark_skip(struct storage_benchmark *benchmark)
+{
+    benchmark->skipped = true;
+    benchmark->state = STORAGE_BENCHMARK_COMPLETE;
+}
+
+bool storage_benchmark_run(struct storage_benchmark *benchmark)
+{
+    const struct storage_backend *backend = benchmark->backend;
+    struct storage_geometry geometry;
+    backend->geometry(&geometry);
+    uint32_t address = geometry.size - STORAGE_BENCHMARK_LENGTH;
+
+    if (benchmark->state == STORAGE_BENCHMARK_PENDING)
+    {
+        // Only ever the scratch, an erase unit larger than it would reach the
+        // reserved region before it.
+        if (backend->busy() || geometry.size < STORAGE_RESERVED_LENGTH || geometry.page_size == 0 ||
+            STORAGE_BENCHMARK_LENGTH % geometry.erase_size != 0)
+        {
+            _benchmark_skip(benchmark);
+            return true;
+        }
+
+        benchmark->start_us = time_us_32();
+        if (!backend->erase(address, STORAGE_BENCHMARK_LENGTH))
+        {
+            _benchmark_skip(benchmark);
+            return true;
+        }
+        benchmark->state = STORAGE_BENCHMARK_ERASING;
+    }
+
+    if (benchmark->state == STORAGE_BENCHMARK_COMPLETE)
+    {
+        return true;
+    }
+
+    // The first run of the internal flash completes its single sector before
+    // returning so no other erase can be started in between.
+    if (backend->busy())
+    {
+        backend->run();
+        if (backend->busy())
+        {
+            return false;
+        }
+    }
+    benchmark->erase_us = time_us_32() - benchmark->start_us;
+
+    // A page at a time, as the records will be written.
+    uint8_t page[256];
+    uint32_t chunk = geometry.page_size < sizeof(page) ? geometry.page_size : sizeof(page);
+    for (uint32_t i = 0; i < chunk; i++)
+    {
+        page[i] = i;
+    }
+
+    // Only boosted for the program and read, a benchmark abandoned during the
+    // erase must not leave the clock raised.
+    clock_policy_boost(CLOCK_OP_FLASH);
+
+    uint32_t start = time_us_32();
+    for (uint32_t offset = 0; offset < STORAGE_BENCHMARK_LENGTH; offset += chunk)
+    {
+        backend->program(address + offset, page, chunk);
+    }
+    benchmark->program_us = time_us_32() - start;
+
+    uint8_t read[256];
+    benchmark->verified = true;
+    start = time_us_32();
+    for (uint32_t offset = 0; offset < STORAGE_BENCHMARK_LENGTH; offset += chunk)
+    {
+        benchmark->verified = backend->read(address + offset, read, chunk) && benchmark->verified &&
+            memcmp(read, page, chunk) == 0;
+    }
+    benchmark->read_us = time_us_32() - start;
+
+    clock_policy_release(CLOCK_OP_FLASH);
+    benchmark->state = STORAGE_BENCHMARK_COMPLETE;
+
+    return true;
+}
@@ -0,0 +1,117 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * A Storage Backend is the medium the storage is kept on, the external SPI NOR
+ * flash, a region at the end of the RP2040's own flash or RAM.
+ *
+ * All backends have NOR semantics, an erase sets every byte to 0xFF and a
+ * program can only clear bits. Reads and programs complete before returning,
+ * an erase is only started and is advanced by run from the main loop so the
+ * caller is told of its completion by a callback.
+ *
+ * Each backend is a single instance so the operations take no context.
+ */
+
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct storage_geometry
+{
+    uint32_t size;
+    uint32_t page_size;  // A program must not cross a page boundary.
+    uint32_t erase_size; // Erases are a multiple of this and aligned to it.
+};
+
+struct storage_backend
+{
+    const char *name;
+    void (*geometry)(struct storage_geometry *geometry);
+    // @returns false if the range is outside of the backend, data is left untouched.
+    bool (*read)(uint32_t address, void *data, uint32_t length);
+    bool (*program)(uint32_t address, const void *data, uint32_t length);
+    // Begin erasing the range, the erase continues from run.
+    bool (*erase)(uint32_t address, uint32_t length);
+    // @returns true whilst an erase is in progress.
+    bool (*busy)();
+    // Advance any background work, called on each pass of the main loop.
+    void (*run)();
+};
+
+typedef void (*storage_backend_callback)(void *handback);
+
+/*
+ * Begin erasing the range, the callback is called from storage_backend_run once
+ * the erase is complete.
+ *
+ * Only one erase is tracked at a time, starting another replaces the callback.
+ *
+ * @returns false if the backend refused the erase, the callback is not called.
+ */
+bool storage_backend_erase(const struct storage_backend *backend, uint32_t address, uint32_t length,
+    storage_backend_callback callback, void *handback);
+
+/*
+ * Advance the backend and report the completion of any erase.
+ */
+void storage_backend_run(const struct storage_backend *backend);
+
+/*
+ * The size of the backend less the region reserved at its end by
+ * storage_address_map.h, nothing but the owners of that region may use
+ * addresses at or above this.
+ */
+uint32_t storage_backend_usable_size(const struct storage_backend *backend);
+
+#define STORAGE_BENCHMARK_LENGTH 4096
+
+enum storage_benchmark_state
+{
+    STORAGE_BENCHMARK_PENDING,
+    STORAGE_BENCHMARK_ERASING,
+    STORAGE_BENCHMARK_COMPLETE
+};
+
+struct storage_benchmark
+{
+    const struct storage_backend *backend;
+    const char *name;
+    uint8_t state; // enum storage_benchmark_state
+    bool skipped; // The backend was busy, too small or erases more than the scratch.
+    bool verified; // The data read back matched that programmed.
+    uint32_t read_us;
+    uint32_t program_us;
+    uint32_t erase_us;
+    uint32_t start_us; // When the erase was issued.
+};
+
+void storage_benchmark_init(const struct storage_backend *backend, struct storage_benchmark *benchmark);
+
+/*
+ * Time an erase, program and read of the final STORAGE_BENCHMARK_LENGTH bytes of
+ * the backend, which are reserved for this. The erase is issued on the first call
+ * and polled on each call after so the main loop is not blocked for it, the
+ * erase time includes the polling interval.
+ *
+ * @returns true once the benchmark is complete.
+ */
+bool storage_benchmark_run(struct storage_benchmark *benchmark);
+
+#endif // STORAGE_BACKEND_H
@@ -0,0 +1,183 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <string.h>
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/stdlib.h"
+
+#include "otp_event.h"
+#include "otp_log.h"
+#include "storage_internal.h"
+
+// The offset of the region from the start of the flash.
+#define STORAGE_INTERNAL_OFFSET (PICO_FLASH_SIZE_BYTES - STORAGE_INTERNAL_SIZE)
+// How long to wait for the other core to be locked out.
+#define STORAGE_INTERNAL_LOCKOUT_MS 100
+
+extern char __flash_binary_end;
+
+static struct
+{
+    bool available;
+    uint32_t next_address; // The next sector to erase.
+    uint32_t end_address;  // The end of the range being erased.
+    // The operation for _flash_operation, programs are from RAM as XIP is stopped.
+    bool program;
+    uint32_t flash_offset;
+    uint8_t page[FLASH_PAGE_SIZE];
+} internal;
+
+static void _flash_operation(void *param)
+{
+    if (internal.program)
+    {
+        flash_range_program(internal.flash_offset, internal.page, FLASH_PAGE_SIZE);
+    }
+    else
+    {
+        flash_range_erase(internal.flash_offset, FLASH_SECTOR_SIZE);
+    }
+}
+
+static bool _execute(bool program, uint32_t address)
+{
+    internal.program = program;
+    internal.flash_offset = STORAGE_INTERNAL_OFFSET + address;
+    int result = flash_safe_execute(_flash_operation, NULL, STORAGE_INTERNAL_LOCKOUT_MS);
+    if (result != PICO_OK)
+    {
+        OTP_LOG_ERROR("Internal flash operation at 0x%08x failed %d\n", address, result);
+        return false;
+    }
+
+    return true;
+}
+
+static void _geometry(struct storage_geometry *geometry)
+{
+    geometry->size = internal.available ? STORAGE_INTERNAL_SIZE : 0;
+    geometry->page_size = FLASH_PAGE_SIZE;
+    geometry->erase_size = FLASH_SECTOR_SIZE;
+}
+
+static bool _read(uint32_t address, void *data, uint32_t length)
+{
+    if (!internal.available || length > STORAGE_INTERNAL_SIZE || address > STORAGE_INTERNAL_SIZE - length)
+    {
+        return false;
+    }
+
+    memcpy(data, (const void *) (XIP_NOCACHE_NOALLOC_BASE + STORAGE_INTERNAL_OFFSET + address), length);
+
+    return true;
+}
+
+static bool _program(uint32_t address, const void *data, uint32_t length)
+{
+    if (!internal.available || length > STORAGE_INTERNAL_SIZE || address > STORAGE_INTERNAL_SIZE - length)
+    {
+        return false;
+    }
+
+    // Only whole pages can be programmed, 0xFF leaves the rest of the page as it was.
+    const uint8_t *source = data;
+    while (length > 0)
+    {
+        uint32_t page_address = address & ~(FLASH_PAGE_SIZE - 1);
+        uint32_t offset = address - page_address;
+        uint32_t chunk = FLASH_PAGE_SIZE - offset < length ? FLASH_PAGE_SIZE - offset : length;
+        memset(internal.page, 0xFF, FLASH_PAGE_SIZE);
+        memcpy(&internal.page[offset], source, chunk);
+        if (!_execute(true, page_address))
+        {
+            return false;
+        }
+
+        address += chunk;
+        source += chunk;
+        length -= chunk;
+    }
+
+    return true;
+}
+
+static bool _erase(uint32_t address, uint32_t length)
+{
+    if (!internal.available || address % FLASH_SECTOR_SIZE != 0 || length % FLASH_SECTOR_SIZE != 0 ||
+        length > STORAGE_INTERNAL_SIZE || address > STORAGE_INTERNAL_SIZE - length)
+    {
+        return false;
+    }
+
+    internal.next_address = address;
+    internal.end_address = address + length;
+
+    return true;
+}
+
+static bool _busy()
+{
+    return internal.next_address < internal.end_address;
+}
+
+static void _run()
+{
+    if (!_busy())
+    {
+        return;
+    }
+
+    if (!_execute(false, internal.next_address))
+    {
+        // Abandoned, the range is left partially erased.
+        internal.next_address = internal.end_address;
+        return;
+    }
+    internal.next_address += FLASH_SECTOR_SIZE;
+    if (_busy())
+    {
+        otp_event_post(OTP_EVENT_BACKGROUND, 0x00);
+    }
+}
+
+static const struct storage_backend internal_backend =
+{
+    .name = "Internal XIP Flash",
+    .geometry = _geometry,
+    .read = _read,
+    .program = _program,
+    .erase = _erase,
+    .busy = _busy,
+    .run = _run,
+};
+
+const struct storage_backend* storage_internal_init()
+{
+    uint32_t binary_end = (uintptr_t) &__flash_binary_end - XIP_BASE;
+    // Any erase in progress is left alone, this is called again for the benchmark.
+    internal.available = binary_end <= STORAGE_INTERNAL_OFFSET;
+    if (!internal.available)
+    {
+        OTP_LOG_ERROR("Program ends at 0x%08x, over the internal storage at 0x%08x\n", binary_end,
+            STORAGE_INTERNAL_OFFSET);
+        return NULL;
+    }
+
+    return &internal_backend;
+}
@@ -0,0 +1,45 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * A region at the end of the RP2040's own QSPI flash as a storage backend, for
+ * boards without the external flash.
+ *
+ * The region is read through the XIP window that bypasses the cache so reading
+ * storage does not evict code. Programming and erasing stop XIP so they run
+ * through flash_safe_execute, with interrupts disabled and the other core locked
+ * out if it has been started as a lockout victim.
+ *
+ * A sector erase takes around 45 ms with interrupts disabled so a range is
+ * erased a sector at a time from the main loop.
+ */
+
+#ifndef STORAGE_INTERNAL_H
+#define STORAGE_INTERNAL_H
+
+#include "storage_backend.h"
+
+#ifndef STORAGE_INTERNAL_SIZE
+#define STORAGE_INTERNAL_SIZE (256 * 1024)
+#endif
+
+/*
+ * @returns the backend or NULL if the program overlaps the region.
+ */
+const struct storage_backend* storage_internal_init();
+
+#endif // STORAGE_INTERNAL_H
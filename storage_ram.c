@@ -0,0 +1,148 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef STORAGE_RAM_FILE
+#include <stdio.h>
+#endif
+
+#include "otp_log.h"
+#include "storage_ram.h"
+
+#define STORAGE_RAM_PAGE_SIZE 256
+#define STORAGE_RAM_ERASE_SIZE 4096
+
+static uint8_t *ram = NULL;
+
+static void _write_back(uint32_t address, uint32_t length)
+{
+#ifdef STORAGE_RAM_FILE
+    FILE *file = fopen(STORAGE_RAM_FILE, "r+b");
+    if (file == NULL)
+    {
+        file = fopen(STORAGE_RAM_FILE, "w+b");
+        if (file == NULL)
+        {
+            return;
+        }
+        // Write the lot so the file is full size.
+        address = 0;
+        length = STORAGE_RAM_SIZE;
+    }
+    fseek(file, address, SEEK_SET);
+    fwrite(&ram[address], 1, length, file);
+    fclose(file);
+#endif
+}
+
+static void _geometry(struct storage_geometry *geometry)
+{
+    geometry->size = STORAGE_RAM_SIZE;
+    geometry->page_size = STORAGE_RAM_PAGE_SIZE;
+    geometry->erase_size = STORAGE_RAM_ERASE_SIZE;
+}
+
+static bool _read(uint32_t address, void *data, uint32_t length)
+{
+    if (ram == NULL || length > STORAGE_RAM_SIZE || address > STORAGE_RAM_SIZE - length)
+    {
+        return false;
+    }
+
+    memcpy(data, &ram[address], length);
+
+    return true;
+}
+
+static bool _program(uint32_t address, const void *data, uint32_t length)
+{
+    if (ram == NULL || length > STORAGE_RAM_SIZE || address > STORAGE_RAM_SIZE - length)
+    {
+        return false;
+    }
+
+    // Programming can only clear bits, as with the flash.
+    const uint8_t *source = data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        ram[address + i] &= source[i];
+    }
+    _write_back(address, length);
+
+    return true;
+}
+
+static bool _erase(uint32_t address, uint32_t length)
+{
+    if (ram == NULL || address % STORAGE_RAM_ERASE_SIZE != 0 || length % STORAGE_RAM_ERASE_SIZE != 0 ||
+        length > STORAGE_RAM_SIZE || address > STORAGE_RAM_SIZE - length)
+    {
+        return false;
+    }
+
+    memset(&ram[address], 0xFF, length);
+    _write_back(address, length);
+
+    return true;
+}
+
+static bool _busy()
+{
+    // Every erase completes immediately.
+    return false;
+}
+
+static void _run()
+{
+}
+
+static const struct storage_backend ram_backend =
+{
+    .name = "RAM",
+    .geometry = _geometry,
+    .read = _read,
+    .program = _program,
+    .erase = _erase,
+    .busy = _busy,
+    .run = _run,
+};
+
+const struct storage_backend* storage_ram_init()
+{
+    if (ram == NULL)
+    {
+        ram = malloc(STORAGE_RAM_SIZE);
+        if (ram == NULL)
+        {
+            OTP_LOG_ERROR("Unable to allocate %d bytes of RAM storage\n", STORAGE_RAM_SIZE);
+            return NULL;
+        }
+        // As an erased flash unless there is a file to load.
+        memset(ram, 0xFF, STORAGE_RAM_SIZE);
+#ifdef STORAGE_RAM_FILE
+        FILE *file = fopen(STORAGE_RAM_FILE, "rb");
+        if (file != NULL)
+        {
+            fread(ram, 1, STORAGE_RAM_SIZE, file);
+            fclose(file);
+        }
+#endif
+    }
+
+    return &ram_backend;
+}
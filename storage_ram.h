@@ -0,0 +1,42 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * RAM as a storage backend with the same NOR semantics as the flash, for
+ * comparison in the benchmark and for host builds without any flash.
+ *
+ * If STORAGE_RAM_FILE is defined, as it is by the host build in tools/host,
+ * the contents are loaded from that file and every change is written back to it.
+ */
+
+#ifndef STORAGE_RAM_H
+#define STORAGE_RAM_H
+
+#include "storage_backend.h"
+
+#ifndef STORAGE_RAM_SIZE
+#define STORAGE_RAM_SIZE (16 * 1024)
+#endif
+
+/*
+ * The RAM is only allocated on the first call.
+ *
+ * @returns the backend or NULL if the RAM could not be allocated.
+ */
+const struct storage_backend* storage_ram_init();
+
+#endif // STORAGE_RAM_H
@@ -0,0 +1,132 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "flash_device.h"
+#include "flash_erase.h"
+#include "flash_power.h"
+#include "flash_scan.h"
+#include "flash_security.h"
+#include "storage_spi_nor.h"
+
+static flash_context_t *spi_flash_context;
+
+void storage_spi_nor_read_access()
+{
+    flash_scan_quiesce();
+    flash_security_quiesce();
+    flash_power_wake();
+    flash_erase_suspend();
+}
+
+void storage_spi_nor_write_access()
+{
+    flash_scan_quiesce();
+    flash_security_quiesce();
+    flash_power_wake();
+    flash_erase_quiesce();
+}
+
+static void _geometry(struct storage_geometry *geometry)
+{
+    const struct flash_geometry *device = flash_device_geometry();
+    geometry->size = device->size;
+    geometry->page_size = device->page_size;
+    geometry->erase_size = device->sector_size;
+}
+
+static bool _read(uint32_t address, void *data, uint32_t length)
+{
+    uint32_t size = flash_device_geometry()->size;
+    if (length > size || address > size - length)
+    {
+        return false;
+    }
+
+    storage_spi_nor_read_access();
+    flash_device_read(spi_flash_context, address, data, length);
+
+    return true;
+}
+
+static bool _program(uint32_t address, const void *data, uint32_t length)
+{
+    uint32_t size = flash_device_geometry()->size;
+    if (length > size || address > size - length)
+    {
+        return false;
+    }
+
+    storage_spi_nor_write_access();
+    flash_device_program(spi_flash_context, address, data, length);
+
+    return true;
+}
+
+static bool _erase(uint32_t address, uint32_t length)
+{
+    uint32_t size = flash_device_geometry()->size;
+    if (length > size || address > size - length)
+    {
+        return false;
+    }
+
+    // Any scan results are meaningless once the range is erased.
+    flash_scan_cancel();
+
+    return flash_erase_start(address, length);
+}
+
+static bool _busy()
+{
+    return flash_erase_active();
+}
+
+static void _run()
+{
+    // The flash accepts nothing else until a security register write completes.
+    if (flash_security_busy())
+    {
+        flash_security_run();
+        return;
+    }
+
+    flash_scan_run();
+    flash_erase_run();
+    // Deep power-down is not accepted whilst an erase is in progress.
+    if (!flash_erase_active())
+    {
+        flash_power_run();
+    }
+}
+
+static const struct storage_backend spi_nor_backend =
+{
+    .name = "External SPI NOR",
+    .geometry = _geometry,
+    .read = _read,
+    .program = _program,
+    .erase = _erase,
+    .busy = _busy,
+    .run = _run,
+};
+
+const struct storage_backend* storage_spi_nor_init(flash_context_t *flash_context)
+{
+    spi_flash_context = flash_context;
+
+    return &spi_nor_backend;
+}
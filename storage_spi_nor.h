@@ -0,0 +1,48 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * The external SPI NOR flash as a storage backend, using the geometry detected
+ * by flash_device.
+ *
+ * Reads take the bus from any scan and suspend any background erase, programs
+ * wait for the erase in progress to complete as the chip only accepts reads
+ * whilst an erase is suspended.
+ */
+
+#ifndef STORAGE_SPI_NOR_H
+#define STORAGE_SPI_NOR_H
+
+#include "flash/flash.h"
+#include "storage_backend.h"
+
+const struct storage_backend* storage_spi_nor_init(flash_context_t *flash_context);
+
+/*
+ * Take the SPI bus from any scan in progress, complete any security register
+ * write, bring the flash out of deep power-down and suspend any background
+ * erase, called before every read including by those outside of the backend.
+ */
+void storage_spi_nor_read_access();
+
+/*
+ * As storage_spi_nor_read_access but for writes, which are not allowed whilst
+ * an erase is suspended so wait for the erase in progress to complete.
+ */
+void storage_spi_nor_write_access();
+
+#endif // STORAGE_SPI_NOR_H
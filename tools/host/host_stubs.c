@@ -0,0 +1,60 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+
+#include "clock_policy.h"
+#include "otp_event.h"
+#include "otp_log.h"
+
+/*
+ * Host implementations of the device services the portable modules call, the
+ * log is written straight to stdout and events are discarded.
+ */
+
+uint32_t time_us_32()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+void clock_policy_boost(enum clock_policy_operation operation)
+{
+}
+
+void clock_policy_release(enum clock_policy_operation operation)
+{
+}
+
+bool otp_event_post(enum otp_event_type event_type, uint8_t data)
+{
+    return true;
+}
+
+void otp_log_write(uint8_t level, const char *format, uint8_t argc, ...)
+{
+    va_list args;
+    va_start(args, argc);
+    vprintf(format, args);
+    va_end(args);
+}
@@ -0,0 +1,29 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Host stand in for the Pico SDK platform header, only the section
+ * placement macros used by otp_hot_path.h are needed.
+ */
+
+#ifndef _PICO_PLATFORM_H
+#define _PICO_PLATFORM_H
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name) func_name
+
+#endif // _PICO_PLATFORM_H
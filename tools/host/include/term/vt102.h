@@ -0,0 +1,45 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Host stand in for the pico-term VT102 header, only the event passed to
+ * vt102_decoder handlers is needed. The names match the term submodule so
+ * vt102_decoder.c builds unchanged against either.
+ */
+
+#ifndef VT102_H
+#define VT102_H
+
+#include <stdint.h>
+
+enum vt102_event_type
+{
+    none,
+    connect,
+    disconnect,
+    character,
+    control,
+    special
+};
+
+typedef struct vt102_event
+{
+    enum vt102_event_type event_type;
+    uint32_t character;
+} vt102_event;
+
+#endif // VT102_H
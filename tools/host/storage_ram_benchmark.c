@@ -0,0 +1,50 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+
+#include "storage_ram.h"
+
+/*
+ * Run the storage benchmark against the RAM backend, built with
+ * STORAGE_RAM_FILE so the contents persist in that file between runs.
+ */
+
+int main()
+{
+    const struct storage_backend *backend = storage_ram_init();
+    if (backend == NULL)
+    {
+        return 1;
+    }
+
+    struct storage_benchmark benchmark;
+    storage_benchmark_init(backend, &benchmark);
+    while (!storage_benchmark_run(&benchmark))
+    {
+    }
+    if (benchmark.skipped)
+    {
+        printf("%s skipped\n", benchmark.name);
+        return 1;
+    }
+
+    printf("%s backed by %s, erase %u us, program %u us, read %u us, verified=%d\n", benchmark.name,
+        STORAGE_RAM_FILE, benchmark.erase_us, benchmark.program_us, benchmark.read_us, benchmark.verified);
+
+    return benchmark.verified ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "vt102_decoder.h"
+
+/*
+ * Decode a representative buffer repeatedly and report the decode rate.
+ */
+
+static void _benchmark_handler(vt102_event *event, void *handback)
+{
+    uint32_t *count = (uint32_t*)handback;
+    (*count)++;
+}
+
+static uint64_t _time_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int main()
+{
+    // Typing, cursor keys, a UTF-8 character and a bracketed paste.
+    static const char sample[] = "hello world\r\x1b[A\x1b[B\x1b[5~\x1bOP\xc3\xa9\x1b[200~JBSWY3DPEHPK3PXP\r\n\x1b[201~";
+    uint32_t events = 0;
+    vt102_decoder_t decoder;
+    vt102_decoder_init(&decoder, _benchmark_handler, &events);
+
+    const uint32_t iterations = 1000000;
+    uint64_t start = _time_ns();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        vt102_decoder_decode(&decoder, (const uint8_t*)sample, sizeof(sample) - 1);
+    }
+    uint64_t elapsed = _time_ns() - start;
+
+    uint64_t bytes = (uint64_t)iterations * (sizeof(sample) - 1);
+    printf("VT102 decoder benchmark %llu bytes, %u events in %llu ns\n",
+        (unsigned long long)bytes, events, (unsigned long long)elapsed);
+    printf("%.0f bytes/s\n", elapsed == 0 ? 0.0 : (double)bytes * 1e9 / elapsed);
+
+    return 0;
+}
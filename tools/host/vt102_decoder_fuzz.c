@@ -0,0 +1,44 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vt102_decoder.h"
+
+/*
+ * libFuzzer entry point, the input is decoded in two halves so sequences
+ * split across calls are also covered.
+ */
+
+static void _fuzz_handler(vt102_event *event, void *handback)
+{
+    (void)event;
+    (void)handback;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    vt102_decoder_t decoder;
+    vt102_decoder_init(&decoder, _fuzz_handler, NULL);
+
+    size_t split = size / 2;
+    vt102_decoder_decode(&decoder, data, (uint32_t)split);
+    vt102_decoder_decode(&decoder, data + split, (uint32_t)(size - split));
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Copyright 2025, Darran A Lofthouse
+#
+# This file is part of pico-ward.
+#
+# pico-ward is free software: you can redistribute it and/or modify it under the terms
+# of the GNU General Public License as published by the Free Software Foundation, either
+# version 3 of the License, or (at your option) any later version.
+#
+# pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+# without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with pico-ward.
+# If  not, see <https://www.gnu.org/licenses/>.
+
+# Decode binary log frames written by otp_log.c when built with OTP_LOG_BINARY.
+#
+# Usage: otp_log_decode.py pico-ward.bin capture.raw
+#
+# The format string IDs are addresses in XIP flash, they are resolved using the
+# firmware image produced by the build. Bytes outside of frames (e.g. plain
+# printf output) are passed through unchanged.
+
+import re
+import struct
+import sys
+
+FLASH_BASE = 0x10000000
+MARKER = b'\xa5\x5a'
+LEVELS = ['-', 'E', 'W', 'I', 'D']
+CONVERSION = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diouxXcsp%])')
+
+
+def read_string(image, address):
+    offset = address - FLASH_BASE
+    if offset < 0 or offset >= len(image):
+        return None
+    end = image.find(b'\0', offset)
+    return image[offset:end].decode('ascii', 'replace')
+
+
+def format_record(image, format_address, args):
+    fmt = read_string(image, format_address)
+    if fmt is None:
+        return '<unknown format 0x%08x> %s\n' % (format_address, ' '.join('0x%08x' % a for a in args))
+
+    remaining = list(args)
+
+    def convert(match):
+        spec = match.group(0)
+        kind = match.group(1)
+        if kind == '%':
+            return '%'
+        value = remaining.pop(0) if remaining else 0
+        # Python has no length modifiers and treats everything as a long.
+        spec = re.sub(r'(hh|h|ll|l|z)', '', spec)
+        if kind in 'di':
+            value = struct.unpack('<i', struct.pack('<I', value))[0]
+            return (spec[:-1] + 'd') % value
+        if kind == 'u':
+            return (spec[:-1] + 'd') % value
+        if kind == 'c':
+            return (spec[:-1] + 'c') % chr(value & 0xFF)
+        if kind == 's':
+            string = read_string(image, value)
+            return (spec[:-1] + 's') % (string if string is not None else '<0x%08x>' % value)
+        if kind == 'p':
+            return '0x%08x' % value
+        return spec % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(image, capture, out):
+    position = 0
+    while position < len(capture):
+        start = capture.find(MARKER, position)
+        if start < 0:
+            out.write(capture[position:].decode('ascii', 'replace'))
+            break
+        out.write(capture[position:start].decode('ascii', 'replace'))
+
+        header_end = start + 2 + 1 + 8
+        if header_end > len(capture):
+            break
+        level_argc = capture[start + 2]
+        level, argc = level_argc >> 4, level_argc & 0x0F
+        timestamp, format_address = struct.unpack_from('<II', capture, start + 3)
+        frame_end = header_end + 4 * argc
+        if frame_end > len(capture):
+            break
+        args = struct.unpack_from('<%dI' % argc, capture, header_end)
+
+        out.write('[%10u] %s %s' % (timestamp, LEVELS[level] if level < len(LEVELS) else '?',
+                                     format_record(image, format_address, args)))
+        position = frame_end
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('Usage: %s <firmware.bin> <capture>\n' % sys.argv[0])
+        return 1
+
+    with open(sys.argv[1], 'rb') as f:
+        image = f.read()
+    with open(sys.argv[2], 'rb') as f:
+        capture = f.read()
+
+    decode(image, capture, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
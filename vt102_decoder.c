@@ -0,0 +1,324 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "otp_hot_path.h"
+#include "vt102_decoder.h"
+
+enum decoder_state
+{
+    GROUND = 0x00,
+    ESCAPE = 0x01,
+    CSI = 0x02,
+    SS3 = 0x03,
+    UTF8_NEED_1 = 0x04,
+    UTF8_NEED_2 = 0x05,
+    UTF8_NEED_3 = 0x06,
+    PASTE = 0x07,
+    PASTE_ESCAPE = 0x08,
+    PASTE_CSI = 0x09,
+    // Lead bytes whose second byte is restricted, RFC 3629 section 4.
+    UTF8_E0 = 0x0A,     // A0-BF, below is overlong.
+    UTF8_ED = 0x0B,     // 80-9F, above is a surrogate.
+    UTF8_F0 = 0x0C,     // 90-BF, below is overlong.
+    UTF8_F4 = 0x0D,     // 80-8F, above is beyond U+10FFFF.
+    STATE_COUNT
+};
+
+enum decoder_action
+{
+    NONE = 0x00,
+    CHARACTER = 0x01,           // Emit the byte as a character event.
+    CONTROL = 0x02,             // Emit the byte as a control event.
+    CLEAR = 0x03,               // Clear the CSI parameter.
+    PARAMETER = 0x04,           // Accumulate a digit of the CSI parameter.
+    CSI_DISPATCH = 0x05,        // Final byte of a CSI sequence.
+    SS3_DISPATCH = 0x06,        // Final byte of an SS3 sequence.
+    UTF8_BYTE = 0x07,           // Hold a byte of a UTF-8 sequence.
+    UTF8_END = 0x08,            // Final byte of a UTF-8 sequence, emit them all.
+    UTF8_ERROR = 0x09,          // Malformed UTF-8, drop it and decode the byte again from ground.
+    PASTE_CSI_DISPATCH = 0x0A,  // Final byte of a CSI sequence within a paste.
+};
+
+// Each transition is the next state in the low nibble and the action in the high nibble.
+#define T(next, action) (uint8_t)(((action) << 4) | (next))
+
+#define UTF8_CONTINUATION 0x80 ... 0xBF
+
+/*
+ * The state transition table, each row begins with a default covering every
+ * byte which the more specific ranges that follow then override.
+ */
+static const uint8_t transitions[STATE_COUNT][256] OTP_HOT_DATA =
+{
+    [GROUND] =
+    {
+        [0x00 ... 0x1F] = T(GROUND, CONTROL),
+        [0x1B] = T(ESCAPE, NONE),
+        [0x20 ... 0x7E] = T(GROUND, CHARACTER),
+        [0x7F] = T(GROUND, CONTROL),
+        [0x80 ... 0xC1] = T(GROUND, NONE), // Unexpected continuation or overlong lead byte.
+        [0xC2 ... 0xDF] = T(UTF8_NEED_1, UTF8_BYTE),
+        [0xE0] = T(UTF8_E0, UTF8_BYTE),
+        [0xE1 ... 0xEC] = T(UTF8_NEED_2, UTF8_BYTE),
+        [0xED] = T(UTF8_ED, UTF8_BYTE),
+        [0xEE ... 0xEF] = T(UTF8_NEED_2, UTF8_BYTE),
+        [0xF0] = T(UTF8_F0, UTF8_BYTE),
+        [0xF1 ... 0xF3] = T(UTF8_NEED_3, UTF8_BYTE),
+        [0xF4] = T(UTF8_F4, UTF8_BYTE),
+        [0xF5 ... 0xFF] = T(GROUND, NONE),
+    },
+    [ESCAPE] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, NONE), // Alt+key and unsupported sequences are dropped.
+        [0x1B] = T(ESCAPE, NONE),
+        ['['] = T(CSI, CLEAR),
+        ['O'] = T(SS3, NONE),
+    },
+    [CSI] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, NONE),
+        [0x1B] = T(ESCAPE, NONE),
+        [0x20 ... 0x3F] = T(CSI, NONE), // Intermediate and private parameter bytes.
+        ['0' ... '9'] = T(CSI, PARAMETER),
+        [';'] = T(CSI, CLEAR),
+        [0x40 ... 0x7E] = T(GROUND, CSI_DISPATCH),
+    },
+    [SS3] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, NONE),
+        [0x1B] = T(ESCAPE, NONE),
+        [0x40 ... 0x7E] = T(GROUND, SS3_DISPATCH),
+    },
+    [UTF8_NEED_1] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [UTF8_CONTINUATION] = T(GROUND, UTF8_END),
+    },
+    [UTF8_NEED_2] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [UTF8_CONTINUATION] = T(UTF8_NEED_1, UTF8_BYTE),
+    },
+    [UTF8_NEED_3] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [UTF8_CONTINUATION] = T(UTF8_NEED_2, UTF8_BYTE),
+    },
+    [UTF8_E0] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [0xA0 ... 0xBF] = T(UTF8_NEED_1, UTF8_BYTE),
+    },
+    [UTF8_ED] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [0x80 ... 0x9F] = T(UTF8_NEED_1, UTF8_BYTE),
+    },
+    [UTF8_F0] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [0x90 ... 0xBF] = T(UTF8_NEED_2, UTF8_BYTE),
+    },
+    [UTF8_F4] =
+    {
+        [0x00 ... 0xFF] = T(GROUND, UTF8_ERROR),
+        [0x80 ... 0x8F] = T(UTF8_NEED_2, UTF8_BYTE),
+    },
+    [PASTE] =
+    {
+        [0x00 ... 0xFF] = T(PASTE, CHARACTER),
+        [0x1B] = T(PASTE_ESCAPE, NONE),
+    },
+    [PASTE_ESCAPE] =
+    {
+        [0x00 ... 0xFF] = T(PASTE, CHARACTER), // The ESC is dropped.
+        [0x1B] = T(PASTE_ESCAPE, NONE),
+        ['['] = T(PASTE_CSI, CLEAR),
+    },
+    [PASTE_CSI] =
+    {
+        [0x00 ... 0xFF] = T(PASTE, NONE),
+        ['0' ... '9'] = T(PASTE_CSI, PARAMETER),
+        ['~'] = T(PASTE, PASTE_CSI_DISPATCH),
+    },
+};
+
+void vt102_decoder_init(vt102_decoder_t *decoder, vt102_decoder_handler handler, void *handback)
+{
+    decoder->state = GROUND;
+    decoder->parameter = 0;
+    decoder->utf8_length = 0;
+    decoder->handler = handler;
+    decoder->handback = handback;
+}
+
+static void OTP_HOT_PATH(_emit)(vt102_decoder_t *decoder, enum vt102_event_type event_type, uint32_t character)
+{
+    vt102_event event = { .event_type = event_type, .character = character };
+    decoder->handler(&event, decoder->handback);
+}
+
+static void OTP_HOT_PATH(_csi_dispatch)(vt102_decoder_t *decoder, uint8_t final)
+{
+    uint32_t key = 0x00;
+    switch (final)
+    {
+        case 'A': key = VT102_KEY_UP; break;
+        case 'B': key = VT102_KEY_DOWN; break;
+        case 'C': key = VT102_KEY_RIGHT; break;
+        case 'D': key = VT102_KEY_LEFT; break;
+        case 'H': key = VT102_KEY_HOME; break;
+        case 'F': key = VT102_KEY_END; break;
+        case '~':
+            switch (decoder->parameter)
+            {
+                case 1:
+                case 7: key = VT102_KEY_HOME; break;
+                case 2: key = VT102_KEY_INSERT; break;
+                case 3: key = VT102_KEY_DELETE; break;
+                case 4:
+                case 8: key = VT102_KEY_END; break;
+                case 5: key = VT102_KEY_PAGE_UP; break;
+                case 6: key = VT102_KEY_PAGE_DOWN; break;
+                case 11: key = VT102_KEY_F1; break;
+                case 12: key = VT102_KEY_F2; break;
+                case 13: key = VT102_KEY_F3; break;
+                case 14: key = VT102_KEY_F4; break;
+                case 200:
+                    decoder->state = PASTE;
+                    key = VT102_KEY_PASTE_START;
+                    break;
+            }
+            break;
+    }
+
+    if (key != 0x00)
+    {
+        _emit(decoder, special, key);
+    }
+}
+
+static void _ss3_dispatch(vt102_decoder_t *decoder, uint8_t final)
+{
+    uint32_t key = 0x00;
+    switch (final)
+    {
+        case 'A': key = VT102_KEY_UP; break;
+        case 'B': key = VT102_KEY_DOWN; break;
+        case 'C': key = VT102_KEY_RIGHT; break;
+        case 'D': key = VT102_KEY_LEFT; break;
+        case 'H': key = VT102_KEY_HOME; break;
+        case 'F': key = VT102_KEY_END; break;
+        case 'P': key = VT102_KEY_F1; break;
+        case 'Q': key = VT102_KEY_F2; break;
+        case 'R': key = VT102_KEY_F3; break;
+        case 'S': key = VT102_KEY_F4; break;
+    }
+
+    if (key != 0x00)
+    {
+        _emit(decoder, special, key);
+    }
+}
+
+static void OTP_HOT_PATH(_decode_byte)(vt102_decoder_t *decoder, uint8_t byte)
+{
+    uint8_t transition = transitions[decoder->state][byte];
+    decoder->state = transition & 0x0F;
+
+    switch (transition >> 4)
+    {
+        case NONE:
+            break;
+        case CHARACTER:
+            _emit(decoder, character, byte);
+            break;
+        case CONTROL:
+            // Ctrl+key notation, e.g. 0x0D (CR) is Ctrl+M and 0x7F (DEL) is Ctrl+?
+            _emit(decoder, control, byte ^ 0x40);
+            break;
+        case CLEAR:
+            decoder->parameter = 0;
+            break;
+        case PARAMETER:
+            if (decoder->parameter < 1000)
+            {
+                decoder->parameter = decoder->parameter * 10 + (byte - '0');
+            }
+            break;
+        case CSI_DISPATCH:
+            _csi_dispatch(decoder, byte);
+            break;
+        case SS3_DISPATCH:
+            _ss3_dispatch(decoder, byte);
+            break;
+        case UTF8_BYTE:
+            decoder->utf8[decoder->utf8_length++] = byte;
+            break;
+        case UTF8_END:
+            for (uint8_t i = 0; i < decoder->utf8_length; i++)
+            {
+                _emit(decoder, character, decoder->utf8[i]);
+            }
+            _emit(decoder, character, byte);
+            decoder->utf8_length = 0;
+            break;
+        case UTF8_ERROR:
+            // The state is now ground, the byte may start something new.
+            decoder->utf8_length = 0;
+            _decode_byte(decoder, byte);
+            break;
+        case PASTE_CSI_DISPATCH:
+            if (decoder->parameter == 201)
+            {
+                decoder->state = GROUND;
+                _emit(decoder, special, VT102_KEY_PASTE_END);
+            }
+            break;
+    }
+}
+
+void OTP_HOT_PATH(vt102_decoder_decode)(vt102_decoder_t *decoder, const uint8_t *data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        _decode_byte(decoder, data[i]);
+    }
+}
+
+const char* vt102_key_to_string(uint32_t key)
+{
+    switch (key)
+    {
+        case VT102_KEY_UP: return "Up";
+        case VT102_KEY_DOWN: return "Down";
+        case VT102_KEY_RIGHT: return "Right";
+        case VT102_KEY_LEFT: return "Left";
+        case VT102_KEY_HOME: return "Home";
+        case VT102_KEY_END: return "End";
+        case VT102_KEY_INSERT: return "Insert";
+        case VT102_KEY_DELETE: return "Delete";
+        case VT102_KEY_PAGE_UP: return "Page Up";
+        case VT102_KEY_PAGE_DOWN: return "Page Down";
+        case VT102_KEY_F1: return "F1";
+        case VT102_KEY_F2: return "F2";
+        case VT102_KEY_F3: return "F3";
+        case VT102_KEY_F4: return "F4";
+        case VT102_KEY_PASTE_START: return "Paste Start";
+        case VT102_KEY_PASTE_END: return "Paste End";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,97 @@
+/* Copyright 2025, Darran A Lofthouse
+ *
+ * This file is part of pico-ward.
+ *
+ * pico-ward is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * pico-ward is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with pico-ward.
+ * If  not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * A table driven decoder converting the bytes received from a VT102 terminal
+ * into vt102_events.
+ *
+ * Every byte is decoded with a single lookup into a constant state transition
+ * table giving the next state and an action, the table covers all 256 byte
+ * values in every state so any input is handled.
+ *
+ * Supports:
+ *  - Printable characters and C0 controls (as Ctrl+key control events).
+ *  - CSI and SS3 cursor / editing / function key sequences as special events.
+ *  - Bracketed paste, within a paste every byte including controls is passed
+ *    through as a character event.
+ *  - UTF-8, well formed multi-byte sequences are passed through a byte at a
+ *    time as character events. Malformed sequences are dropped including
+ *    overlong forms, surrogates and code points above U+10FFFF.
+ *
+ * tools/host builds the decoder for the host with a benchmark and a libFuzzer
+ * target.
+ */
+
+#ifndef VT102_DECODER_H
+#define VT102_DECODER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "term/vt102.h"
+
+/*
+ * The values passed as the character of special events.
+ */
+enum vt102_key
+{
+    VT102_KEY_UP = 0x01,
+    VT102_KEY_DOWN = 0x02,
+    VT102_KEY_RIGHT = 0x03,
+    VT102_KEY_LEFT = 0x04,
+    VT102_KEY_HOME = 0x05,
+    VT102_KEY_END = 0x06,
+    VT102_KEY_INSERT = 0x07,
+    VT102_KEY_DELETE = 0x08,
+    VT102_KEY_PAGE_UP = 0x09,
+    VT102_KEY_PAGE_DOWN = 0x0A,
+    VT102_KEY_F1 = 0x0B,
+    VT102_KEY_F2 = 0x0C,
+    VT102_KEY_F3 = 0x0D,
+    VT102_KEY_F4 = 0x0E,
+    VT102_KEY_PASTE_START = 0x0F,
+    VT102_KEY_PASTE_END = 0x10,
+};
+
+/*
+ * Sent to the terminal to enable bracketed paste.
+ */
+#define VT102_ENABLE_BRACKETED_PASTE "\x1b[?2004h"
+
+typedef void (*vt102_decoder_handler)(vt102_event *event, void *handback);
+
+struct vt102_decoder
+{
+    uint8_t state;
+    uint16_t parameter; // The last numeric parameter of a CSI sequence.
+    uint8_t utf8[4];    // A UTF-8 sequence held until complete.
+    uint8_t utf8_length;
+    vt102_decoder_handler handler;
+    void *handback;
+};
+
+typedef struct vt102_decoder vt102_decoder_t;
+
+void vt102_decoder_init(vt102_decoder_t *decoder, vt102_decoder_handler handler, void *handback);
+
+/*
+ * Decode the bytes calling the handler for each complete event.
+ */
+void vt102_decoder_decode(vt102_decoder_t *decoder, const uint8_t *data, uint32_t length);
+
+const char* vt102_key_to_string(uint32_t key);
+
+#endif // VT102_DECODER_H